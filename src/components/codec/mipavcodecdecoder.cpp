@@ -233,7 +233,7 @@ bool MIPAVCodecDecoder::push(const MIPComponentChain &chain, int64_t iteration,
 
 		sws_scale(pSwsContext, m_pFrame->data, m_pFrame->linesize, 0, height, pDstPointers, dstStrides);
 	
-		MIPRawYUV420PVideoMessage *pNewMsg = new MIPRawYUV420PVideoMessage(width, height, pData, true);
+		MIPRawYUV420PVideoMessage *pNewMsg = new MIPRawYUV420PVideoMessage(width, height, MIPSharedBuffer<uint8_t>::create(pData, dataSize));
 
 		pNewMsg->setSourceID(sourceID);
 		pNewMsg->setTime(pEncMsg->getTime());
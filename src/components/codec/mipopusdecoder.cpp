@@ -82,6 +82,7 @@ bool MIPOpusDecoder::init(int outputSamplingRate, int channels, bool useFloat)
 	m_outputSamplingRate = outputSamplingRate;
 	m_outputChannels = channels;
 	m_useFloat = useFloat;
+	m_pFloatPool = (useFloat)?MIPSharedBufferPool<float>::create():0;
 
 	MIPOutputMessageQueueWithState::init(60.0);
 
@@ -98,6 +99,8 @@ bool MIPOpusDecoder::destroy()
 	}
 
 	MIPOutputMessageQueueWithState::clear();
+	if (m_pFloatPool)
+		m_pFloatPool->release();
 
 	m_init = false;
 
@@ -173,17 +176,17 @@ bool MIPOpusDecoder::push(const MIPComponentChain &chain, int64_t iteration, MIP
 	}
 	else
 	{
-		float *pFrames = new float[maxFrameSize*m_outputChannels];
+		MIPSharedBuffer<float> *pBuffer = m_pFloatPool->getBuffer(maxFrameSize*m_outputChannels);
 		
-		int numFrames = opus_decode_float(pDecoder, pData, dataLength, pFrames, maxFrameSize, 0);
+		int numFrames = opus_decode_float(pDecoder, pData, dataLength, pBuffer->getData(), maxFrameSize, 0);
 		if (numFrames < 0)
 		{
 			// silently ignore decoding errors
-			delete [] pFrames;
+			pBuffer->release();
 			return true; 
 		}
 		
-		pNewMsg = new MIPRawFloatAudioMessage(m_outputSamplingRate, m_outputChannels, numFrames, pFrames, true);
+		pNewMsg = new MIPRawFloatAudioMessage(m_outputSamplingRate, m_outputChannels, numFrames, pBuffer);
 	}
 
 	pNewMsg->copyMediaInfoFrom(*pEncMsg); // copy source ID and message time
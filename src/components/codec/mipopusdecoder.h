@@ -36,6 +36,7 @@
 
 #include "mipoutputmessagequeuewithstate.h"
 #include "miptime.h"
+#include "mipsharedbuffer.h"
 
 class MIPAudioMessage;
 
@@ -81,6 +82,7 @@ private:
 	int m_outputSamplingRate;
 	int m_outputChannels;
 	bool m_useFloat;
+	MIPSharedBufferPool<float> *m_pFloatPool;
 };	
 
 #endif // MIPCONFIG_SUPPORT_OPUS
@@ -209,7 +209,7 @@ bool MIPSpeexDecoder::push(const MIPComponentChain &chain, int64_t iteration, MI
 		for (int i = 0 ; i < numFrames ; i++)
 			pFrames[i] /= (float)32767.0;
 		
-		MIPRawFloatAudioMessage *pNewMsg = new MIPRawFloatAudioMessage(sampRate, 1, numFrames, pFrames, true);
+		MIPRawFloatAudioMessage *pNewMsg = new MIPRawFloatAudioMessage(sampRate, 1, numFrames, MIPSharedBuffer<float>::create(pFrames, numFrames));
 		pNewMsg->copyMediaInfoFrom(*pEncMsg); // copy source ID and message time
 		m_messages.push_back(pNewMsg);
 		m_msgIt = m_messages.begin();
@@ -153,7 +153,7 @@ bool MIPTinyJPEGDecoder::push(const MIPComponentChain &chain, int64_t iteration,
 	tinyjpeg_set_components(pDec, pPlanes, 3);
 	tinyjpeg_free(pDec);
 
-	MIPRawYUV420PVideoMessage *pVideoMsg = new MIPRawYUV420PVideoMessage((int)width, (int)height, pImageBuffer, true);
+	MIPRawYUV420PVideoMessage *pVideoMsg = new MIPRawYUV420PVideoMessage((int)width, (int)height, MIPSharedBuffer<uint8_t>::create(pImageBuffer, allocSize));
 
 	pVideoMsg->copyMediaInfoFrom(*pEncMsg); // copy time and sourceID
 	m_messages.push_back(pVideoMsg);
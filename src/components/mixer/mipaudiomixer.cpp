@@ -27,6 +27,10 @@
 #include "miprawaudiomessage.h"
 #include "mipsystemmessage.h"
 #include "mipfeedback.h"
+#include "mipmixkernels.h"
+#include "mipsourcefilter.h"
+#include <algorithm>
+#include <cmath>
 
 //#include <iostream> 
 
@@ -41,18 +45,25 @@
 #define MIPAUDIOMIXER_ERRSTR_DELAYTOOLARGE			"The specified extra delay is too large"
 #define MIPAUDIOMIXER_ERRSTR_TIMINGINFOISNOTUSED		"Timing information is not being used, so the extra delay will not have any effect"
 #define MIPAUDIOMIXER_ERRSTR_NEGATIVEDELAY			"Only positive delays are allowed"
+#define MIPAUDIOMIXER_ERRSTR_NEGATIVESPEAKERCOUNT		"The maximum number of active speakers can't be negative"
+#define MIPAUDIOMIXER_ERRSTR_NEGATIVEHANGOVER			"The hangover time can't be negative"
+
+// The source ID of the complete mix, for which no mix-minus output can be made
+#define MIPAUDIOMIXER_MAINMIXSOURCEID				0
 
 MIPAudioMixer::MIPAudioMixer() : MIPComponent("MIPAudioMixer"), m_blockTime(0), m_playTime(0)
 {
 	m_init = false;
+	m_pSourceFilter = 0;
 }
 
 MIPAudioMixer::~MIPAudioMixer()
 {
+	setSourceFilter(0);
 	destroy();
 }
 
-bool MIPAudioMixer::init(int sampRate, int channels, MIPTime blockTime, bool useTimeInfo, bool floatSamples)
+bool MIPAudioMixer::init(int sampRate, int channels, MIPTime blockTime, bool useTimeInfo, bool floatSamples, MIPTime bufferTime, bool softClipping, bool mixMinus)
 {
 	if (m_init)
 	{
@@ -69,30 +80,65 @@ bool MIPAudioMixer::init(int sampRate, int channels, MIPTime blockTime, bool use
 	m_curInterval = 0;
 	m_useTimeInfo = useTimeInfo;
 	m_floatSamples = floatSamples;
+	m_softClipping = (floatSamples)?false:softClipping;
+	m_mixMinus = mixMinus;
+	// Subtracting a source from a saturated sum wouldn't be correct, so for mix-minus
+	// outputs 16 bit samples are accumulated in 32 bit as well
+	m_accumulate32 = (floatSamples)?false:(softClipping || mixMinus);
+	if (floatSamples)
+		m_blockBytes = m_blockSize*sizeof(float);
+	else
+		m_blockBytes = m_blockSize*((m_accumulate32)?sizeof(int32_t):sizeof(int16_t));
+
+	// One extra block for the one that's being played
+	size_t numBlocks = (size_t)(bufferTime.getValue()/blockTime.getValue()+0.5) + 1;
+
+	m_ringCapacity = 2;
+	while (m_ringCapacity < numBlocks)
+		m_ringCapacity <<= 1;
+	m_ringMask = m_ringCapacity-1;
+	m_pRing = new uint8_t [m_ringCapacity*m_blockBytes];
+	memset(m_pRing, 0, m_ringCapacity*m_blockBytes);
+	m_pRetiredRing = 0;
+	m_ringIntervals.assign(m_ringCapacity, -1);
+	m_playSlot = -1;
 
 	if (floatSamples)
 	{
-		m_pSilenceFramesFloat = new float [m_blockSize];
-		for (size_t i = 0 ; i < m_blockSize ; i++)
-			m_pSilenceFramesFloat[i] = 0;
-		
-		m_pMsgFloat = new MIPRawFloatAudioMessage(sampRate, channels, (int)m_blockFrames, m_pSilenceFramesFloat, false);
+		m_pMsgFloat = new MIPRawFloatAudioMessage(sampRate, channels, (int)m_blockFrames, (float *)m_pRing, false);
 		m_pMsgInt = 0;
-		m_pSilenceFramesInt = 0;
+		m_pClippedSamples = 0;
+	}
+	else if (m_accumulate32)
+	{
+		// The accumulated samples are converted into this buffer when a block is played
+		m_pClippedSamples = new int16_t [m_blockSize];
+		memset(m_pClippedSamples, 0, m_blockSize*sizeof(int16_t));
+		m_pMsgInt = new MIPRaw16bitAudioMessage(sampRate, channels, (int)m_blockFrames, true, MIPRaw16bitAudioMessage::Native, (uint16_t *)m_pClippedSamples, false);
+		m_pMsgFloat = 0;
 	}
 	else
 	{
-		m_pSilenceFramesInt = new uint16_t [m_blockSize];
-		for (size_t i = 0 ; i < m_blockSize ; i++)
-			m_pSilenceFramesInt[i] = 0;
-		
-		m_pMsgInt = new MIPRaw16bitAudioMessage(sampRate, channels, (int)m_blockFrames, true, MIPRaw16bitAudioMessage::Native, m_pSilenceFramesInt, false);
+		m_pMsgInt = new MIPRaw16bitAudioMessage(sampRate, channels, (int)m_blockFrames, true, MIPRaw16bitAudioMessage::Native, (uint16_t *)m_pRing, false);
 		m_pMsgFloat = 0;
-		m_pSilenceFramesFloat = 0;
+		m_pClippedSamples = 0;
 	}
-	
-	m_pBlockFramesFloat = 0;
-	m_pBlockFramesInt = 0;
+
+	if (m_accumulate32 && m_mixMinus)
+		m_pMixMinusSamples = new int32_t [m_blockSize];
+	else
+		m_pMixMinusSamples = 0;
+	m_outputMessages.clear();
+	m_outputPos = 0;
+
+	m_maxSpeakers = 0;
+	m_numActiveSpeakers = 0;
+	m_speakerThreshold = 0;
+	m_hangoverIntervals = 0;
+	m_speakers.clear();
+	m_activeSpeakersMutex.lock();
+	m_activeSpeakers.clear();
+	m_activeSpeakersMutex.unlock();
 	
 	m_extraDelay = MIPTime(0);	
 	
@@ -110,19 +156,17 @@ bool MIPAudioMixer::destroy()
 		return false;
 	}
 
-	clearAudioBlocks();
 	if (m_pMsgFloat)
 		delete m_pMsgFloat;
-	if (m_pBlockFramesFloat)
-		delete [] m_pBlockFramesFloat;
-	if (m_pSilenceFramesFloat)
-		delete [] m_pSilenceFramesFloat;
 	if (m_pMsgInt)
 		delete m_pMsgInt;
-	if (m_pBlockFramesInt)
-		delete [] m_pBlockFramesInt;
-	if (m_pSilenceFramesInt)
-		delete [] m_pSilenceFramesInt;
+	if (m_pClippedSamples)
+		delete [] m_pClippedSamples;
+	if (m_pMixMinusSamples)
+		delete [] m_pMixMinusSamples;
+	clearRing();
+	m_outputMessages.clear();
+	m_speakers.clear();
 
 	m_init = false;
 	
@@ -142,7 +186,10 @@ bool MIPAudioMixer::push(const MIPComponentChain &chain, int64_t iteration, MIPM
 	if (pMsg->getMessageType() == MIPMESSAGE_TYPE_SYSTEM && pMsg->getMessageSubtype() == MIPSYSTEMMESSAGE_TYPE_ISTIME) // just ignore this
 		return true;
 	
-	if (!(pMsg->getMessageType() == MIPMESSAGE_TYPE_AUDIO_RAW && ((pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_FLOAT && m_floatSamples) || (!m_floatSamples && pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_S16 ) )))
+	// When the chain verified the connections, only the audio format remains
+	bool verified = isInputVerified(chain);
+
+	if (!verified && !(pMsg->getMessageType() == MIPMESSAGE_TYPE_AUDIO_RAW && ((pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_FLOAT && m_floatSamples) || (!m_floatSamples && pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_S16 ) )))
 	{
 		setErrorString(MIPAUDIOMIXER_ERRSTR_BADMESSAGE);
 		return false;
@@ -157,18 +204,29 @@ bool MIPAudioMixer::push(const MIPComponentChain &chain, int64_t iteration, MIPM
 		return true;
 	}
 
-	if (pAudioMsg->getSamplingRate() != m_sampRate)
+	if (!verified)
 	{
-		setErrorString(MIPAUDIOMIXER_ERRSTR_INCOMPATIBLESAMPRATE);
-		return false;
+		if (pAudioMsg->getSamplingRate() != m_sampRate)
+		{
+			setErrorString(MIPAUDIOMIXER_ERRSTR_INCOMPATIBLESAMPRATE);
+			return false;
+		}
+		if (pAudioMsg->getNumberOfChannels() != m_channels)
+		{
+			setErrorString(MIPAUDIOMIXER_ERRSTR_INCOMPATIBLECHANNELS);
+			return false;
+		}
 	}
-	if (pAudioMsg->getNumberOfChannels() != m_channels)
+
+	if (m_maxSpeakers > 0 && !isActiveSpeaker(sourceID, pAudioMsg))
 	{
-		setErrorString(MIPAUDIOMIXER_ERRSTR_INCOMPATIBLECHANNELS);
-		return false;
+		// Not mixed, but a mix-minus output is still needed for this participant
+		if (m_mixMinus && sourceID != MIPAUDIOMIXER_MAINMIXSOURCEID)
+			getMixMinusSource(sourceID);
+		return true;
 	}
 
-	real_t block = 0;
+	int64_t offsetNanoSeconds = 0;
 
 	if (m_useTimeInfo)
 	{
@@ -191,38 +249,39 @@ bool MIPAudioMixer::push(const MIPComponentChain &chain, int64_t iteration, MIPM
 
 		offsetTime += m_extraDelay;
 		
-		block = offsetTime.getValue()/m_blockTime.getValue();
+		offsetNanoSeconds = offsetTime.getNanoSeconds();
 	}
 	else
-		block = m_extraDelay.getValue()/m_blockTime.getValue();
+		offsetNanoSeconds = m_extraDelay.getNanoSeconds();
 	
-	// Data is ok, process it
+	// Data is ok, process it. The position is calculated in integer nanoseconds, 
+	// so no rounding errors can build up
 
-	int64_t blockOffset = (int64_t)block;
+	int64_t blockNanoSeconds = m_blockTime.getNanoSeconds();
+	int64_t blockOffset = offsetNanoSeconds/blockNanoSeconds;
 	int64_t intervalNumber = blockOffset + m_curInterval;
-	real_t blockFraction = block - (real_t)blockOffset;
-	size_t frameOffset = (size_t)((blockFraction * (real_t)m_blockFrames) + 0.5);
+	int64_t remainder = offsetNanoSeconds - blockOffset*blockNanoSeconds;
+	size_t frameOffset = (size_t)((remainder*(int64_t)m_blockFrames + blockNanoSeconds/2)/blockNanoSeconds);
 	size_t sampleOffset = frameOffset * m_channels;
 	size_t numSamplesLeft = (size_t)(pAudioMsg->getNumberOfFrames())*m_channels;
 	size_t samplePos = 0;
+	MixMinusSource *pSource = (m_mixMinus && sourceID != MIPAUDIOMIXER_MAINMIXSOURCEID)?getMixMinusSource(sourceID):0;
 
 	if (m_floatSamples)
 	{
 		MIPRawFloatAudioMessage *pFloatAudioMsg = (MIPRawFloatAudioMessage *)pMsg;
 		const float *pSamples = pFloatAudioMsg->getFrames();
 	
-		initBlockSearch();
 		while (numSamplesLeft != 0)
 		{
-			MIPAudioMixerBlock block = searchBlock(intervalNumber);
-			float *blockSamples = block.getFramesFloat();
+			float *blockSamples = (float *)getBlock(intervalNumber);
 			
 			size_t num = (numSamplesLeft > (m_blockSize-sampleOffset))?(m_blockSize-sampleOffset):numSamplesLeft;
-			size_t i,j,k;
 			
 			// add samples to the block
-			for (i = 0, j = sampleOffset, k = samplePos ; i < num ; i++, j++, k++)
-				blockSamples[j] += pSamples[k];
+			MIPMixKernels::addFloat(blockSamples + sampleOffset, pSamples + samplePos, num);
+			if (pSource)
+				MIPMixKernels::addFloat((float *)getBlock(pSource, intervalNumber) + sampleOffset, pSamples + samplePos, num);
 			
 			sampleOffset = 0;
 			samplePos += num;
@@ -235,18 +294,21 @@ bool MIPAudioMixer::push(const MIPComponentChain &chain, int64_t iteration, MIPM
 		MIPRaw16bitAudioMessage *pIntAudioMsg = (MIPRaw16bitAudioMessage *)pMsg;
 		const int16_t *pSamples = (const int16_t *)pIntAudioMsg->getFrames();
 	
-		initBlockSearch();
 		while (numSamplesLeft != 0)
 		{
-			MIPAudioMixerBlock block = searchBlock(intervalNumber);
-			int16_t *blockSamples = (int16_t *)block.getFramesInt();
+			uint8_t *pBlock = getBlock(intervalNumber);
 			
 			size_t num = (numSamplesLeft > (m_blockSize-sampleOffset))?(m_blockSize-sampleOffset):numSamplesLeft;
-			size_t i,j,k;
 			
 			// add samples to the block
-			for (i = 0, j = sampleOffset, k = samplePos ; i < num ; i++, j++, k++)
-				blockSamples[j] += pSamples[k];
+			if (m_accumulate32)
+			{
+				MIPMixKernels::addS16To32((int32_t *)pBlock + sampleOffset, pSamples + samplePos, num);
+				if (pSource)
+					MIPMixKernels::addS16To32((int32_t *)getBlock(pSource, intervalNumber) + sampleOffset, pSamples + samplePos, num);
+			}
+			else
+				MIPMixKernels::addS16Saturated((int16_t *)pBlock + sampleOffset, pSamples + samplePos, num);
 			
 			sampleOffset = 0;
 			samplePos += num;
@@ -268,239 +330,426 @@ bool MIPAudioMixer::pull(const MIPComponentChain &chain, int64_t iteration, MIPM
 		return false;
 	}
 
-	if (m_floatSamples)
+	if (m_prevIteration != iteration)
 	{
-		if (m_prevIteration != 	iteration)
-		{
-			m_prevIteration = iteration;
-			
-			// delete old frames
-			if (m_pBlockFramesFloat)
-				delete [] m_pBlockFramesFloat;
-			m_pBlockFramesFloat = 0;
-			
-			if (m_audioBlocks.empty())
-				m_pMsgFloat->setFrames(m_pSilenceFramesFloat,false);
-			else
-			{
-				MIPAudioMixerBlock block = *(m_audioBlocks.begin());
-	
-				if (block.getInterval() == m_curInterval)
-				{
-					m_audioBlocks.pop_front();
-					m_pBlockFramesFloat = block.getFramesFloat();
-					m_pMsgFloat->setFrames(m_pBlockFramesFloat,false);
-				}
-				else
-					m_pMsgFloat->setFrames(m_pSilenceFramesFloat,false);
-			}
-			
-			m_gotMessage = false;
-			m_curInterval++;
-			m_playTime += m_blockTime;
-		}
-		
-		if (m_gotMessage)
+		m_prevIteration = iteration;
+
+		if (m_maxSpeakers > 0)
+			updateActiveSpeakers();
+
+		// The previous block can be reused now; only blocks that received audio 
+		// need to be cleared
+		if (m_playSlot >= 0 && m_ringIntervals[m_playSlot] >= 0)
 		{
-			m_gotMessage = false;
-			*pMsg = 0;
+			memset(m_pRing + (size_t)m_playSlot*m_blockBytes, 0, m_blockBytes);
+			m_ringIntervals[m_playSlot] = -1;
 		}
-		else
+		if (m_pRetiredRing)
 		{
-			m_gotMessage = true;
-			*pMsg = m_pMsgFloat;
+			delete [] m_pRetiredRing;
+			m_pRetiredRing = 0;
 		}
-	}
-	else // 16 bit signed
-	{
-		if (m_prevIteration != 	iteration)
 		{
-			m_prevIteration = iteration;
-			
-			// delete old frames
-			if (m_pBlockFramesInt)
-				delete [] m_pBlockFramesInt;
-			m_pBlockFramesInt = 0;
-			
-			if (m_audioBlocks.empty())
-				m_pMsgInt->setFrames(true, MIPRaw16bitAudioMessage::Native, m_pSilenceFramesInt,false);
-			else
+			// Sources can be removed by the application while the chain is running
+			std::lock_guard<std::mutex> guard(m_mixMinusRemoveMutex);
+
+			for (auto id : m_mixMinusSourcesToRemove)
 			{
-				MIPAudioMixerBlock block = *(m_audioBlocks.begin());
-	
-				if (block.getInterval() == m_curInterval)
+				auto it = m_mixMinusSources.find(id);
+
+				if (it != m_mixMinusSources.end())
 				{
-					m_audioBlocks.pop_front();
-					m_pBlockFramesInt = block.getFramesInt();
-					m_pMsgInt->setFrames(true, MIPRaw16bitAudioMessage::Native, m_pBlockFramesInt,false);
+					deleteMixMinusSource(it->second);
+					m_mixMinusSources.erase(it);
 				}
-				else
-					m_pMsgInt->setFrames(true, MIPRaw16bitAudioMessage::Native, m_pSilenceFramesInt,false);
 			}
-			
-			m_gotMessage = false;
-			m_curInterval++;
-			m_playTime += m_blockTime;
-		}
-		
-		if (m_gotMessage)
-		{
-			m_gotMessage = false;
-			*pMsg = 0;
+			m_mixMinusSourcesToRemove.clear();
 		}
+
+		// An unused block is silent, so it can be played as well
+		m_playSlot = (int64_t)(m_curInterval & (int64_t)m_ringMask);
+
+		uint8_t *pBlock = m_pRing + (size_t)m_playSlot*m_blockBytes;
+
+		if (m_floatSamples)
+			m_pMsgFloat->setFrames((float *)pBlock, false);
+		else if (m_softClipping)
+			MIPMixKernels::softClip32To16(m_pClippedSamples, (const int32_t *)pBlock, m_blockSize);
+		else if (m_accumulate32)
+			MIPMixKernels::saturate32To16(m_pClippedSamples, (const int32_t *)pBlock, m_blockSize);
 		else
+			m_pMsgInt->setFrames(true, MIPRaw16bitAudioMessage::Native, (uint16_t *)pBlock, false);
+
+		m_outputMessages.clear();
+		if (m_floatSamples)
+			m_outputMessages.push_back(m_pMsgFloat);
+		else
+			m_outputMessages.push_back(m_pMsgInt);
+
+		for (auto &source : m_mixMinusSources)
 		{
-			m_gotMessage = true;
-			*pMsg = m_pMsgInt;
+			createMixMinusOutput(source.second, pBlock);
+			if (m_floatSamples)
+				m_outputMessages.push_back(source.second->m_pMsgFloat);
+			else
+				m_outputMessages.push_back(source.second->m_pMsgInt);
 		}
+
+		m_outputPos = 0;
+		m_curInterval++;
+		m_playTime += m_blockTime;
+	}
+	
+	if (m_outputPos < m_outputMessages.size())
+		*pMsg = m_outputMessages[m_outputPos++];
+	else
+	{
+		m_outputPos = 0;
+		*pMsg = 0;
 	}
 	//std::cout << "I " << iteration << " MIPAudioMixer::pull leaving " << m_playTime.getValue() << std::endl;
 
 	return true;
 }
 
-void MIPAudioMixer::clearAudioBlocks()
+uint8_t *MIPAudioMixer::getBlock(int64_t intervalNumber)
 {
-	std::list<MIPAudioMixerBlock>::iterator it;
+	// Only m_ringCapacity-1 intervals starting from the current one fit, the
+	// remaining block is the one that's being played
+	if (intervalNumber - m_curInterval >= (int64_t)m_ringMask)
+		growRing(intervalNumber);
+
+	size_t slot = (size_t)(intervalNumber & (int64_t)m_ringMask);
 
-	for (it = m_audioBlocks.begin() ; it != m_audioBlocks.end() ; it++)
+	m_ringIntervals[slot] = intervalNumber;
+	return m_pRing + slot*m_blockBytes;
+}
+
+uint8_t *MIPAudioMixer::getBlock(MixMinusSource *pSource, int64_t intervalNumber)
+{
+	// The main ring has already been enlarged if necessary
+	size_t slot = (size_t)(intervalNumber & (int64_t)m_ringMask);
+
+	pSource->m_ringIntervals[slot] = intervalNumber;
+	return pSource->m_pRing + slot*m_blockBytes;
+}
+
+void MIPAudioMixer::growRing(int64_t intervalNumber)
+{
+	size_t newCapacity = m_ringCapacity;
+
+	while (intervalNumber - m_curInterval >= (int64_t)(newCapacity-1))
+		newCapacity <<= 1;
+
+	size_t newMask = newCapacity-1;
+	uint8_t *pNewRing = new uint8_t [newCapacity*m_blockBytes];
+	std::vector<int64_t> newIntervals(newCapacity, -1);
+
+	memset(pNewRing, 0, newCapacity*m_blockBytes);
+	moveBlocks(m_pRing, m_ringIntervals, pNewRing, newIntervals, newMask);
+
+	// Nothing refers to the contributions of the sources, so these can be replaced immediately
+	for (auto &source : m_mixMinusSources)
 	{
-		if ((*it).getFramesFloat())
-			delete [] (*it).getFramesFloat();
-		if ((*it).getFramesInt())
-			delete [] (*it).getFramesInt();
+		MixMinusSource *pSource = source.second;
+		uint8_t *pNewSourceRing = new uint8_t [newCapacity*m_blockBytes];
+		std::vector<int64_t> newSourceIntervals(newCapacity, -1);
+
+		memset(pNewSourceRing, 0, newCapacity*m_blockBytes);
+		moveBlocks(pSource->m_pRing, pSource->m_ringIntervals, pNewSourceRing, newSourceIntervals, newMask);
+		delete [] pSource->m_pRing;
+		pSource->m_pRing = pNewSourceRing;
+		pSource->m_ringIntervals.swap(newSourceIntervals);
 	}
-	m_audioBlocks.clear();
+
+	// The output message may still refer to the old array until the next pull; if
+	// the array was already replaced since then, that one's the one to keep
+	if (m_pRetiredRing)
+		delete [] m_pRing;
+	else
+		m_pRetiredRing = m_pRing;
+
+	m_pRing = pNewRing;
+	m_ringIntervals.swap(newIntervals);
+	m_ringCapacity = newCapacity;
+	m_ringMask = newMask;
+	m_playSlot = -1;
 }
 
-void MIPAudioMixer::initBlockSearch()
+void MIPAudioMixer::moveBlocks(const uint8_t *pOldRing, const std::vector<int64_t> &oldIntervals, uint8_t *pNewRing,
+                               std::vector<int64_t> &newIntervals, size_t newMask)
 {
-	m_it = m_audioBlocks.begin();
+	// Move the future blocks, the one that's being played stays where it is
+	for (size_t i = 0 ; i < oldIntervals.size() ; i++)
+	{
+		int64_t interval = oldIntervals[i];
+
+		if (interval < m_curInterval)
+			continue;
+
+		size_t newSlot = (size_t)(interval & (int64_t)newMask);
+
+		memcpy(pNewRing + newSlot*m_blockBytes, pOldRing + i*m_blockBytes, m_blockBytes);
+		newIntervals[newSlot] = interval;
+	}
 }
 
-MIPAudioMixer::MIPAudioMixerBlock MIPAudioMixer::searchBlock(int64_t intervalNumber)
+void MIPAudioMixer::clearRing()
 {
-	if (m_it == m_audioBlocks.end())
+	for (auto &source : m_mixMinusSources)
+		deleteMixMinusSource(source.second);
+	m_mixMinusSources.clear();
+	m_mixMinusRemoveMutex.lock();
+	m_mixMinusSourcesToRemove.clear();
+	m_mixMinusRemoveMutex.unlock();
+
+	delete [] m_pRing;
+	if (m_pRetiredRing)
+		delete [] m_pRetiredRing;
+	m_pRing = 0;
+	m_pRetiredRing = 0;
+	m_ringIntervals.clear();
+}
+
+MIPAudioMixer::MixMinusSource *MIPAudioMixer::getMixMinusSource(uint64_t sourceID)
+{
+	auto it = m_mixMinusSources.find(sourceID);
+
+	if (it != m_mixMinusSources.end())
+		return it->second;
+
+	MixMinusSource *pSource = new MixMinusSource();
+	size_t sampleBytes = (m_floatSamples)?sizeof(float):sizeof(int16_t);
+
+	pSource->m_pRing = new uint8_t [m_ringCapacity*m_blockBytes];
+	memset(pSource->m_pRing, 0, m_ringCapacity*m_blockBytes);
+	pSource->m_ringIntervals.assign(m_ringCapacity, -1);
+	pSource->m_pOutput = new uint8_t [m_blockSize*sampleBytes];
+	memset(pSource->m_pOutput, 0, m_blockSize*sampleBytes);
+
+	if (m_floatSamples)
 	{
-		if (m_floatSamples)
+		pSource->m_pMsgFloat = new MIPRawFloatAudioMessage(m_sampRate, m_channels, (int)m_blockFrames, (float *)pSource->m_pOutput, false);
+		pSource->m_pMsgFloat->setSourceID(sourceID);
+		pSource->m_pMsgInt = 0;
+	}
+	else
+	{
+		pSource->m_pMsgInt = new MIPRaw16bitAudioMessage(m_sampRate, m_channels, (int)m_blockFrames, true, MIPRaw16bitAudioMessage::Native, (uint16_t *)pSource->m_pOutput, false);
+		pSource->m_pMsgInt->setSourceID(sourceID);
+		pSource->m_pMsgFloat = 0;
+	}
+
+	m_mixMinusSources[sourceID] = pSource;
+	return pSource;
+}
+
+void MIPAudioMixer::deleteMixMinusSource(MixMinusSource *pSource)
+{
+	if (pSource->m_pMsgFloat)
+		delete pSource->m_pMsgFloat;
+	if (pSource->m_pMsgInt)
+		delete pSource->m_pMsgInt;
+	delete [] pSource->m_pOutput;
+	delete [] pSource->m_pRing;
+	delete pSource;
+}
+
+void MIPAudioMixer::createMixMinusOutput(MixMinusSource *pSource, const uint8_t *pBlock)
+{
+	size_t slot = (size_t)m_playSlot;
+	uint8_t *pOwnBlock = pSource->m_pRing + slot*m_blockBytes;
+	bool contributed = (pSource->m_ringIntervals[slot] == m_curInterval);
+
+	if (m_floatSamples)
+	{
+		if (contributed)
+			MIPMixKernels::subtractFloat((float *)pSource->m_pOutput, (const float *)pBlock, (const float *)pOwnBlock, m_blockSize);
+		else
+			memcpy(pSource->m_pOutput, pBlock, m_blockBytes);
+	}
+	else
+	{
+		if (contributed)
 		{
-			float *pNewFrames = new float [m_blockSize];
-			
-			memcpy(pNewFrames, m_pSilenceFramesFloat, sizeof(float)*m_blockSize);
-			MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-			m_audioBlocks.push_back(block);
-			m_it = m_audioBlocks.end();
-			return block;
+			MIPMixKernels::subtract32(m_pMixMinusSamples, (const int32_t *)pBlock, (const int32_t *)pOwnBlock, m_blockSize);
+			if (m_softClipping)
+				MIPMixKernels::softClip32To16((int16_t *)pSource->m_pOutput, m_pMixMinusSamples, m_blockSize);
+			else
+				MIPMixKernels::saturate32To16((int16_t *)pSource->m_pOutput, m_pMixMinusSamples, m_blockSize);
 		}
+		else // same as the complete mix
+			memcpy(pSource->m_pOutput, m_pClippedSamples, m_blockSize*sizeof(int16_t));
+	}
 
-		// 16 bit signed
-		
-		uint16_t *pNewFrames = new uint16_t [m_blockSize];
-			
-		memcpy(pNewFrames, m_pSilenceFramesInt, sizeof(uint16_t)*m_blockSize);
-		MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-		m_audioBlocks.push_back(block);
-		m_it = m_audioBlocks.end();
-		return block;
+	// The contribution isn't needed anymore, so the block can be reused right away
+	if (contributed)
+	{
+		memset(pOwnBlock, 0, m_blockBytes);
+		pSource->m_ringIntervals[slot] = -1;
 	}
+}
 
-	if (intervalNumber < (*m_it).getInterval())
+bool MIPAudioMixer::isActiveSpeaker(uint64_t sourceID, const MIPAudioMessage *pAudioMsg)
+{
+	// The mean power relative to full scale is used as a cheap level measure
+	size_t numSamples = (size_t)pAudioMsg->getNumberOfFrames()*(size_t)m_channels;
+	real_t power = 0;
+
+	if (numSamples > 0)
 	{
 		if (m_floatSamples)
 		{
-			float *pNewFrames = new float [m_blockSize];
-			
-			memcpy(pNewFrames, m_pSilenceFramesFloat, sizeof(float)*m_blockSize);
-			MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-			m_it = m_audioBlocks.insert(m_it, block);
-			m_it++;
-			return block;
+			const float *pSamples = ((const MIPRawFloatAudioMessage *)pAudioMsg)->getFrames();
+			real_t sum = 0;
+
+			for (size_t i = 0 ; i < numSamples ; i++)
+				sum += (real_t)pSamples[i]*(real_t)pSamples[i];
+			power = sum/(real_t)numSamples;
 		}
+		else
+		{
+			const int16_t *pSamples = (const int16_t *)((const MIPRaw16bitAudioMessage *)pAudioMsg)->getFrames();
+			int64_t sum = 0;
 
-		// 16 bit signed		
-		
-		uint16_t *pNewFrames = new uint16_t [m_blockSize];
-			
-		memcpy(pNewFrames, m_pSilenceFramesInt, sizeof(uint16_t)*m_blockSize);
-		MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-		m_it = m_audioBlocks.insert(m_it, block);
-		m_it++;
-		return block;
+			for (size_t i = 0 ; i < numSamples ; i++)
+				sum += (int32_t)pSamples[i]*(int32_t)pSamples[i];
+			power = (real_t)sum/((real_t)numSamples*32768.0*32768.0);
+		}
 	}
 
-	if (intervalNumber == (*m_it).getInterval())
+	SpeakerState &state = m_speakers[sourceID];
+
+	state.m_level = 0.5*state.m_level + 0.5*power;
+	state.m_lastPushInterval = m_curInterval;
+	if (state.m_level >= m_speakerThreshold)
+		state.m_lastLoudInterval = m_curInterval;
+
+	// A source that starts talking while there's room left is mixed immediately,
+	// otherwise it has to wait for the selection at the next interval
+	if (!state.m_active && state.m_lastLoudInterval == m_curInterval && m_numActiveSpeakers < m_maxSpeakers)
 	{
-		MIPAudioMixerBlock block = (*m_it);
-		m_it++;
-		return block;
+		state.m_active = true;
+		m_numActiveSpeakers++;
 	}
+	return state.m_active;
+}
 
-	// intervalNumber > (*m_it).getInterval()
-	
-	bool done = false;
-	
-	while (!done)
+void MIPAudioMixer::updateActiveSpeakers()
+{
+	m_speakerCandidates.clear();
+
+	auto it = m_speakers.begin();
+
+	while (it != m_speakers.end())
 	{
-		m_it++;
-		if (m_it == m_audioBlocks.end())
+		SpeakerState &state = it->second;
+
+		// Sources that didn't send anything fade out
+		if (state.m_lastPushInterval != m_curInterval)
+			state.m_level *= 0.5;
+
+		if (state.m_lastLoudInterval >= 0 && m_curInterval - state.m_lastLoudInterval <= m_hangoverIntervals)
+			m_speakerCandidates.push_back(std::pair<real_t, uint64_t>(state.m_level, it->first));
+		else if (m_curInterval - state.m_lastPushInterval > m_hangoverIntervals)
 		{
-			done = true;
+			it = m_speakers.erase(it);
+			continue;
 		}
-		else
-		{
-			if ((*m_it).getInterval() == intervalNumber)
-			{
-				MIPAudioMixerBlock block = (*m_it);
-				m_it++;
-				return block;
-			}
+		state.m_active = false;
+		++it;
+	}
 
-			if (intervalNumber < (*m_it).getInterval())
-			{
-				if (m_floatSamples)
-				{
-					float *pNewFrames = new float [m_blockSize];
-			
-					memcpy(pNewFrames, m_pSilenceFramesFloat, sizeof(float)*m_blockSize);
-					MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-					m_it = m_audioBlocks.insert(m_it, block);
-					m_it++;
-					return block;
-				}
+	std::sort(m_speakerCandidates.begin(), m_speakerCandidates.end(), std::greater<std::pair<real_t, uint64_t> >());
+	if (m_speakerCandidates.size() > (size_t)m_maxSpeakers)
+		m_speakerCandidates.resize((size_t)m_maxSpeakers);
 
-				// 16 bit signed
-				
-				uint16_t *pNewFrames = new uint16_t [m_blockSize];
-			
-				memcpy(pNewFrames, m_pSilenceFramesInt, sizeof(uint16_t)*m_blockSize);
-				MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-				m_it = m_audioBlocks.insert(m_it, block);
-				m_it++;
-				return block;
-			}
-		}
-	} 
-	
-	if (m_floatSamples)
+	for (auto &candidate : m_speakerCandidates)
+		m_speakers[candidate.second].m_active = true;
+	m_numActiveSpeakers = (int)m_speakerCandidates.size();
+
+	std::lock_guard<std::mutex> guard(m_activeSpeakersMutex);
+
+	m_activeSpeakers.clear();
+	for (auto &candidate : m_speakerCandidates)
+		m_activeSpeakers.push_back(candidate.second);
+}
+
+bool MIPAudioMixer::setActiveSpeakerSelection(int maxSpeakers, real_t thresholdDB, MIPTime hangover)
+{
+	if (!m_init)
 	{
-		float *pNewFrames = new float [m_blockSize];
-			
-		memcpy(pNewFrames, m_pSilenceFramesFloat, sizeof(float)*m_blockSize);
-		MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-		m_audioBlocks.push_back(block);
-		m_it = m_audioBlocks.end();
-		return block;
+		setErrorString(MIPAUDIOMIXER_ERRSTR_NOTINIT);
+		return false;
+	}
+	if (maxSpeakers < 0)
+	{
+		setErrorString(MIPAUDIOMIXER_ERRSTR_NEGATIVESPEAKERCOUNT);
+		return false;
+	}
+	if (hangover.getValue() < 0)
+	{
+		setErrorString(MIPAUDIOMIXER_ERRSTR_NEGATIVEHANGOVER);
+		return false;
 	}
 
-	// 16 bit signed
-	
-	uint16_t *pNewFrames = new uint16_t [m_blockSize];
-			
-	memcpy(pNewFrames, m_pSilenceFramesInt, sizeof(uint16_t)*m_blockSize);
-	MIPAudioMixerBlock block(intervalNumber, pNewFrames);
-	m_audioBlocks.push_back(block);
-	m_it = m_audioBlocks.end();
-	return block;
+	m_maxSpeakers = maxSpeakers;
+	m_speakerThreshold = std::pow((real_t)10.0, thresholdDB/(real_t)10.0);
+	m_hangoverIntervals = hangover.getNanoSeconds()/m_blockTime.getNanoSeconds();
+	m_speakers.clear();
+	m_numActiveSpeakers = 0;
+
+	std::lock_guard<std::mutex> guard(m_activeSpeakersMutex);
+
+	m_activeSpeakers.clear();
+	return true;
+}
+
+void MIPAudioMixer::getActiveSpeakers(std::vector<uint64_t> &sourceIDs) const
+{
+	std::lock_guard<std::mutex> guard(m_activeSpeakersMutex);
+
+	sourceIDs = m_activeSpeakers;
+}
+
+void MIPAudioMixer::addSourceToIgnore(uint64_t id)
+{
+	// The filter counts each identifier, so only add it once for this mixer
+	if (m_sourcesToIgnore.insert(id).second && m_pSourceFilter)
+		m_pSourceFilter->addSourceToIgnore(id);
+}
+
+void MIPAudioMixer::removeMixMinusSource(uint64_t id)
+{
+	std::lock_guard<std::mutex> guard(m_mixMinusRemoveMutex);
+
+	m_mixMinusSourcesToRemove.insert(id);
+}
+
+void MIPAudioMixer::clearIgnoreList()
+{
+	if (m_pSourceFilter)
+	{
+		for (auto id : m_sourcesToIgnore)
+			m_pSourceFilter->removeSourceToIgnore(id);
+	}
+	m_sourcesToIgnore.clear();
+}
+
+void MIPAudioMixer::setSourceFilter(MIPSourceFilter *pFilter)
+{
+	if (m_pSourceFilter)
+	{
+		for (auto id : m_sourcesToIgnore)
+			m_pSourceFilter->removeSourceToIgnore(id);
+	}
+
+	m_pSourceFilter = pFilter;
+	if (pFilter)
+	{
+		for (auto id : m_sourcesToIgnore)
+			pFilter->addSourceToIgnore(id);
+	}
 }
 
 bool MIPAudioMixer::processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, 
@@ -538,3 +787,26 @@ bool MIPAudioMixer::setExtraDelay(MIPTime t)
 	return true;
 }
 
+
+bool MIPAudioMixer::getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	uint32_t subtype = (m_floatSamples)?MIPRAWAUDIOMESSAGE_TYPE_FLOAT:MIPRAWAUDIOMESSAGE_TYPE_S16;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_SYSTEM, MIPSYSTEMMESSAGE_TYPE_ISTIME));
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, subtype, m_sampRate, m_channels));
+	return true;
+}
+
+bool MIPAudioMixer::getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	uint32_t subtype = (m_floatSamples)?MIPRAWAUDIOMESSAGE_TYPE_FLOAT:MIPRAWAUDIOMESSAGE_TYPE_S16;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, subtype, m_sampRate, m_channels));
+	return true;
+}
@@ -33,17 +33,22 @@
 #include "mipconfig.h"
 #include "mipcomponent.h"
 #include "miptime.h"
-#include <list>
 #include <set>
+#include <map>
+#include <mutex>
+#include <vector>
 
 class MIPRaw16bitAudioMessage;
 class MIPRawFloatAudioMessage;
+class MIPAudioMessage;
+class MIPSourceFilter;
 
 /** This component can mix several audio streams.
  *  Using this component, several audio streams can be mixed. In the default mode, it accepts 
  *  floating point raw audio messages and produces floating point raw audio messages. You
  *  can also work with signed 16 bit native raw audio messages. This component
- *  generates feedback about the current offset in the output stream.
+ *  generates feedback about the current offset in the output stream. For conferencing,
+ *  the mixer can also produce a mix-minus output for each source, see MIPAudioMixer::init.
  */
 class EMIPLIB_IMPORTEXPORT MIPAudioMixer : public MIPComponent
 {
@@ -63,8 +68,24 @@ public:
 	 *                     at the head of the stream and timing information will be ignored.
 	 *  \param floatSamples Flag indicating if floating point samples should be used or
 	 *                      signed 16 bit native endian samples.
+	 *  \param bufferTime Room for this amount of future audio is allocated in advance. Audio
+	 *                    which must be played even later is still accepted, but then the buffer
+	 *                    needs to be enlarged.
+	 *  \param softClipping Only used for 16 bit samples. By default, 16 bit samples are added
+	 *                      with saturation, so overflows are clipped hard. When this flag is set,
+	 *                      the samples are accumulated in 32 bit values instead and loud parts
+	 *                      are compressed smoothly when the output is generated (see
+	 *                      MIPMixKernels::softClip32To16).
+	 *  \param mixMinus If set, each interval the complete mix is followed by one message for
+	 *                  every source that has sent audio, containing the mix without that source's
+	 *                  own contribution. These messages carry the source ID of the participant
+	 *                  they're intended for, and can be routed to it using that ID. Only a single
+	 *                  mix is calculated, the own contributions are subtracted from it afterwards.
+	 *                  Since the complete mix itself has source ID 0, no mix-minus output is
+	 *                  generated for a source with that ID; its audio is only mixed.
 	 */
-	bool init(int sampRate, int channels, MIPTime blockTime, bool useTimeInfo = true, bool floatSamples = true);
+	bool init(int sampRate, int channels, MIPTime blockTime, bool useTimeInfo = true, bool floatSamples = true,
+	          MIPTime bufferTime = MIPTime(1.0), bool softClipping = false, bool mixMinus = false);
 
 	/** De-initializes the mixer component.
 	 *  This function frees the resources claimed by the mixer component.
@@ -90,38 +111,79 @@ public:
 	MIPTime getPlaybackTime() const								{ return m_playTime; }
 
 	/** Adds a source identifier which should be ignored. */
-	void addSourceToIgnore(uint64_t id)							{ m_sourcesToIgnore.insert(id); }
+	void addSourceToIgnore(uint64_t id);
 
 	/** Clears the list of sources to ignore. */
-	void clearIgnoreList()									{ m_sourcesToIgnore.clear(); }
+	void clearIgnoreList();
+
+	/** Stores the ignore list in \c pFilter as well, so that components before the mixer,
+	 *  like MIPRTPDecoder, can drop the data of these sources before any work is done
+	 *  on it. Sources which are already in the ignore list are added to the filter, and
+	 *  are removed from the previous filter. Use a null pointer to stop using a filter.
+	 *  The filter may be shared with other mixers or the application, since it counts
+	 *  how often each source was added; the mixer only removes its own additions, also
+	 *  in MIPAudioMixer::clearIgnoreList and when it is deleted. The filter must therefore
+	 *  remain valid as long as the mixer uses it.
+	 */
+	void setSourceFilter(MIPSourceFilter *pFilter);
+
+	/** When mix-minus outputs are generated, this stops the output for source \c id, for
+	 *  example when a participant has left. The output is created again if new audio from
+	 *  this source arrives. This function can be called while the mixer is being used
+	 *  in a chain.
+	 */
+	void removeMixMinusSource(uint64_t id);
+
+	/** Limits the mix to the loudest sources.
+	 *  When \c maxSpeakers is larger than zero, the mixer keeps track of the energy of each
+	 *  source and only mixes at most \c maxSpeakers sources whose level exceeds \c thresholdDB
+	 *  (relative to full scale). Other sources are not mixed at all, which bounds the mixing
+	 *  work and the accumulated background noise in large conferences. A selected source stays
+	 *  selected during \c hangover after its level dropped, so that short pauses don't chop
+	 *  its speech. Setting \c maxSpeakers to zero, the default, mixes all sources.
+	 */
+	bool setActiveSpeakerSelection(int maxSpeakers, real_t thresholdDB = -50.0, MIPTime hangover = MIPTime(0.5));
+
+	/** Stores the IDs of the sources that are currently being mixed when active speaker
+	 *  selection is enabled; the list is updated once per interval.
+	 */
+	void getActiveSpeakers(std::vector<uint64_t> &sourceIDs) const;
 	
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
 	bool processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback);
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
 private:
-	class MIPAudioMixerBlock
+	class MixMinusSource
 	{
 	public:
-		MIPAudioMixerBlock(int64_t playInterval, float *pFrames)			{ m_interval = playInterval; m_pFloatFrames = pFrames; m_pIntFrames = 0; }
-		MIPAudioMixerBlock(int64_t playInterval, uint16_t *pFrames)			{ m_interval = playInterval; m_pFloatFrames = 0; m_pIntFrames = pFrames; }
-		float *getFramesFloat()								{ return m_pFloatFrames; }
-		uint16_t *getFramesInt()							{ return m_pIntFrames; }
-		int64_t getInterval() const							{ return m_interval; }
-	private:
-		float *m_pFloatFrames;
-		uint16_t *m_pIntFrames;
-		int64_t m_interval;
+		uint8_t *m_pRing;
+		std::vector<int64_t> m_ringIntervals;
+		uint8_t *m_pOutput;
+		MIPRawFloatAudioMessage *m_pMsgFloat;
+		MIPRaw16bitAudioMessage *m_pMsgInt;
 	};
-	
-	void clearAudioBlocks();
-	void initBlockSearch();
-	MIPAudioMixerBlock searchBlock(int64_t intervalNumber);
+
+	uint8_t *getBlock(int64_t intervalNumber);
+	uint8_t *getBlock(MixMinusSource *pSource, int64_t intervalNumber);
+	void growRing(int64_t intervalNumber);
+	void moveBlocks(const uint8_t *pOldRing, const std::vector<int64_t> &oldIntervals, uint8_t *pNewRing,
+	                std::vector<int64_t> &newIntervals, size_t newMask);
+	void clearRing();
+	MixMinusSource *getMixMinusSource(uint64_t sourceID);
+	void deleteMixMinusSource(MixMinusSource *pSource);
+	void createMixMinusOutput(MixMinusSource *pSource, const uint8_t *pBlock);
+	bool isActiveSpeaker(uint64_t sourceID, const MIPAudioMessage *pAudioMsg);
+	void updateActiveSpeakers();
 	
 	bool m_init;
 	bool m_useTimeInfo;
 	int64_t m_prevIteration;
-	bool m_gotMessage;
 	bool m_floatSamples;
+	bool m_softClipping;
+	bool m_mixMinus;
+	bool m_accumulate32;
 
 	MIPTime m_blockTime, m_playTime;
 	int m_sampRate, m_channels;
@@ -130,17 +192,51 @@ private:
 	
 	MIPRawFloatAudioMessage *m_pMsgFloat;
 	MIPRaw16bitAudioMessage *m_pMsgInt;
-	float *m_pSilenceFramesFloat;
-	uint16_t *m_pSilenceFramesInt;
-	float *m_pBlockFramesFloat;
-	uint16_t *m_pBlockFramesInt;
+	int16_t *m_pClippedSamples;
+	int32_t *m_pMixMinusSamples;
+	std::vector<MIPMessage *> m_outputMessages;
+	size_t m_outputPos;
 
 	MIPTime m_extraDelay;
 	
-	std::list<MIPAudioMixerBlock> m_audioBlocks;
-	std::list<MIPAudioMixerBlock>::iterator m_it;
+	// Future audio is stored in a circular array of blocks, the block for an
+	// interval being at position 'interval mod capacity'. Unused blocks are
+	// always silent, and the block which is being played can't be reused until
+	// the next pull, so at most m_ringCapacity-1 future intervals can be stored
+	// before the array needs to grow.
+	uint8_t *m_pRing, *m_pRetiredRing;
+	std::vector<int64_t> m_ringIntervals;
+	size_t m_ringCapacity, m_ringMask;
+	size_t m_blockBytes;
+	int64_t m_playSlot;
 
 	std::set<uint64_t> m_sourcesToIgnore;
+	MIPSourceFilter *m_pSourceFilter;
+
+	// The contribution of each source is kept in a ring of the same size as the
+	// main one, so that it can be subtracted from the mix when it is played
+	std::map<uint64_t, MixMinusSource *> m_mixMinusSources;
+	std::mutex m_mixMinusRemoveMutex;
+	std::set<uint64_t> m_mixMinusSourcesToRemove;
+
+	class SpeakerState
+	{
+	public:
+		SpeakerState() : m_level(0), m_lastLoudInterval(-1), m_lastPushInterval(-1), m_active(false)	{ }
+
+		real_t m_level;
+		int64_t m_lastLoudInterval, m_lastPushInterval;
+		bool m_active;
+	};
+
+	int m_maxSpeakers, m_numActiveSpeakers;
+	real_t m_speakerThreshold;
+	int64_t m_hangoverIntervals;
+	std::map<uint64_t, SpeakerState> m_speakers;
+	std::vector<std::pair<real_t, uint64_t> > m_speakerCandidates;
+
+	mutable std::mutex m_activeSpeakersMutex;
+	std::vector<uint64_t> m_activeSpeakers;
 };
 
 #endif // MIPAUDIOMIXER_H
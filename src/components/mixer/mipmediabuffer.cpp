@@ -56,8 +56,8 @@ bool MIPMediaBuffer::init(MIPTime interval)
 
 	m_interval = interval;
 	m_gotPlaybackTime = false;
-	m_prevIteration = -1;
-	m_msgIt = m_messages.begin();
+	m_outputBuilt = false;
+	m_msgPos = 0;
 	m_init = true;
 	
 	return true;
@@ -112,7 +112,7 @@ bool MIPMediaBuffer::push(const MIPComponentChain &chain, int64_t iteration, MIP
 	return true;
 }
 
-bool MIPMediaBuffer::pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg)
+bool MIPMediaBuffer::pull(const MIPComponentChain &chain, int64_t, MIPMessage **pMsg)
 {
 	//std::cout << "I " << iteration << " MIPMediaBuffer::pull" << (void *)this << std::endl;
 	if (!m_init)
@@ -121,27 +121,47 @@ bool MIPMediaBuffer::pull(const MIPComponentChain &chain, int64_t iteration, MIP
 		return false;
 	}
 
-	if (iteration != m_prevIteration)
+	// The messages which were pushed in this iteration should be taken
+	// into account as well, so we can't do this at the start of the iteration
+	if (!m_outputBuilt)
 	{
-		m_prevIteration = iteration;
-		clearMessages();
 		buildOutputMessages();
+		m_outputBuilt = true;
 	}
 
-	if (m_msgIt == m_messages.end())
+	if (m_msgPos == m_messages.size())
 	{
 		*pMsg = 0;
-		m_msgIt = m_messages.begin();
+		m_msgPos = 0;
 	}
 	else
 	{
-		*pMsg = *m_msgIt;
-		m_msgIt++;
+		*pMsg = m_messages[m_msgPos];
+		m_msgPos++;
 	}
 
 	return true;
 }
 
+bool MIPMediaBuffer::pullBatch(const MIPComponentChain &, int64_t, MIPMessage * const *&pMessages, size_t &numMessages)
+{
+	if (!m_init)
+	{
+		setErrorString(MIPMEDIABUFFER_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	if (!m_outputBuilt)
+	{
+		buildOutputMessages();
+		m_outputBuilt = true;
+	}
+
+	numMessages = m_messages.size();
+	pMessages = (numMessages == 0)?0:&(m_messages[0]);
+	return true;
+}
+
 bool MIPMediaBuffer::processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback)
 {
 	if (!m_init)
@@ -161,14 +181,25 @@ bool MIPMediaBuffer::processFeedback(const MIPComponentChain &chain, int64_t fee
 	return true;
 }
 
-void MIPMediaBuffer::clearMessages()
+bool MIPMediaBuffer::onIterationStart(const MIPComponentChain &, int64_t)
 {
-	std::list<MIPMediaMessage *>::iterator it;
+	if (!m_init)
+	{
+		setErrorString(MIPMEDIABUFFER_ERRSTR_NOTINIT);
+		return false;
+	}
 
-	for (it = m_messages.begin() ; it != m_messages.end() ; it++)
-		delete (*it);
+	clearMessages();
+	m_outputBuilt = false;
+	return true;
+}
+
+void MIPMediaBuffer::clearMessages()
+{
+	for (size_t i = 0 ; i < m_messages.size() ; i++)
+		delete m_messages[i];
 	m_messages.clear();
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
 }
 
 void MIPMediaBuffer::clearBuffers()
@@ -209,24 +240,17 @@ void MIPMediaBuffer::buildOutputMessages()
 		}
 	}	
 	
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
 }
 
 void MIPMediaBuffer::insertInOutput(MIPMediaMessage *pMsg)
 {
-	std::list<MIPMediaMessage *>::iterator it;
 	MIPTime t = pMsg->getTime();
-	
-	it = m_messages.begin();
-	while (it != m_messages.end())
-	{
-		if (t < (*it)->getTime())
-		{
-			m_messages.insert(it, pMsg);
-			return;
-		}
-		it++;
-	}
-	m_messages.push_back(pMsg);
+	size_t pos = m_messages.size();
+
+	// Messages usually arrive (nearly) in order, so search from the back
+	while (pos > 0 && t < static_cast<MIPMediaMessage *>(m_messages[pos-1])->getTime())
+		pos--;
+	m_messages.insert(m_messages.begin() + pos, pMsg);
 }
 
@@ -34,6 +34,7 @@
 #include "mipcomponent.h"
 #include "miptime.h"
 #include <list>
+#include <vector>
 
 class MIPMediaMessage;
 
@@ -98,6 +99,9 @@ public:
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
 	bool processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback);
+	bool onIterationStart(const MIPComponentChain &chain, int64_t iteration);
+	bool supportsPullBatch() const									{ return true; }
+	bool pullBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages);
 private:
 	void clearMessages();
 	void clearBuffers();
@@ -105,10 +109,10 @@ private:
 	void insertInOutput(MIPMediaMessage *pMsg);
 
 	bool m_init;
-	std::list<MIPMediaMessage *> m_messages;
+	std::vector<MIPMessage *> m_messages;
 	std::list<MIPMediaMessage *> m_buffers;
-	std::list<MIPMediaMessage *>::const_iterator m_msgIt;
-	int64_t m_prevIteration;
+	size_t m_msgPos;
+	bool m_outputBuilt;
 	MIPTime m_interval, m_playbackTime;
 	bool m_gotPlaybackTime;
 };
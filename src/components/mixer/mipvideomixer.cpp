@@ -25,6 +25,8 @@
 #include "mipconfig.h"
 #include "mipvideomixer.h"
 #include "mipfeedback.h"
+#include "mipcomponentchain.h"
+#include "mipclock.h"
 
 #include "mipdebug.h"
 
@@ -56,7 +58,7 @@ bool MIPVideoMixer::init(real_t frameRate, int maxStreams)
 
 	m_frameTime = MIPTime(1.0/frameRate);
 	m_playTime = MIPTime(0);
-	m_lastCheckTime = MIPTime::getCurrentTime();
+	m_gotCheckTime = false;
 
 	m_maxStreams = maxStreams;
 	m_prevIteration = -1;
@@ -145,21 +147,13 @@ bool MIPVideoMixer::push(const MIPComponentChain &chain, int64_t iteration, MIPM
 	else
 		stream = *streamIt;
 	
-	// create a copy of the message
+	// create a copy of the message, sharing the frame data if possible
 	
-	int width = pVidMsg->getWidth();
-	int height = pVidMsg->getHeight();
-	int dataSize = (width*height*3)/2;
-	uint8_t *pNewFrameData = new uint8_t [dataSize];
-	
-	MIPRawYUV420PVideoMessage *pNewMsg = new MIPRawYUV420PVideoMessage(width, height, pNewFrameData, true);
-	
-	memcpy(pNewFrameData, pVidMsg->getImageData(), dataSize);
-	pNewMsg->copyMediaInfoFrom(*pVidMsg);
+	MIPRawYUV420PVideoMessage *pNewMsg = (MIPRawYUV420PVideoMessage *)pVidMsg->createCopy();
 
 	// insert it
 	
-	stream->insertFrame(frameNum,pNewMsg);
+	stream->insertFrame(frameNum,pNewMsg,chain.getClock().getCurrentTime());
 	
 	return true;
 }
@@ -177,7 +171,7 @@ bool MIPVideoMixer::pull(const MIPComponentChain &chain, int64_t iteration, MIPM
 		m_prevIteration = iteration;
 		clearOutputMessages();
 		createNewOutputMessages();
-		deleteOldSources();
+		deleteOldSources(chain.getClock().getCurrentTime());
 
 		m_curInterval++;
 		m_playTime += m_frameTime;
@@ -221,9 +215,14 @@ void MIPVideoMixer::createNewOutputMessages()
 	m_msgIt = m_outputMessages.begin();
 }
 
-void MIPVideoMixer::deleteOldSources()
+void MIPVideoMixer::deleteOldSources(MIPTime curTime)
 {
-	MIPTime curTime = MIPTime::getCurrentTime();
+	if (!m_gotCheckTime)
+	{
+		m_lastCheckTime = curTime;
+		m_gotCheckTime = true;
+		return;
+	}
 
 	if ((curTime.getValue() - m_lastCheckTime.getValue()) < 5.0) // wait 5 seconds between checks
 		return;
@@ -106,9 +106,9 @@ private:
 			}
 			return 0;
 		}
-		void insertFrame(int64_t frameNum, MIPRawYUV420PVideoMessage *pMsg)
+		void insertFrame(int64_t frameNum, MIPRawYUV420PVideoMessage *pMsg, MIPTime curTime)
 		{
-			m_lastInsertTime = MIPTime::getCurrentTime();
+			m_lastInsertTime = curTime;
 
 			std::list<VideoFrame>::iterator it;
 
@@ -174,13 +174,14 @@ private:
 	bool initFrameSearch(uint64_t sourceID);
 	void clearOutputMessages();
 	void createNewOutputMessages();
-	void deleteOldSources();
+	void deleteOldSources(MIPTime curTime);
 	
 	bool m_init;
 	int m_maxStreams;
 	int64_t m_prevIteration;
 	int64_t m_curInterval;
 	MIPTime m_playTime, m_frameTime, m_lastCheckTime;
+	bool m_gotCheckTime;
 	MIPTime m_extraDelay;
 	std::list<SourceStream *> m_streams;
 	std::list<MIPRawYUV420PVideoMessage *> m_outputMessages;
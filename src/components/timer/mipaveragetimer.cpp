@@ -25,18 +25,39 @@
 #include "mipconfig.h"
 #include "mipaveragetimer.h"
 #include "mipsystemmessage.h"
+#include "mipcomponentchain.h"
+#include "mipclock.h"
 //#include <iostream>
 
 #include "mipdebug.h"
 
 #define MIPAVERAGETIMER_ERRSTR_WRONGCHAIN		"Already in use by another component chain"
 #define MIPAVERAGETIMER_ERRSTR_BADMESSAGE		"Only a WAITTIME message is supported"
+#define MIPAVERAGETIMER_ERRSTR_BADMAXBURST		"The maximum number of late iterations can't be negative"
+#define MIPAVERAGETIMER_ERRSTR_BADHISTOGRAM		"The histogram needs at least one bin with a positive width"
 
 MIPAverageTimer::MIPAverageTimer(MIPTime interval) : MIPComponent("MIPAverageTimer"),
 						     m_startTime(0),
 						     m_interval(interval),
 						     m_timeMsg(MIPSYSTEMMESSAGE_TYPE_ISTIME)
 {
+	initTimer();
+}
+
+MIPAverageTimer::MIPAverageTimer(const std::string &componentName, MIPTime interval) : MIPComponent(componentName),
+						     m_startTime(0),
+						     m_interval(interval),
+						     m_timeMsg(MIPSYSTEMMESSAGE_TYPE_ISTIME)
+{
+	initTimer();
+}
+
+void MIPAverageTimer::initTimer()
+{
+	m_policy = Burst;
+	m_maxBurst = 0;
+	m_binWidth = 0.001;
+	m_histogram.resize(32);
 	reset();
 }
 
@@ -48,13 +69,108 @@ void MIPAverageTimer::reset()
 {
 	m_pChain = 0;
 	m_gotMsg = false;
+	m_burstCount = 0;
+	resetStatistics();
 }
 
-bool MIPAverageTimer::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+bool MIPAverageTimer::setCatchUpPolicy(CatchUpPolicy policy, int maxBurst)
+{
+	if (policy == BoundedBurst && maxBurst < 0)
+	{
+		setErrorString(MIPAVERAGETIMER_ERRSTR_BADMAXBURST);
+		return false;
+	}
+
+	m_policy = policy;
+	m_maxBurst = maxBurst;
+	m_burstCount = 0;
+	return true;
+}
+
+bool MIPAverageTimer::setLatenessHistogram(MIPTime binWidth, int numBins)
+{
+	if (numBins < 1 || binWidth.getValue() <= 0)
+	{
+		setErrorString(MIPAVERAGETIMER_ERRSTR_BADHISTOGRAM);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(m_statsMutex);
+
+	m_binWidth = binWidth.getValue();
+	m_histogram.resize(numBins);
+	m_numDeadlines = 0;
+	m_numMissed = 0;
+	m_maxLateness = 0;
+	for (size_t i = 0 ; i < m_histogram.size() ; i++)
+		m_histogram[i] = 0;
+	return true;
+}
+
+int64_t MIPAverageTimer::getNumberOfDeadlines() const
+{
+	std::lock_guard<std::mutex> guard(m_statsMutex);
+
+	return m_numDeadlines;
+}
+
+int64_t MIPAverageTimer::getNumberOfMissedDeadlines() const
+{
+	std::lock_guard<std::mutex> guard(m_statsMutex);
+
+	return m_numMissed;
+}
+
+MIPTime MIPAverageTimer::getMaximumLateness() const
+{
+	std::lock_guard<std::mutex> guard(m_statsMutex);
+
+	return MIPTime(m_maxLateness);
+}
+
+void MIPAverageTimer::getLatenessHistogram(std::vector<int64_t> &histogram, MIPTime &binWidth) const
+{
+	std::lock_guard<std::mutex> guard(m_statsMutex);
+
+	histogram = m_histogram;
+	binWidth = MIPTime(m_binWidth);
+}
+
+void MIPAverageTimer::resetStatistics()
+{
+	std::lock_guard<std::mutex> guard(m_statsMutex);
+
+	m_numDeadlines = 0;
+	m_numMissed = 0;
+	m_maxLateness = 0;
+	for (size_t i = 0 ; i < m_histogram.size() ; i++)
+		m_histogram[i] = 0;
+}
+
+void MIPAverageTimer::registerLateness(real_t lateness)
+{
+	std::lock_guard<std::mutex> guard(m_statsMutex);
+
+	m_numDeadlines++;
+	if (lateness <= 0)
+		return;
+
+	m_numMissed++;
+	if (lateness > m_maxLateness)
+		m_maxLateness = lateness;
+
+	size_t bin = (size_t)(lateness/m_binWidth);
+
+	if (bin >= m_histogram.size())
+		bin = m_histogram.size()-1;
+	m_histogram[bin]++;
+}
+
+bool MIPAverageTimer::checkChain(const MIPComponentChain &chain)
 {
 	if (m_pChain == 0)
 	{
-		m_startTime = MIPTime::getCurrentTime();
+		m_startTime = chain.getClock().getCurrentTime();
 		m_pChain = &chain;	
 	}
 	else
@@ -65,23 +181,78 @@ bool MIPAverageTimer::push(const MIPComponentChain &chain, int64_t iteration, MI
 			return false;
 		}
 	}
+	return true;
+}
+
+MIPTime MIPAverageTimer::getDeadline(int64_t iteration) const
+{
+	MIPTime deadline = m_startTime;
+
+	deadline += MIPTime::fromNanoSeconds(iteration*m_interval.getNanoSeconds());
+	return deadline;
+}
 
-	if (!(pMsg->getMessageType() == MIPMESSAGE_TYPE_SYSTEM && pMsg->getMessageSubtype() == MIPSYSTEMMESSAGE_TYPE_WAITTIME))
+bool MIPAverageTimer::getIterationStartTime(const MIPComponentChain &chain, int64_t iteration, MIPTime &startTime)
+{
+	if (!checkChain(chain))
+		return false;
+
+	startTime = getDeadline(iteration);
+	return true;
+}
+
+bool MIPAverageTimer::getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_SYSTEM, MIPSYSTEMMESSAGE_TYPE_WAITTIME));
+	return true;
+}
+
+bool MIPAverageTimer::getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_SYSTEM, MIPSYSTEMMESSAGE_TYPE_ISTIME));
+	return true;
+}
+
+bool MIPAverageTimer::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+{
+	if (!checkChain(chain))
+		return false;
+
+	if (!isInputVerified(chain) && !(pMsg->getMessageType() == MIPMESSAGE_TYPE_SYSTEM && pMsg->getMessageSubtype() == MIPSYSTEMMESSAGE_TYPE_WAITTIME))
 	{
 		setErrorString(MIPAVERAGETIMER_ERRSTR_BADMESSAGE);
 		return false;
 	}
 
-	MIPTime curTime = MIPTime::getCurrentTime();
-	real_t diff = (m_startTime.getValue()+((real_t)iteration)*m_interval.getValue())-curTime.getValue();
+	MIPTime curTime = chain.getClock().getCurrentTime();
+	MIPTime deadline = getDeadline(iteration);
+	MIPTime diffTime = deadline;
+	
+	diffTime -= curTime;
+	real_t diff = diffTime.getValue();
 //	std::cout << "Current time: " << curtime.getString() << std::endl;
 //	std::cout << "Starttime time: " << mStartTime.getString() << std::endl;
 //	std::cout << "Iteration: " << iteration << std::endl;
 //	std::cout << "Interval: " << mInterval.getString() << std::endl;
 //	std::cout << "diff: " << diff << std::endl;
 	
+	registerLateness(-diff);
+
 	if (diff > 0)
-		MIPTime::wait(MIPTime(diff));
+	{
+		m_burstCount = 0;
+		chain.getClock().waitUntil(deadline);
+	}
+	else if (diff < 0 && m_policy != Burst)
+	{
+		m_burstCount++;
+		if (m_policy == SkipAhead || m_burstCount > m_maxBurst)
+		{
+			// Shift the schedule so that this iteration is on time
+			m_startTime -= diffTime;
+			m_burstCount = 0;
+		}
+	}
 	
 	m_gotMsg = false;
 	return true;
@@ -34,6 +34,8 @@
 #include "mipcomponent.h"
 #include "miptime.h"
 #include "mipsystemmessage.h"
+#include <vector>
+#include <mutex>
 
 class MIPComponentChain;
 
@@ -41,7 +43,13 @@ class MIPComponentChain;
  *  This is a simple timing component which accepts MIPSYSTEMMESSAGE_WAITTIME system
  *  messages. It generates a MIPSYSTEMMESSAGE_ISTIME system message each time the
  *  specified interval has elapsed. Note that this is only on average after each interval:
- *  fluctuation will be present.
+ *  fluctuation will be present. The timer uses the clock of the chain it is used in,
+ *  see MIPComponentChain::setClock.
+ *
+ *  When processing an iteration takes longer than the interval, the moment at which
+ *  the next iteration should start has already passed. The timer keeps track of how often
+ *  this happens and how late it was, and the MIPAverageTimer::CatchUpPolicy determines 
+ *  how it recovers from this.
  */
 class EMIPLIB_IMPORTEXPORT MIPAverageTimer : public MIPComponent
 {
@@ -53,15 +61,77 @@ public:
 	MIPAverageTimer(MIPTime interval);
 	~MIPAverageTimer();
 
-	/** Re-initializes the component. */
+	/** Determines what happens when iterations are started too late. */
+	enum CatchUpPolicy
+	{
+		/** Iterations which are late are started immediately, until the timer has caught
+		 *  up with the original schedule (the default). */
+		Burst,
+		/** The schedule is shifted so that the late iteration is considered to be on time;
+		 *  the next iteration will then start one interval later. */
+		SkipAhead,
+		/** At most a specific number of late iterations are started back to back, after 
+		 *  which the schedule is shifted as with MIPAverageTimer::SkipAhead. */
+		BoundedBurst
+	};
+
+	/** Re-initializes the component, also clearing the statistics. */
 	void reset();
+
+	/** Sets the policy which is used when iterations are late; for MIPAverageTimer::BoundedBurst,
+	 *  \c maxBurst specifies the number of late iterations which can be started back to back. */
+	bool setCatchUpPolicy(CatchUpPolicy policy, int maxBurst = 0);
+
+	/** Returns the current catch-up policy. */
+	CatchUpPolicy getCatchUpPolicy() const								{ return m_policy; }
+
+	/** Sets the bins of the lateness histogram: \c numBins bins of width \c binWidth, the last one also
+	 *  counting all larger values (default: 32 bins of one millisecond); this clears the statistics. */
+	bool setLatenessHistogram(MIPTime binWidth, int numBins);
+
+	/** Returns the number of iterations which have been timed since the last reset. */
+	int64_t getNumberOfDeadlines() const;
+
+	/** Returns the number of those iterations which could not be started on time. */
+	int64_t getNumberOfMissedDeadlines() const;
+
+	/** Returns the largest amount of time an iteration was started too late. */
+	MIPTime getMaximumLateness() const;
+
+	/** Stores the lateness histogram of the missed deadlines in \c histogram, bin \c i counting
+	 *  the iterations which were between \c i and \c i+1 times \c binWidth too late. */
+	void getLatenessHistogram(std::vector<int64_t> &histogram, MIPTime &binWidth) const;
+
+	/** Clears the deadline statistics. */
+	void resetStatistics();
+
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	bool getIterationStartTime(const MIPComponentChain &chain, int64_t iteration, MIPTime &startTime);
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+protected:
+	/** Constructor for derived timers, which sets the component name to \c componentName. */
+	MIPAverageTimer(const std::string &componentName, MIPTime interval);
 private:
+	void initTimer();
+	bool checkChain(const MIPComponentChain &chain);
+	MIPTime getDeadline(int64_t iteration) const;
+	void registerLateness(real_t lateness);
+
 	const MIPComponentChain *m_pChain;
 	MIPTime m_startTime, m_interval;
 	MIPSystemMessage m_timeMsg;
 	bool m_gotMsg;
+
+	CatchUpPolicy m_policy;
+	int m_maxBurst, m_burstCount;
+
+	mutable std::mutex m_statsMutex;
+	int64_t m_numDeadlines, m_numMissed;
+	real_t m_maxLateness;
+	real_t m_binWidth;
+	std::vector<int64_t> m_histogram;
 };
 
 #endif // MIPAVERAGETIMER_H
@@ -0,0 +1,139 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipmultiratetimer.h"
+
+#include "mipdebug.h"
+
+#define MIPMULTIRATETIMER_ERRSTR_BADPERIOD		"The period of an output can't be shorter than the base interval"
+#define MIPMULTIRATETIMER_ERRSTR_BADOUTPUT		"Invalid output index"
+#define MIPMULTIRATETIMER_ERRSTR_BADMESSAGE		"Only an ISTIME message from the multi-rate timer is supported"
+#define MIPMULTIRATETIMER_ERRSTR_PULLWITHOUTPUSH	"The output was not triggered by its timer in this iteration"
+
+MIPMultiRateTimer::MIPMultiRateTimer(MIPTime baseInterval) : MIPAverageTimer("MIPMultiRateTimer", baseInterval)
+{
+	m_baseNano = baseInterval.getNanoSeconds();
+}
+
+MIPMultiRateTimer::~MIPMultiRateTimer()
+{
+	for (size_t i = 0 ; i < m_outputs.size() ; i++)
+		delete m_outputs[i];
+}
+
+MIPComponent *MIPMultiRateTimer::addOutput(MIPTime period)
+{
+	if (period.getNanoSeconds() < m_baseNano || m_baseNano <= 0)
+	{
+		setErrorString(MIPMULTIRATETIMER_ERRSTR_BADPERIOD);
+		return 0;
+	}
+
+	OutputComponent *pOutput = new OutputComponent(period.getNanoSeconds(), m_baseNano);
+
+	m_outputs.push_back(pOutput);
+	return pOutput;
+}
+
+MIPComponent *MIPMultiRateTimer::getOutput(int idx)
+{
+	if (idx < 0 || idx >= (int)m_outputs.size())
+	{
+		setErrorString(MIPMULTIRATETIMER_ERRSTR_BADOUTPUT);
+		return 0;
+	}
+	return m_outputs[idx];
+}
+
+MIPMultiRateTimer::OutputComponent::OutputComponent(int64_t periodNano, int64_t baseNano) : MIPComponent("MIPMultiRateTimer::OutputComponent"),
+												 m_timeMsg(MIPSYSTEMMESSAGE_TYPE_ISTIME)
+{
+	m_periodNano = periodNano;
+	m_baseNano = baseNano;
+	m_pushIteration = -1;
+	m_gotMsg = false;
+}
+
+bool MIPMultiRateTimer::OutputComponent::isDue(int64_t iteration) const
+{
+	// The chain starts counting at one, and the first period starts in the first
+	// iteration. After that, a new period starts in an iteration if one of its
+	// boundaries lies in the base interval which precedes it; this only depends on
+	// the iteration number, so the outputs stay in step with the timer's schedule
+	if (iteration <= 1)
+		return true;
+
+	int64_t prevPeriods = ((iteration-2)*m_baseNano)/m_periodNano;
+	int64_t periods = ((iteration-1)*m_baseNano)/m_periodNano;
+
+	return periods != prevPeriods;
+}
+
+bool MIPMultiRateTimer::OutputComponent::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+{
+	if (!isInputVerified(chain) && !(pMsg->getMessageType() == MIPMESSAGE_TYPE_SYSTEM && pMsg->getMessageSubtype() == MIPSYSTEMMESSAGE_TYPE_ISTIME))
+	{
+		setErrorString(MIPMULTIRATETIMER_ERRSTR_BADMESSAGE);
+		return false;
+	}
+
+	m_pushIteration = iteration;
+	m_gotMsg = false;
+	return true;
+}
+
+bool MIPMultiRateTimer::OutputComponent::pull(const MIPComponentChain &, int64_t iteration, MIPMessage **pMsg)
+{
+	if (m_pushIteration != iteration)
+	{
+		setErrorString(MIPMULTIRATETIMER_ERRSTR_PULLWITHOUTPUSH);
+		return false;
+	}
+
+	if (!m_gotMsg && isDue(iteration))
+	{
+		*pMsg = &m_timeMsg;
+		m_gotMsg = true;
+	}
+	else
+	{
+		*pMsg = 0;
+		m_gotMsg = false;
+	}
+	return true;
+}
+
+bool MIPMultiRateTimer::OutputComponent::getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_SYSTEM, MIPSYSTEMMESSAGE_TYPE_ISTIME));
+	return true;
+}
+
+bool MIPMultiRateTimer::OutputComponent::getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_SYSTEM, MIPSYSTEMMESSAGE_TYPE_ISTIME));
+	return true;
+}
+
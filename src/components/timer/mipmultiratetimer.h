@@ -0,0 +1,99 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipmultiratetimer.h
+ */
+
+#ifndef MIPMULTIRATETIMER_H
+
+#define MIPMULTIRATETIMER_H
+
+#include "mipconfig.h"
+#include "mipaveragetimer.h"
+#include <vector>
+
+/** Timing component which drives parts of a chain at different periods.
+ *  A chain runs at the single interval of its timer, so normally audio with 20 ms
+ *  blocks and video at 30 frames per second need two chains, each with its own thread.
+ *  This timer runs the chain at a base interval, like a MIPAverageTimer, and has a number
+ *  of internal 'output components' with a longer period, which can be added using
+ *  MIPMultiRateTimer::addOutput. Each output should be connected to the timer itself,
+ *  and generates a MIPSYSTEMMESSAGE_TYPE_ISTIME message in those iterations in which a new
+ *  period has started. In the other iterations an output is idle (see 
+ *  MIPComponent::isActiveInIteration), so the chain doesn't pull the output, nor the
+ *  components which only receive messages from it, directly or further on in the chain.
+ *  Components connected to an output are therefore driven at its period, so one chain
+ *  thread can service for example both the audio and the video of a session.
+ *
+ *  If a period is not a multiple of the base interval, the messages are generated in
+ *  the iteration which contains the start of the period, so the average rate is correct
+ *  but each message can be up to one base interval late. A component which also receives
+ *  messages from a part of the chain that runs at the base interval, like a mixer which
+ *  combines streams of both parts, is pulled in every iteration.
+ */
+class EMIPLIB_IMPORTEXPORT MIPMultiRateTimer : public MIPAverageTimer
+{
+public:
+	/** Creates a timer which runs the chain each time \c baseInterval has elapsed. */
+	MIPMultiRateTimer(MIPTime baseInterval);
+	~MIPMultiRateTimer();
+
+	/** Adds an output with period \c period, which must not be shorter than the base interval,
+	 *  and returns the output component, or null if the period is not valid. Outputs should
+	 *  be added before the chain is started, and remain owned by the timer. */
+	MIPComponent *addOutput(MIPTime period);
+
+	/** Returns the number of outputs. */
+	int getNumberOfOutputs() const									{ return (int)m_outputs.size(); }
+
+	/** Returns output component \c idx, or null if there's no such output. */
+	MIPComponent *getOutput(int idx);
+private:
+	class OutputComponent : public MIPComponent
+	{
+	public:
+		OutputComponent(int64_t periodNano, int64_t baseNano);
+		~OutputComponent()									{ }
+
+		bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
+		bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+		bool isActiveInIteration(const MIPComponentChain &, int64_t iteration)			{ return isDue(iteration); }
+		bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+		bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+	private:
+		bool isDue(int64_t iteration) const;
+
+		int64_t m_periodNano, m_baseNano;
+		MIPSystemMessage m_timeMsg;
+		int64_t m_pushIteration;
+		bool m_gotMsg;
+	};
+
+	int64_t m_baseNano;
+	std::vector<OutputComponent *> m_outputs;
+};
+
+#endif // MIPMULTIRATETIMER_H
+
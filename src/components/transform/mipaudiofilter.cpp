@@ -79,11 +79,30 @@ bool MIPAudioFilter::init(int sampRate, int channels, MIPTime interval)
 	
 	m_prevIteration = -1;
 	m_msgIt = m_messages.begin();
+	m_pPool = MIPSharedBufferPool<float>::create();
 	m_init = true;
 	
 	return true;
 }
 
+bool MIPAudioFilter::getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, MIPRAWAUDIOMESSAGE_TYPE_FLOAT, m_sampRate, m_channels));
+	return true;
+}
+
+bool MIPAudioFilter::getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, MIPRAWAUDIOMESSAGE_TYPE_FLOAT, m_sampRate, m_channels));
+	return true;
+}
+
 bool MIPAudioFilter::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
 {
 	if (!m_init)
@@ -92,7 +111,9 @@ bool MIPAudioFilter::push(const MIPComponentChain &chain, int64_t iteration, MIP
 		return false;
 	}
 
-	if (!(pMsg->getMessageType() == MIPMESSAGE_TYPE_AUDIO_RAW && pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_FLOAT))
+	bool verified = isInputVerified(chain);
+
+	if (!verified && !(pMsg->getMessageType() == MIPMESSAGE_TYPE_AUDIO_RAW && pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_FLOAT))
 	{
 		setErrorString(MIPAUDIOFILTER_ERRSTR_BADMESSAGETYPE);
 		return false;
@@ -109,14 +130,21 @@ bool MIPAudioFilter::push(const MIPComponentChain &chain, int64_t iteration, MIP
 		return false;
 	}
 
-	if (numChannels != m_channels)
+	if (!verified && numChannels != m_channels)
 	{
 		setErrorString(MIPAUDIOFILTER_ERRSTR_BADNUMCHANNELS);
 		return false;
 	}
 	
+	if (m_prevIteration != iteration)
+	{
+		m_prevIteration = iteration;
+		clearMessages();
+	}
+
 	const float *pSamplesFloatIn = pAudioMsg->getFrames();
-	float *pSamplesFloat = new float[m_audioSize];
+	MIPSharedBuffer<float> *pBuffer = m_pPool->getBuffer(m_audioSize);
+	float *pSamplesFloat = pBuffer->getData();
 
 	for (int channel = 0 ; channel < m_channels ; channel++)
 	{
@@ -197,16 +225,21 @@ bool MIPAudioFilter::push(const MIPComponentChain &chain, int64_t iteration, MIP
 		}
 	}
 
-	MIPAudioMessage *pNewMsg = new MIPRawFloatAudioMessage(0,0,0,pSamplesFloat,true);
-	pNewMsg->copyAudioInfoFrom(*pAudioMsg);
+	MIPRawFloatAudioMessage *pNewMsg;
 
-	if (m_prevIteration != iteration)
+	if (m_freeMessages.empty())
 	{
-		m_prevIteration = iteration;
-		clearMessages();
+		pNewMsg = new MIPRawFloatAudioMessage(0,0,0,pBuffer);
+		m_messages.push_back(pNewMsg);
 	}
+	else
+	{
+		pNewMsg = (MIPRawFloatAudioMessage *)m_freeMessages.front();
+		pNewMsg->setFrames(pBuffer);
+		m_messages.splice(m_messages.end(), m_freeMessages, m_freeMessages.begin());
+	}
+	pNewMsg->copyAudioInfoFrom(*pAudioMsg);
 
-	m_messages.push_back(pNewMsg);
 	m_msgIt = m_messages.begin();
 	
 	return true;
@@ -250,17 +283,27 @@ void MIPAudioFilter::cleanUp()
 	delete [] m_pB;
 	delete [] m_pBuf;
 	clearMessages();
+
+	std::list<MIPAudioMessage *>::iterator it;
+
+	for (it = m_freeMessages.begin() ; it != m_freeMessages.end() ; it++)
+		delete (*it);
+	m_freeMessages.clear();
+	m_pPool->release();
 	
 	m_init = false;
 }
 
 void MIPAudioFilter::clearMessages()
 {
+	// Keep the message objects for the next iteration; their sample
+	// buffers go back to the pool once no copies refer to them anymore
+
 	std::list<MIPAudioMessage *>::iterator it;
 
 	for (it = m_messages.begin() ; it != m_messages.end() ; it++)
-		delete (*it);
-	m_messages.clear();
+		((MIPRawFloatAudioMessage *)(*it))->setFrames(0, false);
+	m_freeMessages.splice(m_freeMessages.end(), m_messages);
 	m_msgIt = m_messages.begin();
 }
 
@@ -34,6 +34,7 @@
 #include "mipcomponent.h"
 #include "miprawaudiomessage.h"
 #include "miptime.h"
+#include "mipsharedbuffer.h"
 #include <list>
 
 class MIPAudioMessage;
@@ -76,6 +77,8 @@ public:
 
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
 private:
 	void cleanUp();
 	void clearMessages();
@@ -90,9 +93,10 @@ private:
 	float *m_pA, *m_pB;
 	float *m_pBuf;
 	float m_period;
-	std::list<MIPAudioMessage *> m_messages;
+	std::list<MIPAudioMessage *> m_messages, m_freeMessages;
 	std::list<MIPAudioMessage *>::const_iterator m_msgIt;
 	int64_t m_prevIteration;
+	MIPSharedBufferPool<float> *m_pPool;
 };
 
 #endif // MIPAUDIOFILTER_H
@@ -116,6 +116,22 @@ bool MIPAVCodecFrameConverter::destroy()
 	return true;
 }
 
+bool MIPAVCodecFrameConverter::getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_VIDEO_RAW, MIPRAWVIDEOMESSAGE_TYPE_YUYV|MIPRAWVIDEOMESSAGE_TYPE_YUV420P|
+	                                                              MIPRAWVIDEOMESSAGE_TYPE_RGB24|MIPRAWVIDEOMESSAGE_TYPE_RGB32));
+	return true;
+}
+
+bool MIPAVCodecFrameConverter::getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_VIDEO_RAW, m_targetSubtype));
+	return true;
+}
+
 bool MIPAVCodecFrameConverter::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
 {
 	if (!m_init)
@@ -131,18 +147,22 @@ bool MIPAVCodecFrameConverter::push(const MIPComponentChain &chain, int64_t iter
 		m_lastIteration = iteration;
 	}
 
-	if (pMsg->getMessageType() != MIPMESSAGE_TYPE_VIDEO_RAW)
-	{
-		setErrorString(MIPAVCODECFRAMECONVERTER_ERRSTR_BADMESSAGE);
-		return false;
-	}
-
 	uint32_t subType = pMsg->getMessageSubtype();
-	if (!(subType == MIPRAWVIDEOMESSAGE_TYPE_YUYV || subType == MIPRAWVIDEOMESSAGE_TYPE_YUV420P || 
-	      subType == MIPRAWVIDEOMESSAGE_TYPE_RGB24 || subType == MIPRAWVIDEOMESSAGE_TYPE_RGB32))
+
+	if (!isInputVerified(chain))
 	{
-		setErrorString(MIPAVCODECFRAMECONVERTER_ERRSTR_BADMESSAGE);
-		return false;
+		if (pMsg->getMessageType() != MIPMESSAGE_TYPE_VIDEO_RAW)
+		{
+			setErrorString(MIPAVCODECFRAMECONVERTER_ERRSTR_BADMESSAGE);
+			return false;
+		}
+
+		if (!(subType == MIPRAWVIDEOMESSAGE_TYPE_YUYV || subType == MIPRAWVIDEOMESSAGE_TYPE_YUV420P || 
+		      subType == MIPRAWVIDEOMESSAGE_TYPE_RGB24 || subType == MIPRAWVIDEOMESSAGE_TYPE_RGB32))
+		{
+			setErrorString(MIPAVCODECFRAMECONVERTER_ERRSTR_BADMESSAGE);
+			return false;
+		}
 	}
 
 	MIPVideoMessage *pVideoMsg = (MIPVideoMessage *)pMsg;
@@ -71,6 +71,8 @@ public:
 
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
 
 	/** Initializes the libavcodec library.
 	 *  This function initializes the libavcodec library. The library should only be initialized once
@@ -0,0 +1,201 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipdefaultconverterfactory.h"
+#include "mipsampleencoder.h"
+#include "mipsamplingrateconverter.h"
+#include "mipavcodecframeconverter.h"
+#include "miprawaudiomessage.h"
+#include "miprawvideomessage.h"
+
+#include "mipdebug.h"
+
+#define MIPDEFAULTCONVERTERFACTORY_AUDIOTYPES	(MIPRAWAUDIOMESSAGE_TYPE_FLOAT|MIPRAWAUDIOMESSAGE_TYPE_U8|MIPRAWAUDIOMESSAGE_TYPE_U16LE|\
+						 MIPRAWAUDIOMESSAGE_TYPE_U16BE|MIPRAWAUDIOMESSAGE_TYPE_S16LE|MIPRAWAUDIOMESSAGE_TYPE_S16BE|\
+						 MIPRAWAUDIOMESSAGE_TYPE_S16|MIPRAWAUDIOMESSAGE_TYPE_U16)
+#define MIPDEFAULTCONVERTERFACTORY_VIDEOTYPES	(MIPRAWVIDEOMESSAGE_TYPE_YUV420P|MIPRAWVIDEOMESSAGE_TYPE_YUYV|\
+						 MIPRAWVIDEOMESSAGE_TYPE_RGB24|MIPRAWVIDEOMESSAGE_TYPE_RGB32)
+
+#define MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITENCODER	"Can't initialize sample encoder: "
+#define MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITRATECONVERTER	"Can't initialize sampling rate converter: "
+#define MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITFRAMECONVERTER	"Can't initialize frame converter: "
+
+bool MIPDefaultConverterFactory::createConverters(const MIPMessageFormat &produced, const std::vector<MIPMessageFormat> &accepted, 
+                                                  std::vector<MIPComponent *> &converters)
+{
+	// Use the first accepted format for which a conversion is possible
+	for (size_t i = 0 ; i < accepted.size() ; i++)
+	{
+		if (accepted[i].getMessageType() != produced.getMessageType())
+			continue;
+
+		if (produced.getMessageType() == MIPMESSAGE_TYPE_AUDIO_RAW)
+		{
+			if (createAudioConverters(produced, accepted[i], converters))
+				return true;
+		}
+		else if (produced.getMessageType() == MIPMESSAGE_TYPE_VIDEO_RAW)
+		{
+			if (createVideoConverters(produced, accepted[i], converters))
+				return true;
+		}
+	}
+	return false;
+}
+
+bool MIPDefaultConverterFactory::createAudioConverters(const MIPMessageFormat &produced, const MIPMessageFormat &accepted,
+                                                       std::vector<MIPComponent *> &converters)
+{
+	uint32_t srcType = produced.getMessageSubtypes();
+	uint32_t acceptedTypes = accepted.getMessageSubtypes() & MIPDEFAULTCONVERTERFACTORY_AUDIOTYPES;
+
+	if ((srcType & MIPDEFAULTCONVERTERFACTORY_AUDIOTYPES) == 0 || acceptedTypes == 0)
+		return false;
+
+	// Keep the current encoding if possible, otherwise prefer the ones the
+	// sampling rate converter can work with
+	uint32_t dstType;
+
+	if (acceptedTypes & srcType)
+		dstType = srcType;
+	else if (acceptedTypes & MIPRAWAUDIOMESSAGE_TYPE_FLOAT)
+		dstType = MIPRAWAUDIOMESSAGE_TYPE_FLOAT;
+	else if (acceptedTypes & MIPRAWAUDIOMESSAGE_TYPE_S16)
+		dstType = MIPRAWAUDIOMESSAGE_TYPE_S16;
+	else
+		dstType = acceptedTypes & (~acceptedTypes + 1); // lowest flag
+
+	int srcRate = produced.getSamplingRate();
+	int srcChannels = produced.getNumberOfChannels();
+	int dstRate = (accepted.getSamplingRate() != 0)?accepted.getSamplingRate():srcRate;
+	int dstChannels = (accepted.getNumberOfChannels() != 0)?accepted.getNumberOfChannels():srcChannels;
+	bool resample = (dstRate != srcRate || dstChannels != srcChannels);
+
+	if (!resample)
+	{
+		if (dstType == srcType)
+			return false;
+
+		MIPSampleEncoder *pEncoder = new MIPSampleEncoder();
+
+		if (!pEncoder->init((int)dstType))
+		{
+			setErrorString(std::string(MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITENCODER) + pEncoder->getErrorString());
+			delete pEncoder;
+			return false;
+		}
+		converters.push_back(pEncoder);
+		return true;
+	}
+
+	if (dstRate == 0 || dstChannels == 0)
+		return false;
+
+	// The sampling rate converter can only map between mono and any number of channels,
+	// or keep the number of channels
+	if (srcChannels != 0 && srcChannels != 1 && dstChannels != 1 && srcChannels != dstChannels)
+		return false;
+
+	uint32_t convType = (srcType == MIPRAWAUDIOMESSAGE_TYPE_S16 && dstType == MIPRAWAUDIOMESSAGE_TYPE_S16)?
+	                    MIPRAWAUDIOMESSAGE_TYPE_S16:MIPRAWAUDIOMESSAGE_TYPE_FLOAT;
+
+	size_t firstConverter = converters.size();
+
+	if (srcType != convType)
+	{
+		MIPSampleEncoder *pEncoder = new MIPSampleEncoder();
+
+		converters.push_back(pEncoder);
+		if (!pEncoder->init((int)convType))
+		{
+			setErrorString(std::string(MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITENCODER) + pEncoder->getErrorString());
+			deleteConverters(converters, firstConverter);
+			return false;
+		}
+	}
+
+	MIPSamplingRateConverter *pConverter = new MIPSamplingRateConverter();
+
+	converters.push_back(pConverter);
+	if (!pConverter->init(dstRate, dstChannels, (convType == MIPRAWAUDIOMESSAGE_TYPE_FLOAT)))
+	{
+		setErrorString(std::string(MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITRATECONVERTER) + pConverter->getErrorString());
+		deleteConverters(converters, firstConverter);
+		return false;
+	}
+
+	if (dstType != convType)
+	{
+		MIPSampleEncoder *pEncoder = new MIPSampleEncoder();
+
+		converters.push_back(pEncoder);
+		if (!pEncoder->init((int)dstType))
+		{
+			setErrorString(std::string(MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITENCODER) + pEncoder->getErrorString());
+			deleteConverters(converters, firstConverter);
+			return false;
+		}
+	}
+	return true;
+}
+
+#ifdef MIPCONFIG_SUPPORT_AVCODEC
+bool MIPDefaultConverterFactory::createVideoConverters(const MIPMessageFormat &produced, const MIPMessageFormat &accepted,
+                                                       std::vector<MIPComponent *> &converters)
+{
+	uint32_t srcType = produced.getMessageSubtypes();
+	uint32_t acceptedTypes = accepted.getMessageSubtypes() & MIPDEFAULTCONVERTERFACTORY_VIDEOTYPES;
+
+	if ((srcType & MIPDEFAULTCONVERTERFACTORY_VIDEOTYPES) == 0 || acceptedTypes == 0 || (acceptedTypes & srcType))
+		return false;
+
+	uint32_t dstType = acceptedTypes & (~acceptedTypes + 1);
+	MIPAVCodecFrameConverter *pConverter = new MIPAVCodecFrameConverter();
+
+	// Keep the frame dimensions, only change the pixel format
+	if (!pConverter->init(-1, -1, dstType))
+	{
+		setErrorString(std::string(MIPDEFAULTCONVERTERFACTORY_ERRSTR_CANTINITFRAMECONVERTER) + pConverter->getErrorString());
+		delete pConverter;
+		return false;
+	}
+	converters.push_back(pConverter);
+	return true;
+}
+#else
+bool MIPDefaultConverterFactory::createVideoConverters(const MIPMessageFormat &, const MIPMessageFormat &,
+                                                       std::vector<MIPComponent *> &)
+{
+	return false;
+}
+#endif // MIPCONFIG_SUPPORT_AVCODEC
+
+void MIPDefaultConverterFactory::deleteConverters(std::vector<MIPComponent *> &converters, size_t firstConverter)
+{
+	for (size_t i = firstConverter ; i < converters.size() ; i++)
+		delete converters[i];
+	converters.resize(firstConverter);
+}
+
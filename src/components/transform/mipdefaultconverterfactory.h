@@ -0,0 +1,62 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipdefaultconverterfactory.h
+ */
+
+#ifndef MIPDEFAULTCONVERTERFACTORY_H
+
+#define MIPDEFAULTCONVERTERFACTORY_H
+
+#include "mipconfig.h"
+#include "mipmessageformat.h"
+#include "miperrorbase.h"
+
+/** Creates the standard EMIPLIB converters for chains with format negotiation enabled.
+ *  This factory can be passed to MIPComponentChain::setFormatNegotiation. For raw audio
+ *  messages it uses a MIPSampleEncoder to change the sample encoding, and a 
+ *  MIPSamplingRateConverter if the sampling rate or number of channels differ. If 
+ *  libavcodec support is available, raw video messages are converted to another
+ *  subtype using a MIPAVCodecFrameConverter. If such a converter can't be initialized,
+ *  no converters are created and the reason can be retrieved using getErrorString.
+ */
+class EMIPLIB_IMPORTEXPORT MIPDefaultConverterFactory : public MIPMessageConverterFactory, public MIPErrorBase
+{
+public:
+	MIPDefaultConverterFactory()									{ }
+	~MIPDefaultConverterFactory()									{ }
+
+	bool createConverters(const MIPMessageFormat &produced, const std::vector<MIPMessageFormat> &accepted, 
+	                      std::vector<MIPComponent *> &converters);
+private:
+	bool createAudioConverters(const MIPMessageFormat &produced, const MIPMessageFormat &accepted,
+	                           std::vector<MIPComponent *> &converters);
+	bool createVideoConverters(const MIPMessageFormat &produced, const MIPMessageFormat &accepted,
+	                           std::vector<MIPComponent *> &converters);
+	void deleteConverters(std::vector<MIPComponent *> &converters, size_t firstConverter);
+};
+
+#endif // MIPDEFAULTCONVERTERFACTORY_H
+
@@ -58,12 +58,33 @@ bool MIPSampleEncoder::init(int dstType)
 
 	m_dstType = dstType;
 	m_prevIteration = -1;
+	m_pFloatPool = (dstType == MIPRAWAUDIOMESSAGE_TYPE_FLOAT)?MIPSharedBufferPool<float>::create():0;
 	m_msgIt = m_messages.begin();
 	m_init = true;
 	
 	return true;
 }
 
+bool MIPSampleEncoder::getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	uint32_t allTypes = MIPRAWAUDIOMESSAGE_TYPE_FLOAT|MIPRAWAUDIOMESSAGE_TYPE_U8|MIPRAWAUDIOMESSAGE_TYPE_U16LE|
+	                    MIPRAWAUDIOMESSAGE_TYPE_U16BE|MIPRAWAUDIOMESSAGE_TYPE_S16LE|MIPRAWAUDIOMESSAGE_TYPE_S16BE|
+	                    MIPRAWAUDIOMESSAGE_TYPE_S16|MIPRAWAUDIOMESSAGE_TYPE_U16;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, allTypes));
+	return true;
+}
+
+bool MIPSampleEncoder::getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	// Sampling rate and number of channels are those of the incoming messages
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, (uint32_t)m_dstType));
+	return true;
+}
+
 bool MIPSampleEncoder::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
 {
 	if (!m_init)
@@ -72,16 +93,23 @@ bool MIPSampleEncoder::push(const MIPComponentChain &chain, int64_t iteration, M
 		return false;
 	}
 
-	if (pMsg->getMessageType() != MIPMESSAGE_TYPE_AUDIO_RAW)
+	if (!isInputVerified(chain) && pMsg->getMessageType() != MIPMESSAGE_TYPE_AUDIO_RAW)
 	{
 		setErrorString(MIPSAMPLEENCODER_ERRSTR_BADMESSAGETYPE);
 		return false;
 	}
 
+	if (m_prevIteration != iteration)
+	{
+		m_prevIteration = iteration;
+		clearMessages();
+	}
+
 	MIPAudioMessage *pAudioMsg = (MIPAudioMessage *)pMsg;
 
 	size_t numIn = pAudioMsg->getNumberOfChannels()*pAudioMsg->getNumberOfFrames();
 
+	MIPSharedBuffer<float> *pBufferFloat = 0;
 	float *pSamplesFloat = 0;
 	uint8_t *pSamplesU8 = 0;
 	uint16_t *pSamples16 = 0;
@@ -89,7 +117,10 @@ bool MIPSampleEncoder::push(const MIPComponentChain &chain, int64_t iteration, M
 	if (m_dstType == MIPRAWAUDIOMESSAGE_TYPE_U8)
 		pSamplesU8 = new uint8_t [numIn];
 	else if (m_dstType == MIPRAWAUDIOMESSAGE_TYPE_FLOAT)
-		pSamplesFloat = new float [numIn];
+	{
+		pBufferFloat = m_pFloatPool->getBuffer(numIn);
+		pSamplesFloat = pBufferFloat->getData();
+	}
 	else
 		pSamples16 = new uint16_t [numIn];
 	
@@ -247,11 +278,21 @@ bool MIPSampleEncoder::push(const MIPComponentChain &chain, int64_t iteration, M
 	}
 
 	MIPAudioMessage *pNewMsg;
+	bool recycled = false;
 
 	if (m_dstType == MIPRAWAUDIOMESSAGE_TYPE_U8)
 		pNewMsg = new MIPRawU8AudioMessage(0,0,0,pSamplesU8,true);
 	else if (m_dstType == MIPRAWAUDIOMESSAGE_TYPE_FLOAT)
-		pNewMsg = new MIPRawFloatAudioMessage(0,0,0,pSamplesFloat,true);
+	{
+		if (m_freeMessages.empty())
+			pNewMsg = new MIPRawFloatAudioMessage(0,0,0,pBufferFloat);
+		else
+		{
+			pNewMsg = m_freeMessages.front();
+			((MIPRawFloatAudioMessage *)pNewMsg)->setFrames(pBufferFloat);
+			recycled = true;
+		}
+	}
 	else
 	{
 		bool isSigned;
@@ -274,13 +315,10 @@ bool MIPSampleEncoder::push(const MIPComponentChain &chain, int64_t iteration, M
 
 	pNewMsg->copyAudioInfoFrom(*pAudioMsg);
 
-	if (m_prevIteration != iteration)
-	{
-		m_prevIteration = iteration;
-		clearMessages();
-	}
-
-	m_messages.push_back(pNewMsg);
+	if (recycled)
+		m_messages.splice(m_messages.end(), m_freeMessages, m_freeMessages.begin());
+	else
+		m_messages.push_back(pNewMsg);
 	m_msgIt = m_messages.begin();
 	
 	return true;
@@ -319,6 +357,15 @@ void MIPSampleEncoder::cleanUp()
 		return;
 
 	clearMessages();
+
+	std::list<MIPAudioMessage *>::iterator it;
+
+	for (it = m_freeMessages.begin() ; it != m_freeMessages.end() ; it++)
+		delete (*it);
+	m_freeMessages.clear();
+
+	if (m_pFloatPool)
+		m_pFloatPool->release();
 	
 	m_init = false;
 }
@@ -327,9 +374,21 @@ void MIPSampleEncoder::clearMessages()
 {
 	std::list<MIPAudioMessage *>::iterator it;
 
-	for (it = m_messages.begin() ; it != m_messages.end() ; it++)
-		delete (*it);
-	m_messages.clear();
+	if (m_dstType == MIPRAWAUDIOMESSAGE_TYPE_FLOAT)
+	{
+		// Keep the message objects for the next iteration; their sample
+		// buffers go back to the pool once no copies refer to them anymore
+
+		for (it = m_messages.begin() ; it != m_messages.end() ; it++)
+			((MIPRawFloatAudioMessage *)(*it))->setFrames(0, false);
+		m_freeMessages.splice(m_freeMessages.end(), m_messages);
+	}
+	else
+	{
+		for (it = m_messages.begin() ; it != m_messages.end() ; it++)
+			delete (*it);
+		m_messages.clear();
+	}
 	m_msgIt = m_messages.begin();
 }
 
@@ -33,6 +33,7 @@
 #include "mipconfig.h"
 #include "mipcomponent.h"
 #include "miprawaudiomessage.h"
+#include "mipsharedbuffer.h"
 #include <list>
 
 class MIPAudioMessage;
@@ -57,15 +58,18 @@ public:
 
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
 private:
 	void cleanUp();
 	void clearMessages();
 
 	bool m_init;
 	int m_dstType;
-	std::list<MIPAudioMessage *> m_messages;
+	std::list<MIPAudioMessage *> m_messages, m_freeMessages;
 	std::list<MIPAudioMessage *>::const_iterator m_msgIt;
 	int64_t m_prevIteration;
+	MIPSharedBufferPool<float> *m_pFloatPool;
 };
 
 #endif // MIPSAMPLEENCODER_H
@@ -52,8 +52,8 @@ bool MIPSamplingRateConverter::init(int outRate, int outChannels, bool floatSamp
 	m_outRate = outRate;
 	m_outChannels = outChannels;
 	m_floatSamples = floatSamples;
+	m_pFloatPool = (floatSamples)?MIPSharedBufferPool<float>::create():0;
 
-	m_prevIteration = -1;
 	m_init = true;
 	
 	return true;
@@ -65,20 +65,67 @@ void MIPSamplingRateConverter::cleanUp()
 		return;
 
 	clearMessages();
+
+	std::list<MIPAudioMessage *>::iterator it;
+
+	for (it = m_freeMessages.begin() ; it != m_freeMessages.end() ; it++)
+		delete (*it);
+	m_freeMessages.clear();
+
+	if (m_pFloatPool)
+		m_pFloatPool->release();
 	m_init = false;
 }
 
 void MIPSamplingRateConverter::clearMessages()
 {
-	std::list<MIPAudioMessage *>::iterator it;
+	if (m_floatSamples)
+	{
+		// Keep the message objects for the next iteration; their sample
+		// buffers go back to the pool once no copies refer to them anymore
 
-	for (it = m_messages.begin() ; it != m_messages.end() ; it++)
-		delete (*it);
-	m_messages.clear();
+		std::list<MIPAudioMessage *>::iterator it;
+
+		for (it = m_messages.begin() ; it != m_messages.end() ; it++)
+			((MIPRawFloatAudioMessage *)(*it))->setFrames(0, false);
+		m_freeMessages.splice(m_freeMessages.end(), m_messages);
+	}
+	else
+	{
+		std::list<MIPAudioMessage *>::iterator it;
+
+		for (it = m_messages.begin() ; it != m_messages.end() ; it++)
+			delete (*it);
+		m_messages.clear();
+	}
 	m_msgIt = m_messages.begin();
 }
 
-bool MIPSamplingRateConverter::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+bool MIPSamplingRateConverter::getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	// Any sampling rate is accepted; whether the channels can be converted is
+	// still checked for each message
+	uint32_t subtype = (m_floatSamples)?MIPRAWAUDIOMESSAGE_TYPE_FLOAT:MIPRAWAUDIOMESSAGE_TYPE_S16;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, subtype));
+	return true;
+}
+
+bool MIPSamplingRateConverter::getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+{
+	if (!m_init)
+		return false;
+
+	uint32_t subtype = (m_floatSamples)?MIPRAWAUDIOMESSAGE_TYPE_FLOAT:MIPRAWAUDIOMESSAGE_TYPE_S16;
+
+	formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, subtype, m_outRate, m_outChannels));
+	return true;
+}
+
+bool MIPSamplingRateConverter::push(const MIPComponentChain &chain, int64_t, MIPMessage *pMsg)
 {
 	if (!m_init)
 	{
@@ -86,7 +133,7 @@ bool MIPSamplingRateConverter::push(const MIPComponentChain &chain, int64_t iter
 		return false;
 	}
 	
-	if (!(pMsg->getMessageType() == MIPMESSAGE_TYPE_AUDIO_RAW && 
+	if (!isInputVerified(chain) && !(pMsg->getMessageType() == MIPMESSAGE_TYPE_AUDIO_RAW && 
 		( (pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_FLOAT && m_floatSamples) ||
 		  (pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_S16 && !m_floatSamples) ) ) ) 
 	{
@@ -113,15 +160,29 @@ bool MIPSamplingRateConverter::push(const MIPComponentChain &chain, int64_t iter
 	{
 		MIPRawFloatAudioMessage *pFloatAudioMsg = (MIPRawFloatAudioMessage *)pMsg;
 		const float *oldFrames = pFloatAudioMsg->getFrames();
-		float *newFrames = new float [numNewSamples];
+		MIPSharedBuffer<float> *pNewBuffer = m_pFloatPool->getBuffer(numNewSamples);
 	
-		if (!MIPResample<float,float>(oldFrames, numInFrames, numInChannels, newFrames, numNewFrames, m_outChannels))
+		if (!MIPResample<float,float>(oldFrames, numInFrames, numInChannels, pNewBuffer->getData(), numNewFrames, m_outChannels))
 		{
+			pNewBuffer->release();
 			setErrorString(MIPSAMPLINGRATECONVERTER_ERRSTR_CANTRESAMPLE);
 			return false;
 		}
-		
-		pNewMsg = new MIPRawFloatAudioMessage(m_outRate, m_outChannels, numNewFrames, newFrames, true);
+
+		if (m_freeMessages.empty())
+		{
+			pNewMsg = new MIPRawFloatAudioMessage(m_outRate, m_outChannels, numNewFrames, pNewBuffer);
+			m_messages.push_back(pNewMsg);
+		}
+		else
+		{
+			MIPRawFloatAudioMessage *pFreeMsg = (MIPRawFloatAudioMessage *)m_freeMessages.front();
+
+			pFreeMsg->setFrames(pNewBuffer);
+			pFreeMsg->setNumberOfFrames(numNewFrames);
+			pNewMsg = pFreeMsg;
+			m_messages.splice(m_messages.end(), m_freeMessages, m_freeMessages.begin());
+		}
 		pNewMsg->copyMediaInfoFrom(*pAudioMsg); // copy time info and source ID
 	}
 	else // 16 bit signed
@@ -138,21 +199,15 @@ bool MIPSamplingRateConverter::push(const MIPComponentChain &chain, int64_t iter
 		
 		pNewMsg = new MIPRaw16bitAudioMessage(m_outRate, m_outChannels, numNewFrames, true, MIPRaw16bitAudioMessage::Native, newFrames, true);
 		pNewMsg->copyMediaInfoFrom(*pAudioMsg); // copy time info and source ID
+		m_messages.push_back(pNewMsg);
 	}
 	
-	if (m_prevIteration != iteration)
-	{
-		clearMessages();
-		m_prevIteration = iteration;
-	}
-	
-	m_messages.push_back(pNewMsg);
 	m_msgIt = m_messages.begin();
 	
 	return true;
 }
 
-bool MIPSamplingRateConverter::pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg)
+bool MIPSamplingRateConverter::pull(const MIPComponentChain &chain, int64_t, MIPMessage **pMsg)
 {
 	if (!m_init)
 	{
@@ -160,12 +215,6 @@ bool MIPSamplingRateConverter::pull(const MIPComponentChain &chain, int64_t iter
 		return false;
 	}
 
-	if (m_prevIteration != iteration)
-	{
-		clearMessages();
-		m_prevIteration = iteration;
-	}
-
 	if (m_msgIt == m_messages.end())
 	{
 		*pMsg = 0;
@@ -179,3 +228,15 @@ bool MIPSamplingRateConverter::pull(const MIPComponentChain &chain, int64_t iter
 	return true;
 }
 
+bool MIPSamplingRateConverter::onIterationStart(const MIPComponentChain &, int64_t)
+{
+	if (!m_init)
+	{
+		setErrorString(MIPSAMPLINGRATECONVERTER_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	clearMessages();
+	return true;
+}
+
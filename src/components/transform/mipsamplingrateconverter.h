@@ -32,6 +32,7 @@
 
 #include "mipconfig.h"
 #include "mipcomponent.h"
+#include "mipsharedbuffer.h"
 #include <list>
 
 class MIPAudioMessage;
@@ -58,14 +59,17 @@ public:
 	
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	bool onIterationStart(const MIPComponentChain &chain, int64_t iteration);
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
 private:
 	void cleanUp();
 	void clearMessages();
 	
 	bool m_init;
-	std::list<MIPAudioMessage *> m_messages;
+	std::list<MIPAudioMessage *> m_messages, m_freeMessages;
 	std::list<MIPAudioMessage *>::const_iterator m_msgIt;
-	int64_t m_prevIteration;
+	MIPSharedBufferPool<float> *m_pFloatPool;
 	int m_outRate, m_outChannels;
 	bool m_floatSamples;
 };
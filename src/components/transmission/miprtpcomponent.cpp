@@ -25,6 +25,7 @@
 #include "mipconfig.h"
 #include "miprtpcomponent.h"
 #include "miprtpmessage.h"
+#include "mipsourcefilter.h"
 #include "mipsystemmessage.h"
 #include <jrtplib3/rtpsession.h>
 #include <jrtplib3/rtpsourcedata.h>
@@ -43,7 +44,8 @@ using namespace jrtplib;
 MIPRTPComponent::MIPRTPComponent() : MIPComponent("MIPRTPComponent")
 {
 	m_pRTPSession = 0;
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
+	m_pSourceFilter = 0;
 }
 
 MIPRTPComponent::~MIPRTPComponent()
@@ -70,7 +72,7 @@ bool MIPRTPComponent::init(RTPSession *pSess, uint32_t silentTimestampIncrement)
 	m_prevSendIteration = -1;
 	m_silentTimestampIncrease = silentTimestampIncrement;
 	m_enableSending = true;
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
 	
 	return true;
 }
@@ -180,19 +182,39 @@ bool MIPRTPComponent::pull(const MIPComponentChain &chain, int64_t iteration, MI
 	if (!processNewPackets(iteration))
 		return false;
 
-	if (m_msgIt == m_messages.end())
+	if (m_msgPos == m_messages.size())
 	{
-		m_msgIt = m_messages.begin();
+		m_msgPos = 0;
 		*pMsg = 0;
 	}
 	else
 	{
-		*pMsg = *m_msgIt;
-		m_msgIt++;
+		*pMsg = m_messages[m_msgPos];
+		m_msgPos++;
 	}
 	return true;
 }
 
+bool MIPRTPComponent::pullBatch(const MIPComponentChain &, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages)
+{
+	if (m_pRTPSession == 0)
+	{
+		setErrorString(MIPRTPCOMPONENT_ERRSTR_NOTINIT);
+		return false;
+	}
+	if (!m_pRTPSession->IsActive())
+	{
+		setErrorString(MIPRTPCOMPONENT_ERRSTR_NORTPSESSION);
+		return false;
+	}
+	if (!processNewPackets(iteration))
+		return false;
+
+	numMessages = m_messages.size();
+	pMessages = (numMessages == 0)?0:&(m_messages[0]);
+	return true;
+}
+
 bool MIPRTPComponent::processNewPackets(int64_t iteration)
 {
 	if (iteration != m_prevIteration)
@@ -244,6 +266,14 @@ bool MIPRTPComponent::processNewPackets(int64_t iteration)
 				
 				while ((pPack = m_pRTPSession->GetNextPacket()) != 0)
 				{
+					uint64_t sourceID = getSourceID(pPack, srcData);
+
+					if (m_pSourceFilter && m_pSourceFilter->isIgnored(sourceID))
+					{
+						m_pRTPSession->DeletePacket(pPack);
+						continue;
+					}
+
 					MIPRTPReceiveMessage *pRTPMsg = new MIPRTPReceiveMessage(pPack,pCName,cnameLength,true,m_pRTPSession);
 
 					pRTPMsg->setJitter(MIPTime(jitterSeconds));
@@ -254,25 +284,23 @@ bool MIPRTPComponent::processNewPackets(int64_t iteration)
 					if (setTimingInfo)
 						pRTPMsg->setTimingInfo(timingInfWallclock, timingInfTimestamp);
 
-					pRTPMsg->setSourceID(getSourceID(pPack, srcData));
+					pRTPMsg->setSourceID(sourceID);
 					m_messages.push_back(pRTPMsg);
 				}
 			} while (m_pRTPSession->GotoNextSourceWithData());
 		}
 		m_pRTPSession->EndDataAccess();
-  		m_msgIt = m_messages.begin();
+  		m_msgPos = 0;
 	}
 	return true;
 }
 
 void MIPRTPComponent::clearMessages()
 {
-	std::list<MIPRTPReceiveMessage *>::iterator it;
-
-	for (it = m_messages.begin() ; it != m_messages.end() ; it++)
-		delete (*it);
+	for (size_t i = 0 ; i < m_messages.size() ; i++)
+		delete m_messages[i];
 	m_messages.clear();
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
 }
 
 uint64_t MIPRTPComponent::getSourceID(const RTPPacket *pPack, const RTPSourceData *pSourceData) const
@@ -33,8 +33,10 @@
 #include "mipconfig.h"
 #include "mipcomponent.h"
 #include <list>
+#include <vector>
 
 class MIPRTPReceiveMessage;
+class MIPSourceFilter;
 
 namespace jrtplib
 {
@@ -76,8 +78,16 @@ public:
 	/** This flag controls if RTP packets are actually sent out, useful for a push-to-talk system for example (enabled by default). */
 	void setEnableSending(bool f)										{ m_enableSending = f; }
 
+	/** Packets from sources in this filter are discarded immediately, so no further processing
+	 *  is done for them; use a null pointer to accept all packets. The source ID which is checked
+	 *  is the one returned by MIPRTPComponent::getSourceID.
+	 */
+	void setSourceFilter(MIPSourceFilter *pFilter)								{ m_pSourceFilter = pFilter; }
+
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	bool supportsPullBatch() const										{ return true; }
+	bool pullBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages);
 protected:
 	/** Returns the source ID for the packet \c pPack belonging to source \c pSourceData.
 	 *  This virtual function returns the source ID when processing packet \c pPack originating
@@ -90,13 +100,14 @@ private:
 	bool processNewPackets(int64_t iteration);	
 	void clearMessages();
 	
-	std::list<MIPRTPReceiveMessage *> m_messages;
-	std::list<MIPRTPReceiveMessage *>::const_iterator m_msgIt;
+	std::vector<MIPMessage *> m_messages;
+	size_t m_msgPos;
 	int64_t m_prevIteration;
 	int64_t m_prevSendIteration;
 	jrtplib::RTPSession *m_pRTPSession;
 	uint32_t m_silentTimestampIncrease;
 	bool m_enableSending;
+	MIPSourceFilter *m_pSourceFilter;
 };
 
 #endif // MIPRTPCOMPONENT_H
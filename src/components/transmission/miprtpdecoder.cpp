@@ -30,6 +30,9 @@
 #include "miprtpsynchronizer.h"
 #include "mipmediamessage.h"
 #include "miprtppacketdecoder.h"
+#include "mipsourcefilter.h"
+#include "mipcomponentchain.h"
+#include "mipclock.h"
 #include <jrtplib3/rtppacket.h>
 #include <jrtplib3/rtpsession.h>
 #include <jrtplib3/rtpsourcedata.h>
@@ -45,6 +48,7 @@ using namespace jrtplib;
 MIPRTPDecoder::MIPRTPDecoder() : MIPComponent("MIPRTPDecoder"), m_playbackOffset(0), m_prevCleanTableTime(0), m_maxJitterBuffer(-1)
 {
 	m_init = false;
+	m_pSourceFilter = 0;
 }
 
 MIPRTPDecoder::~MIPRTPDecoder()
@@ -57,10 +61,10 @@ bool MIPRTPDecoder::init(bool calcStreamTime, MIPRTPSynchronizer *pSynchronizer,
 	if (m_init)
 		cleanUp();
 
-	m_prevIteration = -1;
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
 	m_gotPlaybackFeedback = false;
-	m_prevCleanTableTime = MIPTime::getCurrentTime();
+	m_prevCleanTableTime = MIPTime(0);
+	m_gotCleanTableTime = false;
 	m_calcStreamTime = calcStreamTime;
 	m_pSynchronizer = pSynchronizer;
 	m_totalComponentDelay = MIPTime(0);
@@ -106,7 +110,7 @@ bool MIPRTPDecoder::setPacketDecoder(uint8_t payloadType, MIPRTPPacketDecoder *p
 	return true;
 }
 
-bool MIPRTPDecoder::push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+bool MIPRTPDecoder::push(const MIPComponentChain &chain, int64_t, MIPMessage *pMsg)
 {
 	if (!m_init)
 	{
@@ -120,20 +124,19 @@ bool MIPRTPDecoder::push(const MIPComponentChain &chain, int64_t iteration, MIPM
 		return false;
 	}
 	
-	if (iteration != m_prevIteration)
-	{
-		m_prevIteration = iteration;
-		clearMessages();
-		cleanUpSourceTable();
-	}
-
 	if (m_calcStreamTime)
 	{
 		if (!m_gotPlaybackFeedback) // we don't have any information about the playback stream, ignore packet
 			return true;
 	}
 
+	m_curTime = chain.getClock().getCurrentTime();
+
 	MIPRTPReceiveMessage *pRTPMsg = (MIPRTPReceiveMessage *)pMsg;
+
+	if (m_pSourceFilter && m_pSourceFilter->isIgnored(pRTPMsg->getSourceID()))
+		return true;
+
 	const RTPPacket *pRTPPack = pRTPMsg->getPacket();
 	real_t timestampUnit = pRTPMsg->getTimestampUnit();
 	MIPRTPPacketDecoder *pDecoder = m_pDecoders[(int)(pRTPPack->GetPayloadType())];
@@ -261,12 +264,12 @@ bool MIPRTPDecoder::push(const MIPComponentChain &chain, int64_t iteration, MIPM
 		m_messages.push_back(pNewMsg);
 	}
 
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
 	
 	return true;
 }
 
-bool MIPRTPDecoder::pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg)
+bool MIPRTPDecoder::pull(const MIPComponentChain &chain, int64_t, MIPMessage **pMsg)
 {
 	if (!m_init)
 	{
@@ -274,26 +277,46 @@ bool MIPRTPDecoder::pull(const MIPComponentChain &chain, int64_t iteration, MIPM
 		return false;
 	}	
 	
-	if (iteration != m_prevIteration)
-	{
-		m_prevIteration = iteration;
-		clearMessages();
-		cleanUpSourceTable();
-	}
-	
-	if (m_msgIt == m_messages.end())
+	if (m_msgPos == m_messages.size())
 	{
 		*pMsg = 0;
-		m_msgIt = m_messages.begin();
+		m_msgPos = 0;
 	}
 	else
 	{
-		*pMsg = *m_msgIt;
-		m_msgIt++;
+		*pMsg = m_messages[m_msgPos];
+		m_msgPos++;
 	}
 	return true;
 }
 
+bool MIPRTPDecoder::pullBatch(const MIPComponentChain &, int64_t, MIPMessage * const *&pMessages, size_t &numMessages)
+{
+	if (!m_init)
+	{
+		setErrorString(MIPRTPDECODER_ERRSTR_NOTINIT);
+		return false;
+	}	
+
+	numMessages = m_messages.size();
+	pMessages = (numMessages == 0)?0:&(m_messages[0]);
+	return true;
+}
+
+bool MIPRTPDecoder::onIterationStart(const MIPComponentChain &chain, int64_t)
+{
+	if (!m_init)
+	{
+		setErrorString(MIPRTPDECODER_ERRSTR_NOTINIT);
+		return false;
+	}	
+
+	m_curTime = chain.getClock().getCurrentTime();
+	clearMessages();
+	cleanUpSourceTable();
+	return true;
+}
+
 bool MIPRTPDecoder::processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback)
 {
 	if (!m_init)
@@ -322,17 +345,22 @@ void MIPRTPDecoder::cleanUp()
 
 void MIPRTPDecoder::clearMessages()
 {
-	std::list<MIPMediaMessage *>::iterator it;
-
-	for (it = m_messages.begin() ; it != m_messages.end() ; it++)
-		delete (*it);
+	for (size_t i = 0 ; i < m_messages.size() ; i++)
+		delete m_messages[i];
 	m_messages.clear();
-	m_msgIt = m_messages.begin();
+	m_msgPos = 0;
 }
 
 void MIPRTPDecoder::cleanUpSourceTable()
 {
-	MIPTime curTime = MIPTime::getCurrentTime();
+	MIPTime curTime = m_curTime;
+
+	if (!m_gotCleanTableTime)
+	{
+		m_prevCleanTableTime = curTime;
+		m_gotCleanTableTime = true;
+		return;
+	}
 
 	if ((curTime.getValue() - m_prevCleanTableTime.getValue()) < 60.0) // only cleanup every 60 seconds
 		return;
@@ -360,7 +388,7 @@ void MIPRTPDecoder::cleanUpSourceTable()
 
 bool MIPRTPDecoder::lookUpStreamTime(uint32_t ssrc, uint32_t timestamp, const uint8_t *pCName, size_t cnameLength, real_t timestampUnit, MIPTime &streamTime, bool &shouldSync)
 {
-	MIPTime curTime = MIPTime::getCurrentTime();
+	MIPTime curTime = m_curTime;
 	auto it = m_sourceTable.find(ssrc);
 	
 	if (it == m_sourceTable.end())
@@ -432,7 +460,7 @@ bool MIPRTPDecoder::adjustToPlaybackTime(MIPTime jitterValue, MIPTime &streamTim
 		defaultOffset += MIPTime(MINOFFSET);
 		defaultOffset += m_playbackOffset;
 		
-		m_pSSRCInfo->setPlaybackOffset(defaultOffset);
+		m_pSSRCInfo->setPlaybackOffset(defaultOffset, m_curTime);
 	}
 	
 	streamTime += m_pSSRCInfo->getPlaybackOffset();
@@ -471,7 +499,7 @@ bool MIPRTPDecoder::adjustToPlaybackTime(MIPTime jitterValue, MIPTime &streamTim
 		{
 			if (offset < MINOFFSET) // need more buffering
 			{
-				MIPTime curTime = MIPTime::getCurrentTime();
+				MIPTime curTime = m_curTime;
 		
 				if ((curTime.getValue() - m_pSSRCInfo->getLastOffsetAdjustTime().getValue()) > 0.200)
 				{
@@ -491,7 +519,7 @@ bool MIPRTPDecoder::adjustToPlaybackTime(MIPTime jitterValue, MIPTime &streamTim
 		//	std::cerr << "Insert variance: " << m_pSSRCInfo->getInsertTimeVariance().getString() << std::endl;
 		//	std::cerr << "Jitter:          " << jitterValue.getString() << std::endl;
 			
-						m_pSSRCInfo->setPlaybackOffset(newOffset);
+						m_pSSRCInfo->setPlaybackOffset(newOffset, m_curTime);
 		//				std::cerr << "Increasing playback offset by " << MIPTime(diff).getString() << std::endl;
 		//				std::cerr << "New offset is " << newOffset.getString() << std::endl;
 					}
@@ -499,7 +527,7 @@ bool MIPRTPDecoder::adjustToPlaybackTime(MIPTime jitterValue, MIPTime &streamTim
 			}
 			else // perhaps we kan decrease the buffering somewhat, but we'll only make gradual adjustments every 5 seconds
 			{
-				MIPTime curTime = MIPTime::getCurrentTime();
+				MIPTime curTime = m_curTime;
 				real_t delay;
 				real_t ins = insertDiff;
 		
@@ -534,7 +562,7 @@ bool MIPRTPDecoder::adjustToPlaybackTime(MIPTime jitterValue, MIPTime &streamTim
 		//	std::cerr << "Insert variance: " << m_pSSRCInfo->getInsertTimeVariance().getString() << std::endl;
 		//	std::cerr << "Jitter:          " << jitterValue.getString() << std::endl;
 			
-						m_pSSRCInfo->setPlaybackOffset(newOffset);
+						m_pSSRCInfo->setPlaybackOffset(newOffset, m_curTime);
 		//				std::cerr << "Decreasing playback offset by " << MIPTime(diff2).getString() << std::endl;
 		//				std::cerr << "New offset is " << newOffset.getString() << std::endl;
 					}
@@ -542,7 +570,7 @@ bool MIPRTPDecoder::adjustToPlaybackTime(MIPTime jitterValue, MIPTime &streamTim
 					{
 						// reinstall old offset so the adjustment time is initialized again
 						MIPTime oldOffset = m_pSSRCInfo->getPlaybackOffset();
-						m_pSSRCInfo->setPlaybackOffset(oldOffset);
+						m_pSSRCInfo->setPlaybackOffset(oldOffset, m_curTime);
 					}
 				}
 			}
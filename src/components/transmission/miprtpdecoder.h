@@ -36,6 +36,7 @@
 #include <unordered_map>
 #include <cmath>
 #include <list>
+#include <vector>
 
 namespace jrtplib
 {
@@ -46,6 +47,7 @@ class MIPRTPReceiveMessage;
 class MIPRTPSynchronizer;
 class MIPMediaMessage;
 class MIPRTPPacketDecoder;
+class MIPSourceFilter;
 
 #define MIPRTPDECODER_MAXPAYLOADDECODERS							256
 
@@ -96,9 +98,18 @@ public:
 	 */
 	void setMaximumJitterBuffering(MIPTime t)								{ m_maxJitterBuffer = t; }
 
+	/** Messages from sources in this filter are dropped before they are decoded; use a null
+	 *  pointer to process all messages. The filter can also be set in MIPRTPComponent, in
+	 *  which case the packets are discarded even earlier.
+	 */
+	void setSourceFilter(MIPSourceFilter *pFilter)								{ m_pSourceFilter = pFilter; }
+
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
 	bool processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback);
+	bool onIterationStart(const MIPComponentChain &chain, int64_t iteration);
+	bool supportsPullBatch() const										{ return true; }
+	bool pullBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages);
 protected:
 	/** This virtual function is called when a new MIPMediaMessage is produced by an MIPRTPPacketDecoder
 	 *  instance. */
@@ -111,9 +122,8 @@ private:
 	bool adjustToPlaybackTime(MIPTime jitterValue, MIPTime &streamTime, MIPTime &insertOffset);
 
 	bool m_init;	
-	int64_t m_prevIteration;
-	std::list<MIPMediaMessage *> m_messages;
-	std::list<MIPMediaMessage *>::const_iterator m_msgIt;
+	std::vector<MIPMessage *> m_messages;
+	size_t m_msgPos;
 
 	bool m_gotPlaybackFeedback;
 	MIPTime m_playbackOffset;
@@ -145,7 +155,7 @@ private:
 		
 		int getNumberOfInsertTimes() const			{ return m_numInsertTimes; }
 			
-		void setPlaybackOffset(MIPTime offset)			{ clearAdjustmentInfo(); m_playbackOffset = offset; m_gotPlaybackOffset = true; m_lastOffsetAdjustTime = MIPTime::getCurrentTime(); }
+		void setPlaybackOffset(MIPTime offset, MIPTime curTime)	{ clearAdjustmentInfo(); m_playbackOffset = offset; m_gotPlaybackOffset = true; m_lastOffsetAdjustTime = curTime; }
 		void addInsertTime(MIPTime t)
 		{
 #define MIPRTPDECODER_HISTLEN 16
@@ -156,23 +166,23 @@ private:
 			if (m_numInsertTimes < MIPRTPDECODER_HISTLEN)
 				m_numInsertTimes++;
 
-			real_t avg = 0;
-			real_t sigma2 = 0;
+			// The average can be calculated exactly in nanoseconds, for the spread
+			// double precision is more than enough
+			int64_t sum = 0;
+			double sigma2 = 0;
 			for (int i = 0 ; i < m_numInsertTimes ; i++)
-				avg += m_insertTimes[i].getValue();
-			avg /= (real_t)m_numInsertTimes;
+				sum += m_insertTimes[i].getNanoSeconds();
+			int64_t avg = sum/(int64_t)m_numInsertTimes;
 
 			for (int i = 0 ; i < m_numInsertTimes ; i++)
 			{
-				real_t diff = m_insertTimes[i].getValue() - avg;
-				real_t diff2 = diff*diff;
-				sigma2 += diff2;
+				double diff = (double)(m_insertTimes[i].getNanoSeconds() - avg);
+				sigma2 += diff*diff;
 			}
-			sigma2 /= (real_t)m_numInsertTimes;
-			real_t sigma = (real_t)sqrt(sigma2);
+			sigma2 /= (double)m_numInsertTimes;
 
-			m_avgInsertTime = MIPTime(avg);
-			m_insertTimeSpread = MIPTime(sigma);
+			m_avgInsertTime = MIPTime::fromNanoSeconds(avg);
+			m_insertTimeSpread = MIPTime::fromNanoSeconds((int64_t)(std::sqrt(sigma2)+0.5));
 		}
 
 		void clearAdjustmentInfo()
@@ -223,6 +233,8 @@ private:
 	MIPRTPPacketDecoder *m_pDecoders[MIPRTPDECODER_MAXPAYLOADDECODERS];
 
 	MIPTime m_prevCleanTableTime;
+	bool m_gotCleanTableTime;
+	MIPTime m_curTime;
 	SSRCInfo *m_pSSRCInfo;
 	bool m_calcStreamTime;
 	MIPRTPSynchronizer *m_pSynchronizer;
@@ -232,6 +244,8 @@ private:
 
 	bool m_useFixedJitterBuffer;
 	MIPTime m_fixedJitterBuffer;
+
+	MIPSourceFilter *m_pSourceFilter;
 };
 
 #endif // MIPRTPDECODER_H
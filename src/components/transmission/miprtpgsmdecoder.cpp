@@ -59,10 +59,10 @@ bool MIPRTPGSMDecoder::validatePacket(const RTPPacket *pRTPPack, real_t &timesta
 void MIPRTPGSMDecoder::createNewMessages(const RTPPacket *pRTPPack, std::list<MIPMediaMessage *> &messages, std::list<uint32_t> &timestamps)
 {
 	size_t length = pRTPPack->GetPayloadLength();
-	uint8_t *pData = new uint8_t [length];
+	MIPSharedBuffer<uint8_t> *pBuffer = getPayloadBuffer(length);
 	
-	memcpy(pData, pRTPPack->GetPayloadData(), length);
-	MIPEncodedAudioMessage *pEncMsg = new MIPEncodedAudioMessage(MIPENCODEDAUDIOMESSAGE_TYPE_GSM, 8000, 1, MIPRTPGSMDECODER_NUMFRAMES, pData, length, true);
+	memcpy(pBuffer->getData(), pRTPPack->GetPayloadData(), length);
+	MIPEncodedAudioMessage *pEncMsg = new MIPEncodedAudioMessage(MIPENCODEDAUDIOMESSAGE_TYPE_GSM, 8000, 1, MIPRTPGSMDECODER_NUMFRAMES, pBuffer, length);
 
 	messages.push_back(pEncMsg);
 	timestamps.push_back(pRTPPack->GetTimestamp());
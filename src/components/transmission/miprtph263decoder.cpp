@@ -142,7 +142,7 @@ void MIPRTPH263Decoder::createNewMessages(const RTPPacket *pRTPPack, std::list<M
 
 				if (pData[0] == 0x00 && pData[1] == 0x00)
 				{
-					MIPEncodedVideoMessage *pVidMsg = new MIPEncodedVideoMessage(MIPENCODEDVIDEOMESSAGE_TYPE_H263P, 0, 0, pData, totalSize, true);
+					MIPEncodedVideoMessage *pVidMsg = new MIPEncodedVideoMessage(MIPENCODEDVIDEOMESSAGE_TYPE_H263P, 0, 0, MIPSharedBuffer<uint8_t>::create(pData, totalSize), totalSize);
 				
 					messages.push_back(pVidMsg);
 					timestamps.push_back(timestamp);
@@ -508,7 +508,7 @@ void MIPRTPJPEGDecoder::processJPEGParts(const std::vector<uint8_t *> &parts, co
 			receiveTime = receiveTimes[i];
 	}
 
-	MIPEncodedVideoMessage *pVidMsg = new MIPEncodedVideoMessage(MIPENCODEDVIDEOMESSAGE_TYPE_JPEG, 0, 0, pFrameBuffer, bytesWritten, true);
+	MIPEncodedVideoMessage *pVidMsg = new MIPEncodedVideoMessage(MIPENCODEDVIDEOMESSAGE_TYPE_JPEG, 0, 0, MIPSharedBuffer<uint8_t>::create(pFrameBuffer, bytesWritten), bytesWritten);
 
 	pVidMsg->setReceiveTime(receiveTime);
 
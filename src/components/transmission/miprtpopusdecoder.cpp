@@ -60,10 +60,10 @@ bool MIPRTPOpusDecoder::validatePacket(const RTPPacket *pRTPPack, real_t &timest
 void MIPRTPOpusDecoder::createNewMessages(const RTPPacket *pRTPPack, std::list<MIPMediaMessage *> &messages, std::list<uint32_t> &timestamps)
 {
 	size_t length = pRTPPack->GetPayloadLength();
-	uint8_t *pData = new uint8_t [length];
+	MIPSharedBuffer<uint8_t> *pBuffer = getPayloadBuffer(length);
 	
-	memcpy(pData, pRTPPack->GetPayloadData(), length);
-	MIPEncodedAudioMessage *pEncMsg = new MIPEncodedAudioMessage(MIPENCODEDAUDIOMESSAGE_TYPE_OPUS, -1, 1, -1, pData, length, true);
+	memcpy(pBuffer->getData(), pRTPPack->GetPayloadData(), length);
+	MIPEncodedAudioMessage *pEncMsg = new MIPEncodedAudioMessage(MIPENCODEDAUDIOMESSAGE_TYPE_OPUS, -1, 1, -1, pBuffer, length);
 
 	messages.push_back(pEncMsg);
 	timestamps.push_back(pRTPPack->GetTimestamp());
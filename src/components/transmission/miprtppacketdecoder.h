@@ -32,6 +32,7 @@
 
 #include "mipconfig.h"
 #include "miptypes.h"
+#include "mipsharedbuffer.h"
 #include <list>
 
 namespace jrtplib
@@ -45,8 +46,8 @@ class MIPMediaMessage;
 class EMIPLIB_IMPORTEXPORT MIPRTPPacketDecoder
 {
 public:
-	MIPRTPPacketDecoder()									{ }
-	virtual ~MIPRTPPacketDecoder()								{ }
+	MIPRTPPacketDecoder()									{ m_pPayloadPool = MIPSharedBufferPool<uint8_t>::create(); }
+	virtual ~MIPRTPPacketDecoder()								{ m_pPayloadPool->release(); }
 
 	/** Validates an RTP packet and gives information about the timestamp unit of the packet data.
 	 *  This function validates an RTP packet and provides information about the timestamp unit
@@ -66,6 +67,15 @@ public:
 	 */
 	virtual void createNewMessages(const jrtplib::RTPPacket *pRTPPack, std::list<MIPMediaMessage *> &messages, 
 			               std::list<uint32_t> &timestamps) = 0;
+protected:
+	/** Returns a buffer for at least \c length bytes, from a pool owned by this packet decoder.
+	 *  Derived classes can use this function to store the payload of the messages they
+	 *  create in createNewMessages. The buffer is returned to the pool when the last
+	 *  message referring to it is destroyed.
+	 */
+	MIPSharedBuffer<uint8_t> *getPayloadBuffer(size_t length)				{ return m_pPayloadPool->getBuffer(length); }
+private:
+	MIPSharedBufferPool<uint8_t> *m_pPayloadPool;
 };
 
 #endif // MIPRTPPACKETDECODER_H
@@ -166,10 +166,10 @@ void MIPRTPVideoDecoder::createNewMessages(const RTPPacket *pRTPPack, std::list<
 							// TODO: error reporting?
 						}
 						else
-							pVidMsg = new MIPRawYUV420PVideoMessage((int)width, (int)height, pData, true);
+							pVidMsg = new MIPRawYUV420PVideoMessage((int)width, (int)height, MIPSharedBuffer<uint8_t>::create(pData, totalSize));
 					}
 					else // must be H.263 for now
-						pVidMsg = new MIPEncodedVideoMessage(MIPENCODEDVIDEOMESSAGE_TYPE_H263P, (int)width, (int)height, pData, totalSize, true);
+						pVidMsg = new MIPEncodedVideoMessage(MIPENCODEDVIDEOMESSAGE_TYPE_H263P, (int)width, (int)height, MIPSharedBuffer<uint8_t>::create(pData, totalSize), totalSize);
 
 					if (pVidMsg)
 					{
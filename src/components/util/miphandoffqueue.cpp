@@ -0,0 +1,339 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "miphandoffqueue.h"
+#include "mipmediamessage.h"
+#include "mipsystemmessage.h"
+#include <chrono>
+
+#include "mipdebug.h"
+
+#define MIPHANDOFFQUEUE_ERRSTR_ALREADYINIT			"Already initialized"
+#define MIPHANDOFFQUEUE_ERRSTR_NOTINIT				"Not initialized"
+#define MIPHANDOFFQUEUE_ERRSTR_BADCAPACITY			"The capacity must be at least one"
+#define MIPHANDOFFQUEUE_ERRSTR_BADSYSTEMMESSAGE			"Only a MIPSYSTEMMESSAGE_TYPE_ISTIME message is allowed here, media messages should be sent to the sink component"
+#define MIPHANDOFFQUEUE_ERRSTR_PULLNOTSUPPORTED			"Pull is not supported for this component"
+#define MIPHANDOFFQUEUE_ERRSTR_BADMESSAGE			"Only raw or encoded audio or video messages are allowed"
+#define MIPHANDOFFQUEUE_ERRSTR_CANTCREATECOPY			"Unable to create a copy of a message"
+
+MIPHandoffQueue::MIPHandoffQueue() : MIPComponent("MIPHandoffQueue"), m_head(0), m_tail(0), m_producerWaiting(false), m_maxOccupancy(0), m_numDelivered(0), m_numDropped(0)
+{
+	m_init = false;
+	m_capacity = 0;
+	setChainPrivate(true);
+}
+
+MIPHandoffQueue::~MIPHandoffQueue()
+{
+	destroy();
+}
+
+bool MIPHandoffQueue::init(size_t capacity, OverflowPolicy policy, MIPTime blockTimeout)
+{
+	if (m_init)
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_ALREADYINIT);
+		return false;
+	}
+
+	if (capacity < 1)
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_BADCAPACITY);
+		return false;
+	}
+
+	m_capacity = 1;
+	while (m_capacity < capacity)
+		m_capacity <<= 1;
+	m_mask = m_capacity-1;
+
+	m_pRing = new std::atomic<MIPMediaMessage *>[m_capacity];
+	for (size_t i = 0 ; i < m_capacity ; i++)
+		m_pRing[i].store(0, std::memory_order_relaxed);
+	m_head.store(0, std::memory_order_relaxed);
+	m_tail.store(0, std::memory_order_relaxed);
+
+	m_policy = policy;
+	m_blockTimeout = blockTimeout;
+	m_pSinkComp = new SinkComponent(*this);
+	m_msgPos = 0;
+	m_prevIteration = -1;
+	resetStatistics();
+	m_init = true;
+
+	return true;
+}
+
+bool MIPHandoffQueue::destroy()
+{
+	if (!m_init)
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	clearMessages();
+
+	MIPMediaMessage *pMsg;
+
+	while ((pMsg = dequeue()) != 0)
+		delete pMsg;
+
+	delete [] m_pRing;
+	delete m_pSinkComp;
+	m_capacity = 0;
+	m_init = false;
+
+	return true;
+}
+
+MIPComponent *MIPHandoffQueue::getSinkComponent()
+{
+	if (!m_init)
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_NOTINIT);
+		return 0;
+	}
+	return m_pSinkComp;
+}
+
+size_t MIPHandoffQueue::getOccupancy() const
+{
+	uint64_t tail = m_tail.load(std::memory_order_relaxed);
+	uint64_t head = m_head.load(std::memory_order_relaxed);
+
+	return (head > tail)?(size_t)(head-tail):0;
+}
+
+void MIPHandoffQueue::resetStatistics()
+{
+	m_maxOccupancy.store(0, std::memory_order_relaxed);
+	m_numDelivered.store(0, std::memory_order_relaxed);
+	m_numDropped.store(0, std::memory_order_relaxed);
+}
+
+bool MIPHandoffQueue::push(const MIPComponentChain &, int64_t, MIPMessage *pMsg)
+{
+	if (!(pMsg->getMessageType() == MIPMESSAGE_TYPE_SYSTEM && pMsg->getMessageSubtype() == MIPSYSTEMMESSAGE_TYPE_ISTIME))
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_BADSYSTEMMESSAGE);
+		return false;
+	}
+	return true;
+}
+
+bool MIPHandoffQueue::pull(const MIPComponentChain &, int64_t iteration, MIPMessage **pMsg)
+{
+	if (!m_init)
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	takeMessages(iteration);
+
+	if (m_msgPos == m_messages.size())
+	{
+		*pMsg = 0;
+		m_msgPos = 0;
+	}
+	else
+	{
+		*pMsg = m_messages[m_msgPos];
+		m_msgPos++;
+	}
+	return true;
+}
+
+bool MIPHandoffQueue::pullBatch(const MIPComponentChain &, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages)
+{
+	if (!m_init)
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	takeMessages(iteration);
+
+	numMessages = m_messages.size();
+	pMessages = (numMessages == 0)?0:&(m_messages[0]);
+	return true;
+}
+
+void MIPHandoffQueue::takeMessages(int64_t iteration)
+{
+	if (iteration == m_prevIteration)
+		return;
+	m_prevIteration = iteration;
+
+	clearMessages();
+
+	// Only take what is available now, so that a fast producer can't keep
+	// this iteration going
+	uint64_t head = m_head.load(std::memory_order_acquire);
+	MIPMediaMessage *pMsg;
+
+	while (m_tail.load(std::memory_order_relaxed) < head && (pMsg = dequeue()) != 0)
+		m_messages.push_back(pMsg);
+
+	m_numDelivered.fetch_add((int64_t)m_messages.size(), std::memory_order_relaxed);
+
+	// Taking the mutex makes sure that a producer which is about to wait
+	// doesn't miss the notification
+	if (!m_messages.empty() && m_policy == Block)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_producerWaiting.load(std::memory_order_seq_cst))
+		{
+			std::lock_guard<std::mutex> guard(m_roomMutex);
+			m_roomCond.notify_one();
+		}
+	}
+}
+
+void MIPHandoffQueue::clearMessages()
+{
+	for (size_t i = 0 ; i < m_messages.size() ; i++)
+		delete m_messages[i];
+	m_messages.clear();
+	m_msgPos = 0;
+}
+
+bool MIPHandoffQueue::enqueue(MIPMediaMessage *pMsg)
+{
+	uint64_t head = m_head.load(std::memory_order_relaxed);
+	uint64_t tail = m_tail.load(std::memory_order_acquire);
+
+	if (head-tail >= m_capacity)
+	{
+		if (m_policy == DropNewest)
+			return false;
+
+		if (m_policy == Block)
+		{
+			if (!waitForRoom(head))
+				return false;
+			tail = m_tail.load(std::memory_order_acquire);
+		}
+		else // DropOldest
+		{
+			// Claim the oldest message by advancing the tail ourselves; if the consumer
+			// advanced it first, there's room now
+			while (head-tail >= m_capacity)
+			{
+				MIPMediaMessage *pOldest = m_pRing[tail&m_mask].load(std::memory_order_relaxed);
+
+				if (m_tail.compare_exchange_weak(tail, tail+1, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					delete pOldest;
+					m_numDropped.fetch_add(1, std::memory_order_relaxed);
+					tail++;
+				}
+			}
+		}
+	}
+
+	m_pRing[head&m_mask].store(pMsg, std::memory_order_relaxed);
+	m_head.store(head+1, std::memory_order_release);
+
+	size_t occupancy = (size_t)(head+1-tail);
+	size_t maxOccupancy = m_maxOccupancy.load(std::memory_order_relaxed);
+
+	while (occupancy > maxOccupancy && !m_maxOccupancy.compare_exchange_weak(maxOccupancy, occupancy, std::memory_order_relaxed))
+		;
+	return true;
+}
+
+bool MIPHandoffQueue::waitForRoom(uint64_t head)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(m_blockTimeout.getValue());
+	std::unique_lock<std::mutex> lock(m_roomMutex);
+	bool room;
+
+	// The consuming chain checks the flag after advancing the tail, so
+	// either it sees the flag, or the new tail is seen here
+	m_producerWaiting.store(true, std::memory_order_seq_cst);
+	while (!(room = (head-m_tail.load(std::memory_order_seq_cst) < m_capacity)))
+	{
+		if (m_roomCond.wait_until(lock, deadline) == std::cv_status::timeout)
+		{
+			room = (head-m_tail.load(std::memory_order_seq_cst) < m_capacity);
+			break;
+		}
+	}
+	m_producerWaiting.store(false, std::memory_order_relaxed);
+	return room;
+}
+
+MIPMediaMessage *MIPHandoffQueue::dequeue()
+{
+	uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		if (tail >= m_head.load(std::memory_order_acquire))
+			return 0;
+
+		MIPMediaMessage *pMsg = m_pRing[tail&m_mask].load(std::memory_order_relaxed);
+
+		// The producer may have claimed this one for the DropOldest policy
+		if (m_tail.compare_exchange_weak(tail, tail+1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			return pMsg;
+	}
+}
+
+bool MIPHandoffQueue::SinkComponent::push(const MIPComponentChain &, int64_t, MIPMessage *pMsg)
+{
+	uint32_t msgType = pMsg->getMessageType();
+
+	if (!(msgType == MIPMESSAGE_TYPE_AUDIO_RAW || msgType == MIPMESSAGE_TYPE_AUDIO_ENCODED ||
+	      msgType == MIPMESSAGE_TYPE_VIDEO_RAW || msgType == MIPMESSAGE_TYPE_VIDEO_ENCODED) )
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_BADMESSAGE);
+		return false;
+	}
+
+	MIPMediaMessage *pNewMsg = ((MIPMediaMessage *)pMsg)->createCopy();
+
+	if (pNewMsg == 0)
+	{
+		setErrorString(MIPHANDOFFQUEUE_ERRSTR_CANTCREATECOPY);
+		return false;
+	}
+
+	if (!m_queue.enqueue(pNewMsg))
+	{
+		delete pNewMsg;
+		m_queue.m_numDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+	return true;
+}
+
+bool MIPHandoffQueue::SinkComponent::pull(const MIPComponentChain &, int64_t, MIPMessage **)
+{
+	setErrorString(MIPHANDOFFQUEUE_ERRSTR_PULLNOTSUPPORTED);
+	return false;
+}
+
@@ -0,0 +1,161 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file miphandoffqueue.h
+ */
+
+#ifndef MIPHANDOFFQUEUE_H
+
+#define MIPHANDOFFQUEUE_H
+
+#include "mipconfig.h"
+#include "mipcomponent.h"
+#include "miptime.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+class MIPMediaMessage;
+
+/** Passes media messages from one chain to another without locking.
+ *  This component, together with its internal 'sink component', allows messages to be
+ *  handed from one chain to another, so that for example capture, encoding and network
+ *  I/O can run in separate threads. The sink component is placed in the producing chain
+ *  and accepts raw and encoded audio and video messages, of which it stores copies in a
+ *  bounded single-producer/single-consumer ring buffer. The main component is placed in
+ *  the consuming chain: each iteration, it takes the messages which have arrived in the
+ *  ring buffer and passes them on in the order in which they were received; it only accepts
+ *  MIPSYSTEMMESSAGE_TYPE_ISTIME messages itself. The consuming
+ *  chain can be driven by its own timer, or by a MIPInterChainTimer which is triggered
+ *  from the producing chain.
+ *
+ *  Only atomic operations are used to access the ring buffer. Since each of the two
+ *  components is used by a single chain, both are marked as chain-private (see
+ *  MIPComponent::setChainPrivate), so that no component locks are needed either.
+ *  What happens when the ring buffer is full is determined by the overflow policy.
+ *  Only when the producing chain has to wait for room, with the Block policy, a 
+ *  mutex and condition variable are used to let the consuming chain wake it up.
+ */
+class EMIPLIB_IMPORTEXPORT MIPHandoffQueue : public MIPComponent
+{
+public:
+	/** Determines what happens when the ring buffer is full. */
+	enum OverflowPolicy
+	{
+		/** The new message is discarded. */
+		DropNewest,
+		/** The oldest message which was not taken by the consuming chain yet is discarded. */
+		DropOldest,
+		/** The producing chain waits until there is room again, but at most the block timeout
+		 *  specified in MIPHandoffQueue::init; after that, the new message is discarded. */
+		Block
+	};
+
+	MIPHandoffQueue();
+	~MIPHandoffQueue();
+
+	/** Initializes the component.
+	 *  \param capacity The number of messages the ring buffer can hold; this is rounded up
+	 *                  to a power of two.
+	 *  \param policy Determines what happens to new messages when the ring buffer is full.
+	 *  \param blockTimeout For the MIPHandoffQueue::Block policy, the maximum amount of time
+	 *                      the producing chain waits for room in the ring buffer.
+	 */
+	bool init(size_t capacity, OverflowPolicy policy = DropOldest, MIPTime blockTimeout = MIPTime(0.1));
+
+	/** De-initializes the component; neither chain should be using it anymore. */
+	bool destroy();
+
+	/** Returns a pointer to the internal 'sink component', to be used in the producing chain. */
+	MIPComponent *getSinkComponent();
+
+	/** Returns the number of messages the ring buffer can hold. */
+	size_t getCapacity() const									{ return m_capacity; }
+
+	/** Returns the number of messages currently in the ring buffer. */
+	size_t getOccupancy() const;
+
+	/** Returns the largest number of messages that have been in the ring buffer at once. */
+	size_t getMaximumOccupancy() const								{ return m_maxOccupancy.load(std::memory_order_relaxed); }
+
+	/** Returns the number of messages which have been passed on to the consuming chain. */
+	int64_t getNumberOfDeliveredMessages() const							{ return m_numDelivered.load(std::memory_order_relaxed); }
+
+	/** Returns the number of messages which were discarded because the ring buffer was full. */
+	int64_t getNumberOfDroppedMessages() const							{ return m_numDropped.load(std::memory_order_relaxed); }
+
+	/** Clears the maximum occupancy and the message counters. */
+	void resetStatistics();
+
+	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
+	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	bool supportsPullBatch() const									{ return true; }
+	bool pullBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages);
+private:
+	class SinkComponent : public MIPComponent
+	{
+	public:
+		SinkComponent(MIPHandoffQueue &queue) : MIPComponent("MIPHandoffQueue::SinkComponent"), m_queue(queue)	{ setChainPrivate(true); }
+		~SinkComponent()									{ }
+
+		bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg);
+		bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg);
+	private:
+		MIPHandoffQueue &m_queue;
+	};
+
+	bool enqueue(MIPMediaMessage *pMsg);
+	bool waitForRoom(uint64_t head);
+	MIPMediaMessage *dequeue();
+	void takeMessages(int64_t iteration);
+	void clearMessages();
+
+	bool m_init;
+	SinkComponent *m_pSinkComp;
+	OverflowPolicy m_policy;
+	MIPTime m_blockTimeout;
+
+	// The producing chain only advances the head; the tail is advanced by the 
+	// consuming chain, and, for the DropOldest policy, by the producing chain as well
+	std::atomic<MIPMediaMessage *> *m_pRing;
+	size_t m_capacity, m_mask;
+	std::atomic<uint64_t> m_head, m_tail;
+
+	// Used by the Block policy only, for a producing chain waiting for room
+	std::mutex m_roomMutex;
+	std::condition_variable m_roomCond;
+	std::atomic<bool> m_producerWaiting;
+
+	std::atomic<size_t> m_maxOccupancy;
+	std::atomic<int64_t> m_numDelivered, m_numDropped;
+
+	std::vector<MIPMessage *> m_messages;
+	size_t m_msgPos;
+	int64_t m_prevIteration;
+};
+
+#endif // MIPHANDOFFQUEUE_H
+
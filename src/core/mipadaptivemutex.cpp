@@ -0,0 +1,76 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipadaptivemutex.h"
+#include <thread>
+#include <algorithm>
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif // _MSC_VER
+
+#include "mipdebug.h"
+
+#define MIPADAPTIVEMUTEX_MAXSPINS				100
+
+static inline void relaxProcessor()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_ia32_pause();
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	_mm_pause();
+#endif
+}
+
+static int getMaximumSpins()
+{
+	// Spinning only makes sense if the thread holding the lock can run at the same time
+	static const int maxSpins = (std::thread::hardware_concurrency() == 1)?0:MIPADAPTIVEMUTEX_MAXSPINS;
+
+	return maxSpins;
+}
+
+void MIPAdaptiveMutex::lockContended()
+{
+	// Like the adaptive mutexes of glibc, we spin for about twice the number of 
+	// attempts that were needed recently, and keep a running average of that number,
+	// which is only updated while holding the lock
+
+	int estimate = m_spinEstimate.load(std::memory_order_relaxed);
+	int maxSpins = std::min(getMaximumSpins(), estimate*2 + 10);
+	int spins = 0;
+	bool locked = false;
+
+	while (!locked && spins < maxSpins)
+	{
+		spins++;
+		relaxProcessor();
+		locked = m_mutex.try_lock();
+	}
+	if (!locked)
+		m_mutex.lock();
+
+	m_spinEstimate.store(estimate + (spins - estimate)/8, std::memory_order_relaxed);
+}
+
@@ -0,0 +1,70 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipadaptivemutex.h
+ */
+
+#ifndef MIPADAPTIVEMUTEX_H
+
+#define MIPADAPTIVEMUTEX_H
+
+#include "mipconfig.h"
+#include <mutex>
+#include <atomic>
+
+/** Mutex which briefly spins before blocking when it is contended.
+ *  This is the lock used by MIPComponent. An uncontended lock or unlock only takes a
+ *  single atomic operation. When the mutex is held by another thread, the calling thread
+ *  first keeps trying for a while before it goes to sleep, since the sections protected
+ *  by a component lock are usually short. How long it spins adapts to how long it took
+ *  to acquire the lock before, and on a single processor system it doesn't spin at all.
+ *  The mutex is not recursive.
+ */
+class EMIPLIB_IMPORTEXPORT MIPAdaptiveMutex
+{
+public:
+	MIPAdaptiveMutex() : m_spinEstimate(0)								{ }
+	~MIPAdaptiveMutex()										{ }
+
+	/** Acquires the mutex. */
+	void lock()											{ if (!m_mutex.try_lock()) lockContended(); }
+
+	/** Acquires the mutex only if this is possible without waiting, returning true in that case. */
+	bool tryLock()											{ return m_mutex.try_lock(); }
+
+	/** Releases the mutex. */
+	void unlock()											{ m_mutex.unlock(); }
+private:
+	MIPAdaptiveMutex(const MIPAdaptiveMutex &)							{ }
+	MIPAdaptiveMutex &operator=(const MIPAdaptiveMutex &)						{ return *this; }
+
+	void lockContended();
+
+	std::mutex m_mutex;
+	std::atomic<int> m_spinEstimate;
+};
+
+#endif // MIPADAPTIVEMUTEX_H
+
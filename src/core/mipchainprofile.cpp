@@ -0,0 +1,94 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipchainprofile.h"
+#include <cmath>
+
+#include "mipdebug.h"
+
+void MIPDurationStatistics::reset()
+{
+	m_count = 0;
+	m_total = 0;
+	m_minimum = 0;
+	m_maximum = 0;
+	for (int i = 0 ; i < NumBins ; i++)
+		m_bins[i] = 0;
+}
+
+void MIPDurationStatistics::add(real_t seconds)
+{
+	if (seconds < 0)
+		seconds = 0;
+
+	if (m_count == 0 || seconds < m_minimum)
+		m_minimum = seconds;
+	if (seconds > m_maximum)
+		m_maximum = seconds;
+	m_total += seconds;
+	m_count++;
+
+	real_t microSeconds = seconds*1000000.0;
+	int bin = 0;
+
+	if (microSeconds > 1.0)
+	{
+		bin = (int)(std::log2((double)microSeconds)*4.0);
+		if (bin >= NumBins)
+			bin = NumBins-1;
+	}
+	m_bins[bin]++;
+}
+
+MIPTime MIPDurationStatistics::getPercentile(real_t p) const
+{
+	if (m_count == 0)
+		return MIPTime(0);
+
+	int64_t target = (int64_t)std::ceil((double)(p*(real_t)m_count));
+	int64_t sum = 0;
+
+	if (target < 1)
+		target = 1;
+
+	for (int i = 0 ; i < NumBins ; i++)
+	{
+		sum += m_bins[i];
+		if (sum >= target)
+		{
+			// Use the upper boundary of the bin, but don't exceed the
+			// values that were actually observed
+			real_t t = std::pow(2.0, (double)(i+1)/4.0)/1000000.0;
+
+			if (t > m_maximum)
+				t = m_maximum;
+			if (t < m_minimum)
+				t = m_minimum;
+			return MIPTime(t);
+		}
+	}
+	return MIPTime(m_maximum);
+}
+
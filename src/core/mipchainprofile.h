@@ -0,0 +1,207 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipchainprofile.h
+ */
+
+#ifndef MIPCHAINPROFILE_H
+
+#define MIPCHAINPROFILE_H
+
+#include "mipconfig.h"
+#include "miptime.h"
+#include "miptypes.h"
+#include <string>
+#include <vector>
+
+class MIPComponent;
+
+/** Keeps track of the distribution of a series of durations.
+ *  Apart from the minimum, maximum and average value, the durations are also
+ *  stored in a logarithmic histogram (four bins per power of two, starting at
+ *  one microsecond), from which percentiles can be estimated.
+ */
+class EMIPLIB_IMPORTEXPORT MIPDurationStatistics
+{
+public:
+	MIPDurationStatistics()										{ reset(); }
+
+	/** Clears all information. */
+	void reset();
+
+	/** Adds a duration, expressed in seconds. */
+	void add(real_t seconds);
+
+	/** Returns the number of durations that have been added. */
+	int64_t getCount() const									{ return m_count; }
+
+	/** Returns the sum of all durations. */
+	MIPTime getTotal() const									{ return MIPTime(m_total); }
+
+	/** Returns the smallest duration, or zero if none were added. */
+	MIPTime getMinimum() const									{ return MIPTime((m_count > 0)?m_minimum:0); }
+
+	/** Returns the largest duration, or zero if none were added. */
+	MIPTime getMaximum() const									{ return MIPTime(m_maximum); }
+
+	/** Returns the average duration, or zero if none were added. */
+	MIPTime getAverage() const									{ return MIPTime((m_count > 0)?(m_total/(real_t)m_count):0); }
+
+	/** Returns an estimate of the duration below which a fraction \c p of the
+	 *  durations lies, based on the histogram. */
+	MIPTime getPercentile(real_t p) const;
+
+	/** Returns an estimate of the 99th percentile. */
+	MIPTime get99thPercentile() const								{ return getPercentile(0.99); }
+private:
+	enum { NumBins = 96 };
+
+	int64_t m_count;
+	real_t m_total, m_minimum, m_maximum;
+	uint32_t m_bins[NumBins];
+};
+
+/** Profiling information of a component chain.
+ *  An instance of this class can be obtained by calling MIPComponentChain::getProfile
+ *  or through MIPComponentChain::onProfileReport, when profiling is enabled using
+ *  MIPComponentChain::setProfiling. All durations are measured per iteration of the
+ *  chain: if a component's MIPComponent::push function is called several times in
+ *  one iteration, the sum of these calls is added to its statistics.
+ */
+class EMIPLIB_IMPORTEXPORT MIPChainProfile
+{
+public:
+	/** Profiling information about a single component. */
+	class EMIPLIB_IMPORTEXPORT ComponentInfo
+	{
+	public:
+		ComponentInfo(const MIPComponent *pComp, const std::string &name)			{ m_pComponent = pComp; m_name = name; }
+
+		/** Returns a pointer to the component this information refers to. */
+		const MIPComponent *getComponent() const						{ return m_pComponent; }
+
+		/** Returns the name of the component. */
+		std::string getComponentName() const							{ return m_name; }
+
+		/** Returns the time spent in MIPComponent::push in each iteration. */
+		const MIPDurationStatistics &getPushStatistics() const					{ return m_push; }
+
+		/** Returns the time spent in MIPComponent::pull in each iteration. */
+		const MIPDurationStatistics &getPullStatistics() const					{ return m_pull; }
+
+		/** Returns the time spent in MIPComponent::processFeedback in each iteration. */
+		const MIPDurationStatistics &getFeedbackStatistics() const				{ return m_feedback; }
+
+		/** Returns the total time spent in the component in each iteration. */
+		const MIPDurationStatistics &getTotalStatistics() const					{ return m_totalTime; }
+	private:
+		friend class MIPComponentChain;
+
+		const MIPComponent *m_pComponent;
+		std::string m_name;
+		MIPDurationStatistics m_push, m_pull, m_feedback, m_totalTime;
+	};
+
+	/** Profiling information about a single connection in the chain. */
+	class EMIPLIB_IMPORTEXPORT ConnectionInfo
+	{
+	public:
+		ConnectionInfo(const MIPComponent *pPull, const std::string &pullName,
+		               const MIPComponent *pPush, const std::string &pushName)			{ m_pPull = pPull; m_pullName = pullName; m_pPush = pPush; m_pushName = pushName; 
+													  m_numMessages = 0; m_minMessages = 0; m_maxMessages = 0; }
+
+		/** Returns the component from which messages are pulled. */
+		const MIPComponent *getPullComponent() const						{ return m_pPull; }
+
+		/** Returns the name of the component from which messages are pulled. */
+		std::string getPullComponentName() const						{ return m_pullName; }
+
+		/** Returns the component to which messages are pushed. */
+		const MIPComponent *getPushComponent() const						{ return m_pPush; }
+
+		/** Returns the name of the component to which messages are pushed. */
+		std::string getPushComponentName() const						{ return m_pushName; }
+
+		/** Returns the time needed to process this connection in each iteration. 
+		 *  In serial mode this includes both the pull and the push calls; when the
+		 *  chain uses worker threads (see MIPComponentChain::setNumberOfWorkerThreads),
+		 *  messages can be pulled once for several connections, and only the push
+		 *  calls are included. */
+		const MIPDurationStatistics &getDurationStatistics() const				{ return m_duration; }
+
+		/** Returns the total number of messages that were passed over the connection. */
+		int64_t getNumberOfMessages() const							{ return m_numMessages; }
+
+		/** Returns the smallest number of messages passed in a single iteration. */
+		int64_t getMinimumMessagesPerIteration() const						{ return m_minMessages; }
+
+		/** Returns the largest number of messages passed in a single iteration. */
+		int64_t getMaximumMessagesPerIteration() const						{ return m_maxMessages; }
+
+		/** Returns the average number of messages passed per iteration. */
+		real_t getAverageMessagesPerIteration() const						{ int64_t n = m_duration.getCount(); return (n > 0)?((real_t)m_numMessages/(real_t)n):0; }
+	private:
+		friend class MIPComponentChain;
+
+		const MIPComponent *m_pPull, *m_pPush;
+		std::string m_pullName, m_pushName;
+		MIPDurationStatistics m_duration;
+		int64_t m_numMessages, m_minMessages, m_maxMessages;
+	};
+
+	MIPChainProfile()										{ }
+
+	/** Returns the number of iterations for which information was gathered. */
+	int64_t getNumberOfIterations() const								{ return m_processing.getCount(); }
+
+	/** Returns the time between the starts of successive iterations, which
+	 *  corresponds to the period of the timing component. */
+	const MIPDurationStatistics &getIntervalStatistics() const					{ return m_interval; }
+
+	/** Returns the time spent by the start component of the chain waiting for the
+	 *  next iteration. */
+	const MIPDurationStatistics &getWaitStatistics() const						{ return m_wait; }
+
+	/** Returns the time needed to process the rest of the chain, including the
+	 *  feedback pass, in each iteration. If this approaches the interval of the 
+	 *  chain, the chain is overloaded. */
+	const MIPDurationStatistics &getProcessingStatistics() const					{ return m_processing; }
+
+	/** Returns information about the components in the chain. */
+	const std::vector<ComponentInfo> &getComponents() const						{ return m_components; }
+
+	/** Returns information about the connections in the chain, in the order
+	 *  in which they are processed. */
+	const std::vector<ConnectionInfo> &getConnections() const					{ return m_connections; }
+private:
+	friend class MIPComponentChain;
+
+	MIPDurationStatistics m_interval, m_wait, m_processing;
+	std::vector<ComponentInfo> m_components;
+	std::vector<ConnectionInfo> m_connections;
+};
+
+#endif // MIPCHAINPROFILE_H
+
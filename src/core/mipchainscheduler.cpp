@@ -0,0 +1,308 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipchainscheduler.h"
+
+#include "mipdebug.h"
+
+#define MIPCHAINSCHEDULER_ERRSTR_ALREADYINIT		"Scheduler is already initialized"
+#define MIPCHAINSCHEDULER_ERRSTR_NOTINIT		"Scheduler is not initialized"
+#define MIPCHAINSCHEDULER_ERRSTR_BADRESOLUTION		"The resolution of the scheduler must be positive"
+#define MIPCHAINSCHEDULER_ERRSTR_CANTSTARTTHREAD	"Can't start the timer thread"
+#define MIPCHAINSCHEDULER_ERRSTR_CANTSTARTWORKERS	"Can't start the worker threads: "
+#define MIPCHAINSCHEDULER_ERRSTR_TASKSCHEDULED		"The task is already scheduled"
+
+MIPChainScheduler::MIPChainScheduler()
+{
+	m_init = false;
+	m_stopTimer = false;
+	m_pTimerThread = 0;
+	m_startTime = 0;
+	m_resolution = 0;
+	m_lastTick = 0;
+}
+
+MIPChainScheduler::~MIPChainScheduler()
+{
+	destroy();
+}
+
+bool MIPChainScheduler::init(int numThreads, MIPTime resolution)
+{
+	if (m_init)
+	{
+		setErrorString(MIPCHAINSCHEDULER_ERRSTR_ALREADYINIT);
+		return false;
+	}
+
+	if (resolution.getNanoSeconds() <= 0)
+	{
+		setErrorString(MIPCHAINSCHEDULER_ERRSTR_BADRESOLUTION);
+		return false;
+	}
+
+	if (!m_pool.init(numThreads))
+	{
+		setErrorString(std::string(MIPCHAINSCHEDULER_ERRSTR_CANTSTARTWORKERS) + m_pool.getErrorString());
+		return false;
+	}
+
+	m_wheel.clear();
+	m_wheel.resize(WheelSize);
+	m_resolution = resolution;
+	m_startTime = MIPTime::getCurrentTime();
+	m_lastTick = 0;
+	m_stopTimer = false;
+	m_init = true;
+
+	m_pTimerThread = new TimerThread(*this);
+	if (m_pTimerThread->Start() < 0)
+	{
+		delete m_pTimerThread;
+		m_pTimerThread = 0;
+		destroy();
+		setErrorString(MIPCHAINSCHEDULER_ERRSTR_CANTSTARTTHREAD);
+		return false;
+	}
+
+	return true;
+}
+
+bool MIPChainScheduler::destroy()
+{
+	if (!m_init)
+	{
+		setErrorString(MIPCHAINSCHEDULER_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	if (m_pTimerThread)
+	{
+		m_mutex.lock();
+		m_stopTimer = true;
+		m_mutex.unlock();
+
+		MIPTime startTime = MIPTime::getCurrentTime();
+		while (m_pTimerThread->IsRunning() && (MIPTime::getCurrentTime().getValue() - startTime.getValue()) < 5.0) // wait maximum five seconds
+			MIPTime::wait(MIPTime(0.010));
+
+		if (m_pTimerThread->IsRunning())
+			m_pTimerThread->Kill();
+
+		delete m_pTimerThread;
+		m_pTimerThread = 0;
+	}
+
+	m_pool.destroy();
+
+	for (size_t i = 0 ; i < m_wheel.size() ; i++)
+	{
+		std::list<Task *>::iterator it;
+
+		for (it = m_wheel[i].begin() ; it != m_wheel[i].end() ; it++)
+			(*it)->m_state = Task::Idle;
+	}
+	m_wheel.clear();
+
+	m_init = false;
+	return true;
+}
+
+bool MIPChainScheduler::addTask(Task *pTask, MIPTime t)
+{
+	if (!m_init)
+	{
+		setErrorString(MIPCHAINSCHEDULER_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	std::unique_lock<std::mutex> guard(m_mutex);
+
+	// A removed task may still be finishing in one of the worker threads
+	while (pTask->m_removed && (pTask->m_state == Task::Queued || pTask->m_state == Task::Running))
+		m_stateCond.wait(guard);
+
+	if (pTask->m_state != Task::Idle)
+	{
+		setErrorString(MIPCHAINSCHEDULER_ERRSTR_TASKSCHEDULED);
+		return false;
+	}
+
+	pTask->m_pScheduler = this;
+	pTask->m_removed = false;
+	schedule(pTask, t);
+	return true;
+}
+
+void MIPChainScheduler::removeTask(Task *pTask)
+{
+	std::unique_lock<std::mutex> guard(m_mutex);
+
+	pTask->m_removed = true;
+	if (!m_init) // no threads are left which could use the task
+	{
+		pTask->m_state = Task::Idle;
+		return;
+	}
+
+	if (pTask->m_state == Task::Waiting)
+	{
+		m_wheel[pTask->m_dueTick%WheelSize].erase(pTask->m_wheelPos);
+		pTask->m_state = Task::Idle;
+	}
+
+	while (pTask->m_state == Task::Queued || pTask->m_state == Task::Running)
+		m_stateCond.wait(guard);
+}
+
+int64_t MIPChainScheduler::getCurrentTick() const
+{
+	MIPTime elapsed = MIPTime::getCurrentTime();
+
+	elapsed -= m_startTime;
+	return elapsed.getNanoSeconds()/m_resolution.getNanoSeconds();
+}
+
+// Must be called with the mutex held
+
+void MIPChainScheduler::schedule(Task *pTask, MIPTime t)
+{
+	t -= m_startTime;
+
+	// Round up, so that a task never runs before its time
+	int64_t dueTick = t.getNanoSeconds()/m_resolution.getNanoSeconds();
+
+	if (t.getNanoSeconds() > 0 && t.getNanoSeconds()%m_resolution.getNanoSeconds() != 0)
+		dueTick++;
+
+	if (dueTick <= m_lastTick)
+	{
+		pTask->m_state = Task::Queued;
+		m_pool.submit(pTask, m_group);
+	}
+	else
+	{
+		std::list<Task *> &slot = m_wheel[dueTick%WheelSize];
+
+		pTask->m_state = Task::Waiting;
+		pTask->m_dueTick = dueTick;
+		pTask->m_wheelPos = slot.insert(slot.end(), pTask);
+	}
+}
+
+void MIPChainScheduler::processTicks()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	int64_t curTick = getCurrentTick();
+
+	// Each slot only needs to be visited once, even if we're lagging behind
+	// more than a full turn of the wheel
+	if (curTick - m_lastTick > WheelSize)
+		m_lastTick = curTick - WheelSize;
+
+	while (m_lastTick < curTick)
+	{
+		m_lastTick++;
+
+		std::list<Task *> &slot = m_wheel[m_lastTick%WheelSize];
+		std::list<Task *>::iterator it = slot.begin();
+
+		while (it != slot.end())
+		{
+			Task *pTask = *it;
+
+			if (pTask->m_dueTick <= curTick)
+			{
+				it = slot.erase(it);
+				pTask->m_state = Task::Queued;
+				m_pool.submit(pTask, m_group);
+			}
+			else
+				it++;
+		}
+	}
+}
+
+void MIPChainScheduler::runTask(Task *pTask)
+{
+	MIPTime nextTime;
+	bool again = false;
+
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		if (pTask->m_removed)
+		{
+			pTask->m_state = Task::Idle;
+			m_stateCond.notify_all();
+			return;
+		}
+		pTask->m_state = Task::Running;
+	}
+
+	again = pTask->execute(nextTime);
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	if (again && !pTask->m_removed)
+		schedule(pTask, nextTime);
+	else
+	{
+		pTask->m_state = Task::Idle;
+		m_stateCond.notify_all();
+	}
+}
+
+void MIPChainScheduler::Task::run()
+{
+	m_pScheduler->runTask(this);
+}
+
+void *MIPChainScheduler::TimerThread::Thread()
+{
+	JThread::ThreadStarted();
+
+	bool done = false;
+
+	while (!done)
+	{
+		// Wake up at the start of the next tick, not one tick after the previous
+		// wakeup, so that the processing time does not accumulate
+		int64_t nextTick = m_scheduler.getCurrentTick() + 1;
+
+		MIPTime wakeupTime = m_scheduler.m_startTime;
+
+		wakeupTime += MIPTime::fromNanoSeconds(nextTick*m_scheduler.m_resolution.getNanoSeconds());
+		MIPTime::waitUntil(wakeupTime);
+
+		m_scheduler.processTicks();
+
+		m_scheduler.m_mutex.lock();
+		done = m_scheduler.m_stopTimer;
+		m_scheduler.m_mutex.unlock();
+	}
+	return 0;
+}
+
@@ -0,0 +1,136 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipchainscheduler.h
+ */
+
+#ifndef MIPCHAINSCHEDULER_H
+
+#define MIPCHAINSCHEDULER_H
+
+#include "mipconfig.h"
+#include "miperrorbase.h"
+#include "miptime.h"
+#include "mipworkerpool.h"
+#include <jthread/jthread.h>
+#include <mutex>
+#include <condition_variable>
+#include <list>
+#include <vector>
+
+/** Executes many component chains using a fixed number of threads.
+ *  Normally, each MIPComponentChain uses its own background thread, in which the
+ *  start component of the chain waits until the next iteration should be processed.
+ *  When a large number of chains is used, the number of threads can be reduced
+ *  by registering these chains with a scheduler, using MIPComponentChain::setScheduler.
+ *  The scheduler keeps track of the time at which each chain's next iteration is
+ *  due in a timer wheel, and executes that iteration on one of its worker threads
+ *  once the time has come. The start component of such a chain must be able to tell 
+ *  when the next iteration is due, see MIPComponent::getIterationStartTime; this is
+ *  the case for MIPAverageTimer. Timing is accurate up to the resolution specified
+ *  in MIPChainScheduler::init.
+ */
+class EMIPLIB_IMPORTEXPORT MIPChainScheduler : public MIPErrorBase
+{
+public:
+	/** Base class of the work which can be scheduled, used by MIPComponentChain. */
+	class EMIPLIB_IMPORTEXPORT Task : private MIPWorkerPool::Task
+	{
+	public:
+		Task()											{ m_pScheduler = 0; m_state = Idle; m_removed = false; m_dueTick = 0; }
+		virtual ~Task()										{ }
+
+		/** Implement this to perform the work which is due; if the task should be
+		 *  executed again, the function must return true and store the time at which 
+		 *  this should happen in \c nextTime. */
+		virtual bool execute(MIPTime &nextTime) = 0;
+	private:
+		friend class MIPChainScheduler;
+
+		enum State { Idle, Waiting, Queued, Running };
+
+		void run();
+
+		MIPChainScheduler *m_pScheduler;
+		State m_state;
+		bool m_removed;
+		int64_t m_dueTick;
+		std::list<Task *>::iterator m_wheelPos;
+	};
+
+	MIPChainScheduler();
+	~MIPChainScheduler();
+
+	/** Starts the scheduler.
+	 *  \param numThreads The number of worker threads which execute the scheduled work.
+	 *  \param resolution The tick interval of the timer wheel.
+	 */
+	bool init(int numThreads, MIPTime resolution = MIPTime(0.001));
+
+	/** Stops the scheduler; all chains using it must have been stopped first. */
+	bool destroy();
+
+	/** Returns \c true if the scheduler has been initialized. */
+	bool isInit() const										{ return m_init; }
+
+	/** Schedules \c pTask for execution at time \c t. */
+	bool addTask(Task *pTask, MIPTime t);
+
+	/** Makes sure that \c pTask is no longer executed, waiting for it to finish
+	 *  if it is running. This must not be called from within the task itself. */
+	void removeTask(Task *pTask);
+private:
+	class TimerThread : public jthread::JThread
+	{
+	public:
+		TimerThread(MIPChainScheduler &scheduler) : m_scheduler(scheduler)			{ }
+		~TimerThread()										{ }
+	private:
+		void *Thread();
+
+		MIPChainScheduler &m_scheduler;
+	};
+
+	enum { WheelSize = 512 };
+
+	void schedule(Task *pTask, MIPTime t);
+	void runTask(Task *pTask);
+	void processTicks();
+	int64_t getCurrentTick() const;
+
+	bool m_init;
+	bool m_stopTimer;
+	MIPWorkerPool m_pool;
+	MIPWorkerPool::TaskGroup m_group;
+	TimerThread *m_pTimerThread;
+	MIPTime m_startTime, m_resolution;
+	int64_t m_lastTick;
+	std::vector<std::list<Task *> > m_wheel;
+	std::mutex m_mutex;
+	std::condition_variable m_stateCond;
+};
+
+#endif // MIPCHAINSCHEDULER_H
+
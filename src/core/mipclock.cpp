@@ -0,0 +1,76 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipclock.h"
+
+#include "mipdebug.h"
+
+MIPClock &MIPClock::getRealTimeClock()
+{
+	static MIPRealTimeClock realTimeClock;
+
+	return realTimeClock;
+}
+
+void MIPClock::waitUntil(MIPTime deadline)
+{
+	MIPTime delay = deadline;
+
+	delay -= getCurrentTime();
+	wait(delay);
+}
+
+MIPTime MIPVirtualClock::getCurrentTime() const
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	return m_time;
+}
+
+void MIPVirtualClock::wait(MIPTime delay)
+{
+	if (delay.getValue() <= 0)
+		return;
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	m_time += delay;
+}
+
+void MIPVirtualClock::waitUntil(MIPTime deadline)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	if (deadline > m_time)
+		m_time = deadline;
+}
+
+void MIPVirtualClock::setCurrentTime(MIPTime t)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	m_time = t;
+}
+
@@ -0,0 +1,120 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipclock.h
+ */
+
+#ifndef MIPCLOCK_H
+
+#define MIPCLOCK_H
+
+#include "mipconfig.h"
+#include "miptime.h"
+#include <mutex>
+
+/** Source of time used by a component chain.
+ *  Components which need to know the current time or which need to wait for some
+ *  time to elapse, like MIPAverageTimer, should use the clock returned by
+ *  MIPComponentChain::getClock instead of calling MIPTime::getCurrentTime and
+ *  MIPTime::wait directly. By default a chain uses the real-time clock, but this
+ *  can be replaced by a MIPVirtualClock to run a chain as fast as possible.
+ */
+class EMIPLIB_IMPORTEXPORT MIPClock
+{
+public:
+	MIPClock()											{ }
+	virtual ~MIPClock()										{ }
+
+	/** Returns the current time according to this clock. */
+	virtual MIPTime getCurrentTime() const = 0;
+
+	/** Lets the time specified by \c delay elapse. */
+	virtual void wait(MIPTime delay) = 0;
+
+	/** Waits until the current time of this clock has reached \c deadline; by default
+	 *  this calls MIPClock::wait with the remaining time. */
+	virtual void waitUntil(MIPTime deadline);
+
+	/** Returns true if this clock follows the real time. */
+	virtual bool isRealTime() const = 0;
+
+	/** Returns the real-time clock which is used by default. */
+	static MIPClock &getRealTimeClock();
+};
+
+/** Clock which simply uses MIPTime::getCurrentTime, MIPTime::wait and MIPTime::waitUntil. */
+class EMIPLIB_IMPORTEXPORT MIPRealTimeClock : public MIPClock
+{
+public:
+	MIPRealTimeClock() : m_spinTime(0)								{ }
+	~MIPRealTimeClock()										{ }
+
+	MIPTime getCurrentTime() const									{ return MIPTime::getCurrentTime(); }
+	void wait(MIPTime delay)									{ MIPTime::wait(delay); }
+	void waitUntil(MIPTime deadline)								{ MIPTime::waitUntil(deadline, m_spinTime); }
+	bool isRealTime() const										{ return true; }
+
+	/** Sets the amount of time before a deadline at which MIPClock::waitUntil stops sleeping
+	 *  and starts actively waiting (zero by default, see MIPTime::waitUntil). A value of
+	 *  about 100 microseconds is usually enough to reach the deadline accurately. */
+	void setSpinTime(MIPTime spinTime)								{ m_spinTime = spinTime; }
+
+	/** Returns the time set by MIPRealTimeClock::setSpinTime. */
+	MIPTime getSpinTime() const									{ return m_spinTime; }
+private:
+	MIPTime m_spinTime;
+};
+
+/** Clock in which time only advances when someone waits.
+ *  When a chain uses this clock, a call to MIPClock::wait returns immediately after
+ *  having advanced the current time by the requested delay. A chain driven by a 
+ *  MIPAverageTimer will therefore run as fast as the processor allows, while the
+ *  components still see the same timing as when the chain would run in real time.
+ *  This is useful to process recordings offline, or to run a complete chain in a
+ *  test in a deterministic way. Note that components which interact with sound cards,
+ *  network sockets or other chains should not be used in such a chain.
+ */
+class EMIPLIB_IMPORTEXPORT MIPVirtualClock : public MIPClock
+{
+public:
+	/** Creates a virtual clock which starts at \c startTime. */
+	MIPVirtualClock(MIPTime startTime = MIPTime(0)) : m_time(startTime)				{ }
+	~MIPVirtualClock()										{ }
+
+	MIPTime getCurrentTime() const;
+	void wait(MIPTime delay);
+	void waitUntil(MIPTime deadline);
+	bool isRealTime() const										{ return false; }
+
+	/** Sets the current time to \c t; this should not be used to go back in time while
+	 *  a chain is using the clock. */
+	void setCurrentTime(MIPTime t);
+private:
+	mutable std::mutex m_mutex;
+	MIPTime m_time;
+};
+
+#endif // MIPCLOCK_H
+
@@ -30,6 +30,9 @@
 
 #include "mipdebug.h"
 
+#define MIPCOMPONENT_ERRSTR_NOTSCHEDULABLE		"This component can't be used as the start of a scheduled chain"
+#define MIPCOMPONENT_ERRSTR_NOBATCH			"This component doesn't support retrieving its messages at once"
+
 MIPComponent::MIPComponent(const std::string &name)
 {
 
@@ -38,17 +41,45 @@ MIPComponent::MIPComponent(const std::string &name)
 	// already performed by the time we're using threads
 	m_dummy = (uint32_t)MIPTime::getCurrentTime().getSeconds();
 
-	int status;
-	
-	if ((status = m_componentMutex.Init()) < 0)
-	{
-		std::cerr << "Error: can't initialize component mutex (JMutex error code " << status << ")" << std::endl;
-		exit(-1);
-	}
 	m_componentName = name;
+	m_chainPrivate = false;
+	m_pVerifiedChain = 0;
 }
 
 MIPComponent::~MIPComponent()
 {
 }
 
+
+bool MIPComponent::getIterationStartTime(const MIPComponentChain &, int64_t, MIPTime &)
+{
+	setErrorString(MIPCOMPONENT_ERRSTR_NOTSCHEDULABLE);
+	return false;
+}
+
+bool MIPComponent::pullBatch(const MIPComponentChain &, int64_t, MIPMessage * const *&, size_t &)
+{
+	setErrorString(MIPCOMPONENT_ERRSTR_NOBATCH);
+	return false;
+}
+
+bool MIPComponent::pushBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *pMessages, size_t numMessages)
+{
+	for (size_t i = 0 ; i < numMessages ; i++)
+	{
+		if (!push(chain, iteration, pMessages[i]))
+			return false;
+	}
+	return true;
+}
+
+bool MIPComponent::getInputMessageFormats(std::vector<MIPMessageFormat> &) const
+{
+	return false;
+}
+
+bool MIPComponent::getOutputMessageFormats(std::vector<MIPMessageFormat> &) const
+{
+	return false;
+}
+
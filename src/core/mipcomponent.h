@@ -33,12 +33,16 @@
 #include "mipconfig.h"
 #include "miperrorbase.h"
 #include "miptypes.h"
+#include "mipadaptivemutex.h"
+#include "mipmessageformat.h"
 #include <jthread/jmutex.h>
 #include <string>
+#include <vector>
 
 class MIPComponentChain;
 class MIPMessage;
 class MIPFeedback;
+class MIPTime;
 
 /** Base class of a component which can be placed in a component chain.
  *  This class serves as a base class from which actual components can be derived. A working component
@@ -59,13 +63,28 @@ public:
 	 *  This function locks the component. It is used in the MIPComponentChain background thread
 	 *  to prevent a component being accessed at the same time in different threads.
 	 */
-	virtual void lock()										{ m_componentMutex.Lock(); }
+	virtual void lock()										{ m_componentMutex.lock(); }
 
 	/** Unlocks the current component.
 	 *  This function removes the lock on the current component. It too is used in the MIPComponentChain
 	 *  background thread.
 	 */
-	virtual void unlock()										{ m_componentMutex.Unlock(); }
+	virtual void unlock()										{ m_componentMutex.unlock(); }
+
+	/** Marks the component as being used by a single chain only.
+	 *  A chain locks each component it uses, in case the component is also used by another
+	 *  chain or by the application at the same time. For a component which is marked as 
+	 *  chain-private, the chain skips these locks. When the chain is started or rebuilt,
+	 *  it verifies that such a component is not used by another running chain, nor through
+	 *  a MIPComponentAlias, and otherwise fails. The application itself must not call 
+	 *  MIPComponent::lock to access the component while the chain is running. The setting
+	 *  is taken into account the next time the chain is started or rebuilt; by default a
+	 *  component is not chain-private.
+	 */
+	void setChainPrivate(bool f)									{ m_chainPrivate = f; }
+
+	/** Returns true if the component was marked as chain-private. */
+	bool isChainPrivate() const									{ return m_chainPrivate; }
 
 	/** Feeds a message into the component.
 	 *  This function needs to be implemented by a derived class. It is part of the message passing system
@@ -96,6 +115,31 @@ public:
 	 */
 	virtual bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg) = 0;
 
+	/** Indicates if the component implements MIPComponent::pullBatch.
+	 *  If this function returns true, the chain retrieves all messages of the component
+	 *  for a connection using a single call to MIPComponent::pullBatch instead of calling
+	 *  MIPComponent::pull for each message. The default implementation returns false.
+	 */
+	virtual bool supportsPullBatch() const								{ return false; }
+
+	/** Retrieves all messages the component has available at once.
+	 *  A component which returns true in MIPComponent::supportsPullBatch must implement this
+	 *  function, and should store a pointer to an array of message pointers in \c pMessages,
+	 *  and the number of messages in \c numMessages. The array must remain valid until the
+	 *  component is used again. These are the same messages that would have been returned by
+	 *  successive calls to MIPComponent::pull, but calling this function does not change the
+	 *  position of a pull in progress. The default implementation sets an error and returns false.
+	 */
+	virtual bool pullBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages);
+
+	/** Feeds several messages into the component.
+	 *  The chain uses this function to pass all messages of a connection which were retrieved
+	 *  using MIPComponent::pullBatch at once. The default implementation simply calls
+	 *  MIPComponent::push for each message; a component can reimplement it to avoid the
+	 *  overhead of these calls.
+	 */
+	virtual bool pushBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *pMessages, size_t numMessages);
+
 	/** Add feedback information about this component.
 	 *  If the component implements this function, it can add feedback information to the MIPFeedback object
 	 *  passed as the third argument. As with the push and pull functions, the current chain is also passed
@@ -104,6 +148,61 @@ public:
 	 */
 	virtual bool processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback)			
 													{ return true; }
+	/** Called when a new iteration of a chain starts.
+	 *  The chain calls this function once per iteration, right before it uses the component
+	 *  for the first time in that iteration, with the component already locked. This happens
+	 *  even if no messages will be passed to the component, which makes it a good place
+	 *  to discard the messages of the previous iteration, or to perform timeouts. For the
+	 *  start component of the chain, this is done before the MIPSYSTEMMESSAGE_TYPE_WAITTIME
+	 *  message is sent. If false is returned, the chain stops with an error.
+	 */
+	virtual bool onIterationStart(const MIPComponentChain &, int64_t)				{ return true; }
+
+	/** Called when a component is no longer needed in an iteration of a chain.
+	 *  Counterpart of MIPComponent::onIterationStart: the chain calls this function right 
+	 *  after it has pulled the last messages from or pushed the last messages into the
+	 *  component in this iteration. Note that MIPComponent::processFeedback may still be
+	 *  called afterwards. If false is returned, the chain stops with an error.
+	 */
+	virtual bool onIterationEnd(const MIPComponentChain &, int64_t)				{ return true; }
+
+	/** Indicates if the component has work to do in an iteration of a chain.
+	 *  The chain asks this right before it pulls messages from the component for the first
+	 *  time in an iteration. If false is returned, the component is not pulled in that
+	 *  iteration, and neither are the components which only receive messages from such
+	 *  idle components, directly or further on in the chain. This way part of a chain can
+	 *  be run less often than the chain itself, see for example MIPMultiRateTimer. The
+	 *  iteration hooks are still called for all components. By default, a component is
+	 *  always active.
+	 */
+	virtual bool isActiveInIteration(const MIPComponentChain &, int64_t)				{ return true; }
+
+	/** Returns the time at which an iteration of a scheduled chain should start.
+	 *  When a chain is executed by a MIPChainScheduler (see MIPComponentChain::setScheduler),
+	 *  its start component is not allowed to block while waiting for the next iteration.
+	 *  Instead, the chain calls this function to find out when the iteration with number
+	 *  \c iteration is due, and only sends the MIPSYSTEMMESSAGE_TYPE_WAITTIME message
+	 *  once that time has been reached. A timing component which supports this should
+	 *  store the start time in \c startTime and return true. The default implementation
+	 *  sets an error and returns false.
+	 */
+	virtual bool getIterationStartTime(const MIPComponentChain &chain, int64_t iteration, MIPTime &startTime);
+
+	/** Describes which messages the component accepts in MIPComponent::push.
+	 *  A component which knows this should store the formats in \c formats and return true;
+	 *  the default implementation returns false, indicating that this is not known. When format
+	 *  negotiation is enabled (see MIPComponentChain::setFormatNegotiation), the chain uses this
+	 *  to verify its connections when it is started or rebuilt.
+	 */
+	virtual bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+
+	/** Describes which messages the component can produce in MIPComponent::pull.
+	 *  Counterpart of MIPComponent::getInputMessageFormats, and likewise returns false by
+	 *  default. The formats should reflect the current settings of the component, since
+	 *  messages that are declared but never produced can make the verification fail.
+	 */
+	virtual bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const;
+
 	/** Returns the name of the component.
 	 *  This function returns the name of the component, as it was specified in the constructor.
 	 */
@@ -112,9 +211,23 @@ public:
 	// TODO: is it necessary to explain this in the documentation? Most likely only useful in the
 	//       MIPComponentAlias component
 	virtual const MIPComponent *getComponentPointer() const						{ return this; }
+protected:
+	/** Returns true if all messages which \c chain passes to this component are known to
+	 *  match the formats returned by MIPComponent::getInputMessageFormats.
+	 *  A chain with format negotiation enabled verifies each connection once, when it is
+	 *  started or rebuilt. A component can use this function in MIPComponent::push to skip
+	 *  checking the type, subtype, sampling rate and number of channels of each message.
+	 *  It only returns true for the chain that currently uses the component, so that other
+	 *  chains sharing the component are still checked.
+	 */
+	bool isInputVerified(const MIPComponentChain &chain) const					{ return m_pVerifiedChain == &chain; }
 private:
-	jthread::JMutex m_componentMutex;
+	friend class MIPComponentChain;
+
+	const MIPComponentChain *m_pVerifiedChain;
+	MIPAdaptiveMutex m_componentMutex;
 	std::string m_componentName;
+	bool m_chainPrivate;
 	uint32_t m_dummy;
 };
 
@@ -160,8 +160,20 @@ public:
 	void unlock()												{ m_pComponent->unlock(); MIPComponent::unlock(); }
 	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)				{ bool status = m_pComponent->push(chain, iteration, pMsg); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
 	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg)				{ bool status = m_pComponent->pull(chain, iteration, pMsg); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
+	bool supportsPullBatch() const										{ return m_pComponent->supportsPullBatch(); }
+	bool pullBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages)
+														{ bool status = m_pComponent->pullBatch(chain, iteration, pMessages, numMessages); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
+	bool pushBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *pMessages, size_t numMessages)
+														{ bool status = m_pComponent->pushBatch(chain, iteration, pMessages, numMessages); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
 	bool processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback)	{ bool status = m_pComponent->processFeedback(chain, feedbackChainID, feedback); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
 
+	bool onIterationStart(const MIPComponentChain &chain, int64_t iteration)				{ bool status = m_pComponent->onIterationStart(chain, iteration); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
+	bool onIterationEnd(const MIPComponentChain &chain, int64_t iteration)					{ bool status = m_pComponent->onIterationEnd(chain, iteration); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
+	bool isActiveInIteration(const MIPComponentChain &chain, int64_t iteration)				{ return m_pComponent->isActiveInIteration(chain, iteration); }
+	bool getIterationStartTime(const MIPComponentChain &chain, int64_t iteration, MIPTime &startTime)	{ bool status = m_pComponent->getIterationStartTime(chain, iteration, startTime); if (!status) setErrorString(m_pComponent->getErrorString()); return status; }
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const				{ return m_pComponent->getInputMessageFormats(formats); }
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const				{ return m_pComponent->getOutputMessageFormats(formats); }
+
 	const MIPComponent *getComponentPointer() const								{ return m_pComponent; }
 private:
 	MIPComponent *m_pComponent;
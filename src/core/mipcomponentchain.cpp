@@ -28,8 +28,18 @@
 #include "mipcomponent.h"
 #include "miptime.h"
 #include "mipfeedback.h"
+#include "mipworkerpool.h"
+#include "mipchainscheduler.h"
+#include "mipclock.h"
 #include <cstdlib>
 #include <iostream>
+#include <atomic>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iterator>
+#include <thread>
 
 #include "mipdebug.h"
 
@@ -45,6 +55,183 @@
 #define MIPCOMPONENTCHAIN_ERRSTR_UNUSEDCONNECTION	"Detected an unused connection"
 #define MIPCOMPONENTCHAIN_ERRSTR_CANTMERGEFEEDBACK	"Can't merge multiple feedback chains"
 #define MIPCOMPONENTCHAIN_ERRSTR_CONNECTIONNOTFOUND	"Connection not found"
+#define MIPCOMPONENTCHAIN_ERRSTR_BADNUMTHREADS		"The number of worker threads can't be negative"
+#define MIPCOMPONENTCHAIN_ERRSTR_CANTSTARTWORKERS	"Can't start worker threads: "
+#define MIPCOMPONENTCHAIN_ERRSTR_BADREPORTINTERVAL	"The profile report interval can't be negative"
+#define MIPCOMPONENTCHAIN_ERRSTR_CANTSCHEDULE		"Can't register the chain with the scheduler: "
+#define MIPCOMPONENTCHAIN_ERRSTR_SCHEDULERNEEDSREALTIME	"A scheduler can only be used with the real-time clock"
+#define MIPCOMPONENTCHAIN_ERRSTR_SETTINGSNOTAPPLIED	"Thread settings are not applied when a scheduler is used"
+#define MIPCOMPONENTCHAIN_ERRSTR_BADOVERLOADPARAMS	"Invalid overload protection parameters"
+#define MIPCOMPONENTCHAIN_ERRSTR_PRIVATESHARED		"A chain-private component is used by another chain: "
+#define MIPCOMPONENTCHAIN_ERRSTR_PRIVATEALIAS		"A chain-private component can't be used through an alias: "
+#define MIPCOMPONENTCHAIN_ERRSTR_INCOMPATIBLEFORMATS	"Incompatible message formats on the connection from "
+
+#define MIPCOMPONENTCHAIN_FORMATS_VERIFIED		0
+#define MIPCOMPONENTCHAIN_FORMATS_UNKNOWN		1
+#define MIPCOMPONENTCHAIN_FORMATS_MISMATCH		2
+
+#define MIPCOMPONENTCHAIN_ACTIVITY_NOINPUT		0
+#define MIPCOMPONENTCHAIN_ACTIVITY_HASINPUT		1
+#define MIPCOMPONENTCHAIN_ACTIVITY_ACTIVE		2
+#define MIPCOMPONENTCHAIN_ACTIVITY_IDLE			3
+
+// Connections which pull from the same component and which can be handled
+// by retrieving that component's messages only once, are grouped in a node.
+// Within a node, the connections are grouped per target component, and the
+// targets of a node are processed concurrently.
+
+class MIPComponentChain::ParallelTarget : public MIPWorkerPool::Task
+{
+public:
+	ParallelTarget(ParallelNode &node, MIPComponent *pPushComp, bool lockPush) : m_node(node)
+													{ m_pPushComponent = pPushComp; m_lockPush = lockPush; m_error = false; }
+	void run();
+
+	ParallelNode &m_node;
+	MIPComponent *m_pPushComponent;
+	bool m_lockPush;
+	std::vector<MIPConnection> m_connections;
+	std::vector<int> m_connectionIndices;
+	std::vector<MIPMessage *> m_batchMessages;
+	bool m_error;
+	std::string m_errorComponent, m_errorString;
+};
+
+class MIPComponentChain::ParallelNode : public MIPWorkerPool::Task
+{
+public:
+	ParallelNode(ParallelExecution &exec, MIPComponent *pPullComp, int index) : m_exec(exec)
+													{ m_pPullComponent = pPullComp; m_index = index; m_firstConnection = -1; m_startPull = false; m_endPull = false; m_batchPull = false; m_lockPull = true; m_verifiedPull = false; m_active = true; m_maxPriority = MIPCOMPONENTCHAIN_NOSHEDPRIORITY; m_numDependencies = 0; m_dependenciesLeft = 0; m_error = false; }
+	~ParallelNode();
+	void run();
+	void execute();
+	void addDependency(ParallelNode *pNode);
+	void addConnection(const MIPConnection &conn, const ConnectionStep &step, int connectionIndex);
+
+	ParallelExecution &m_exec;
+	MIPComponent *m_pPullComponent;
+	int m_index;
+	int m_firstConnection;
+	bool m_startPull, m_endPull;
+	bool m_batchPull;
+	bool m_lockPull;
+	bool m_verifiedPull;
+	bool m_active;
+	int m_maxPriority;
+	int m_numDependencies;
+	std::atomic<int> m_dependenciesLeft;
+	std::vector<ParallelNode *> m_dependencies;
+	std::vector<ParallelNode *> m_successors;
+	std::vector<ParallelTarget *> m_targets;
+	std::vector<MIPMessage *> m_messages;
+	MIPWorkerPool::TaskGroup m_targetGroup;
+	bool m_error;
+	std::string m_errorComponent, m_errorString;
+};
+
+class MIPComponentChain::ParallelExecution
+{
+public:
+	ParallelExecution(MIPComponentChain &chain) : m_chain(chain)					{ m_iteration = 0; m_abort = false; m_profiling = false; m_shedPriority = MIPCOMPONENTCHAIN_NOSHEDPRIORITY; }
+	~ParallelExecution()										{ clearNodes(); }
+	void clearNodes();
+	void buildNodes(const std::list<MIPConnection> &orderedList, const std::vector<ConnectionStep> &steps, std::vector<ParallelNode *> &nodes);
+	bool runIteration(int64_t iteration, bool profiling, int shedPriority, std::string &errorComponent, std::string &errorString);
+
+	MIPComponentChain &m_chain;
+	MIPWorkerPool m_pool;
+	MIPWorkerPool::TaskGroup m_group;
+	std::vector<ParallelNode *> m_nodes;
+	int64_t m_iteration;
+	std::atomic<bool> m_abort;
+	bool m_profiling;
+	int m_shedPriority;
+};
+
+// Everything the background thread needs to process the connections. A rebuild
+// prepares a new instance of this in the calling thread, which the background 
+// thread then exchanges with its own state at the start of an iteration. The
+// instance is then left with the previous state, which is freed by the caller.
+
+class MIPComponentChain::CompiledState
+{
+public:
+	CompiledState()											{ m_endStartComponent = false; m_lockStart = true; m_pStart = 0; m_installed = false; }
+	~CompiledState()										{ for (size_t i = 0 ; i < m_nodes.size() ; i++) delete m_nodes[i]; 
+													  for (size_t i = 0 ; i < m_converters.size() ; i++) delete m_converters[i]; }
+
+	std::vector<ConnectionStep> m_steps;
+	std::vector<MIPComponent *> m_feedbackSteps;
+	std::vector<bool> m_feedbackLocks;
+	bool m_endStartComponent;
+	bool m_lockStart;
+	MIPComponent *m_pStart;
+	std::set<const MIPComponent *> m_privateComponents;
+	std::set<const MIPComponent *> m_verifiedComponents;
+	std::vector<MIPComponent *> m_converters;
+	std::list<MIPConnection> m_orderedList;
+	std::list<MIPComponent *> m_feedbackChain;
+	std::vector<ParallelNode *> m_nodes;
+	std::vector<int> m_shedLevels;
+	std::vector<uint8_t> m_initialActivity;
+	bool m_installed;
+};
+
+class MIPComponentChain::ScheduledTask : public MIPChainScheduler::Task
+{
+public:
+	ScheduledTask(MIPComponentChain &chain) : m_chain(chain)					{ m_iteration = 1; }
+	bool execute(MIPTime &nextTime);
+	bool finish(const std::string &errorComponent, const std::string &errorString);
+
+	MIPComponentChain &m_chain;
+	int64_t m_iteration;
+	MIPChainProfile m_profileReport;
+};
+
+// The components used by all running chains, with the number of chains using
+// each one and the chain which uses it as a chain-private component, if any
+
+static std::mutex s_componentUseMutex;
+static std::map<const MIPComponent *, std::pair<int, const MIPComponentChain *> > s_componentUse;
+
+// While profiling, the background thread (and the worker threads) accumulate the
+// times of the current iteration in the m_*Times arrays, which are indexed by
+// component slot or connection index. Different threads only ever write to
+// different entries. At the end of the iteration, these are added to the
+// statistics in m_profile.
+
+class MIPComponentChain::Profiler
+{
+public:
+	enum { UsedForPull = 1, UsedForPush = 2, UsedForFeedback = 4 };
+
+	Profiler();
+	void setEnabled(bool enable, real_t reportInterval, bool resetAfterReport);
+	void build(const std::list<MIPConnection> &orderedList, const std::list<MIPComponent *> &feedbackChain);
+	bool endIteration(real_t startTime, real_t afterStartTime, real_t endTime, MIPChainProfile &report);
+	void getProfile(MIPChainProfile &profile);
+	void reset();
+
+	static real_t getTime()										{ return MIPTime::getCurrentTime().getValue(); }
+
+	std::atomic<bool> m_enabled;
+	std::vector<int> m_pullSlots, m_pushSlots, m_feedbackSlots;
+	std::vector<real_t> m_pullTimes, m_pushTimes, m_feedbackTimes, m_connectionTimes;
+	std::vector<int64_t> m_connectionMessages;
+private:
+	int getSlot(MIPComponent *pComp, std::map<MIPComponent *, int> &slots, const std::vector<MIPChainProfile::ComponentInfo> &oldComponents,
+	            const std::map<const MIPComponent *, size_t> &oldComponentIndex);
+	void clearStatistics();
+
+	jthread::JMutex m_mutex;
+	MIPChainProfile m_profile;
+	std::vector<int> m_componentUsage;
+	bool m_havePrevStart;
+	real_t m_prevStartTime;
+	real_t m_reportInterval, m_lastReportTime;
+	bool m_resetAfterReport;
+};
 
 MIPComponentChain::MIPComponentChain(const std::string &chainName)
 {
@@ -68,16 +255,60 @@ MIPComponentChain::MIPComponentChain(const std::string &chainName)
 	m_chainName = chainName;
 	m_pInputChainStart = 0;
 	m_pInternalChainStart = 0;
+	m_numWorkerThreads = 0;
+	m_pParallelExec = 0;
+	m_pProfiler = new Profiler();
+	m_pScheduler = 0;
+	m_pClock = &MIPClock::getRealTimeClock();
+	m_pActiveScheduler = 0;
+	m_pScheduledTask = 0;
+	m_scheduledRunning = false;
+	m_endStartComponent = false;
+	m_lockStart = true;
+	m_negotiateFormats = false;
+	m_pConverterFactory = 0;
+	m_pPendingState = 0;
+	m_havePendingState = false;
+	m_overloadProtection = false;
+	m_iterationBudget = 0;
+	m_overloadFraction = 0.9;
+	m_recoveryFraction = 0.6;
+	m_recoveryIterations = 50;
+	m_calmIterations = 0;
+	m_numShedLevels = 0;
+	m_shedPriority = MIPCOMPONENTCHAIN_NOSHEDPRIORITY;
 }
 
 MIPComponentChain::~MIPComponentChain()
 {
 	stop();
+
+	// After an error, the scheduled task may still be finishing
+	if (m_pActiveScheduler)
+		m_pActiveScheduler->removeTask(m_pScheduledTask);
+	unregisterComponents(m_usedComponents);
+	for (size_t i = 0 ; i < m_converters.size() ; i++)
+		delete m_converters[i];
+	delete m_pScheduledTask;
+	delete m_pParallelExec;
+	delete m_pProfiler;
 }
 
-bool MIPComponentChain::start()
+bool MIPComponentChain::isRunning()
 {
 	if (JThread::IsRunning())
+		return true;
+
+	m_loopMutex.Lock();
+	bool running = m_scheduledRunning;
+	m_loopMutex.Unlock();
+	
+	return running;
+}
+
+bool MIPComponentChain::start()
+{
+	if (isRunning())
 	{
 		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADRUNNING);
 		return false;
@@ -89,20 +320,97 @@ bool MIPComponentChain::start()
 		return false;
 	}
 
+	if (m_pScheduler && !m_pClock->isRealTime())
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_SCHEDULERNEEDSREALTIME);
+		return false;
+	}
+
 	std::list<MIPConnection> orderedList;
 	std::list<MIPComponent *> feedbackChain;
+	CompiledState state;
 	
 	if (!orderConnections(orderedList))
 		return false;
+	if (m_negotiateFormats && !negotiateFormats(orderedList, state))
+		return false;
 	if (!buildFeedbackList(orderedList, feedbackChain))
 		return false;
 
-	copyConnectionInfo(orderedList, feedbackChain);
+	// A previous run may have ended because of an error, in which case
+	// stop was never called
+	delete m_pParallelExec;
+	m_pParallelExec = 0;
+
+	if (m_numWorkerThreads > 0)
+	{
+		m_pParallelExec = new ParallelExecution(*this);
+		if (!m_pParallelExec->m_pool.init(m_numWorkerThreads))
+		{
+			setErrorString(std::string(MIPCOMPONENTCHAIN_ERRSTR_CANTSTARTWORKERS) + m_pParallelExec->m_pool.getErrorString());
+			delete m_pParallelExec;
+			m_pParallelExec = 0;
+			return false;
+		}
+	}
+
+	std::set<MIPComponent *> components;
+	std::set<const MIPComponent *> usedComponents;
+
+	// A previous run may have ended because of an error as well
+	unregisterComponents(m_usedComponents);
+	m_usedComponents.clear();
+
+	getUsedComponents(orderedList, components);
+	if (!registerComponents(components, usedComponents, state.m_privateComponents))
+		return false;
+	m_usedComponents.swap(usedComponents);
+
+	compileState(orderedList, feedbackChain, state);
+
+	m_chainMutex.Lock();
+	installState(state);
+	m_chainMutex.Unlock();
 
 	m_stopLoop = false;
+	m_threadSettingsReport.clear();
+
+	if (m_pScheduler)
+	{
+		if (!m_threadSettings.isDefault())
+			m_threadSettingsReport.addError(MIPCOMPONENTCHAIN_ERRSTR_SETTINGSNOTAPPLIED);
+
+		if (m_pScheduledTask == 0)
+			m_pScheduledTask = new ScheduledTask(*this);
+		else if (m_pActiveScheduler) // a previous run may still be finishing
+			m_pActiveScheduler->removeTask(m_pScheduledTask);
+
+		m_pScheduledTask->m_iteration = 1;
+		m_pActiveScheduler = m_pScheduler;
+
+		m_loopMutex.Lock();
+		m_scheduledRunning = true;
+		m_loopMutex.Unlock();
+
+		if (!m_pScheduler->addTask(m_pScheduledTask, MIPTime::getCurrentTime()))
+		{
+			m_loopMutex.Lock();
+			m_scheduledRunning = false;
+			m_loopMutex.Unlock();
+
+			setErrorString(std::string(MIPCOMPONENTCHAIN_ERRSTR_CANTSCHEDULE) + m_pScheduler->getErrorString());
+			unregisterComponents(m_usedComponents);
+			m_usedComponents.clear();
+			return false;
+		}
+		return true;
+	}
+
 	if (JThread::Start() < 0)
 	{
 		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_CANTSTARTTHREAD);
+		unregisterComponents(m_usedComponents);
+		m_usedComponents.clear();
 		return false;
 	}
 	return true;
@@ -110,7 +418,7 @@ bool MIPComponentChain::start()
 
 bool MIPComponentChain::stop()
 {
-	if (!JThread::IsRunning())
+	if (!isRunning())
 	{
 		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADNOTRUNNING);
 		return false;
@@ -120,21 +428,45 @@ bool MIPComponentChain::stop()
 	m_stopLoop = true;
 	m_loopMutex.Unlock();
 	
-	MIPTime curTime = MIPTime::getCurrentTime();
-	while (JThread::IsRunning() && (MIPTime::getCurrentTime().getValue() - curTime.getValue()) < 5.0) // wait maximum five seconds
+	if (m_pActiveScheduler)
+	{
+		m_pActiveScheduler->removeTask(m_pScheduledTask);
+		m_pActiveScheduler = 0;
+
+		// If the task did not stop because of an error, we still need to
+		// report that the chain has stopped
+		m_loopMutex.Lock();
+		bool wasRunning = m_scheduledRunning;
+		m_scheduledRunning = false;
+		m_loopMutex.Unlock();
+
+		if (wasRunning)
+			onThreadExit(false, std::string(), std::string());
+	}
+	else
 	{
-		MIPTime::wait(MIPTime(0.010));
+		MIPTime curTime = MIPTime::getCurrentTime();
+		while (JThread::IsRunning() && (MIPTime::getCurrentTime().getValue() - curTime.getValue()) < 5.0) // wait maximum five seconds
+		{
+			MIPTime::wait(MIPTime(0.010));
+		}
+
+		if (JThread::IsRunning())
+			JThread::Kill();
 	}
 
-	if (JThread::IsRunning())
-		JThread::Kill();
+	delete m_pParallelExec;
+	m_pParallelExec = 0;
+
+	unregisterComponents(m_usedComponents);
+	m_usedComponents.clear();
 	
 	return true;
 }
 
 bool MIPComponentChain::rebuild()
 {
-	if (!JThread::IsRunning())
+	if (!isRunning())
 	{
 		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADNOTRUNNING);
 		return false;
@@ -148,17 +480,330 @@ bool MIPComponentChain::rebuild()
 
 	std::list<MIPConnection> orderedList;
 	std::list<MIPComponent *> feedbackChain;
+	CompiledState *pState = new CompiledState();
 	
-	if (!orderConnections(orderedList))
+	if (!orderConnections(orderedList) || 
+	    (m_negotiateFormats && !negotiateFormats(orderedList, *pState)) ||
+	    !buildFeedbackList(orderedList, feedbackChain))
+	{
+		delete pState;
 		return false;
-	if (!buildFeedbackList(orderedList, feedbackChain))
+	}
+
+	std::set<MIPComponent *> components;
+	std::set<const MIPComponent *> usedComponents;
+
+	getUsedComponents(orderedList, components);
+	if (!registerComponents(components, usedComponents, pState->m_privateComponents))
+	{
+		delete pState;
 		return false;
+	}
+
+	compileState(orderedList, feedbackChain, *pState);
+
+	// Hand the new state over to the background thread, which installs it at the
+	// start of the next iteration. Only if the chain stopped in the meantime, we
+	// need to install it ourselves.
+
+	std::unique_lock<std::mutex> guard(m_pendingMutex);
+	bool stopped = false;
+
+	while (m_pPendingState != 0 && !stopped) // another rebuild is in progress
+	{
+		if (m_pendingCond.wait_for(guard, std::chrono::milliseconds(10)) == std::cv_status::timeout)
+			stopped = !isRunning();
+	}
+
+	if (!stopped)
+	{
+		m_pPendingState = pState;
+		m_havePendingState = true;
+
+		while (!pState->m_installed && !stopped)
+		{
+			if (m_pendingCond.wait_for(guard, std::chrono::milliseconds(10)) == std::cv_status::timeout)
+				stopped = !isRunning();
+		}
+
+		if (!pState->m_installed)
+		{
+			m_pPendingState = 0;
+			m_havePendingState = false;
+		}
+	}
+	guard.unlock();
+
+	if (!pState->m_installed)
+	{
+		m_chainMutex.Lock();
+		installState(*pState);
+		m_chainMutex.Unlock();
+	}
+
+	delete pState; // this now contains the previous state
+
+	// Only now the components which were removed are no longer used
+	std::set<const MIPComponent *> removedComponents;
 
-	copyConnectionInfo(orderedList, feedbackChain);
+	std::set_difference(m_usedComponents.begin(), m_usedComponents.end(), usedComponents.begin(), usedComponents.end(),
+	                    std::inserter(removedComponents, removedComponents.begin()));
+	unregisterComponents(removedComponents);
+	m_usedComponents.swap(usedComponents);
 	
 	return true;
 }
 
+bool MIPComponentChain::setNumberOfWorkerThreads(int numThreads)
+{
+	if (isRunning())
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADRUNNING);
+		return false;
+	}
+
+	if (numThreads < 0)
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_BADNUMTHREADS);
+		return false;
+	}
+
+	m_numWorkerThreads = numThreads;
+	return true;
+}
+
+bool MIPComponentChain::setFormatNegotiation(bool enable, MIPMessageConverterFactory *pFactory)
+{
+	if (isRunning())
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADRUNNING);
+		return false;
+	}
+
+	m_negotiateFormats = enable;
+	m_pConverterFactory = pFactory;
+	return true;
+}
+
+bool MIPComponentChain::setScheduler(MIPChainScheduler *pScheduler)
+{
+	if (isRunning())
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADRUNNING);
+		return false;
+	}
+
+	m_pScheduler = pScheduler;
+	return true;
+}
+
+bool MIPComponentChain::setClock(MIPClock *pClock)
+{
+	if (isRunning())
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADRUNNING);
+		return false;
+	}
+
+	m_pClock = (pClock)?pClock:&MIPClock::getRealTimeClock();
+	return true;
+}
+
+bool MIPComponentChain::setThreadSettings(const MIPThreadSettings &settings)
+{
+	if (isRunning())
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_THREADRUNNING);
+		return false;
+	}
+
+	m_threadSettings = settings;
+	return true;
+}
+
+bool MIPComponentChain::setProfiling(bool enable, MIPTime reportInterval, bool resetAfterReport)
+{
+	if (reportInterval.getValue() < 0)
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_BADREPORTINTERVAL);
+		return false;
+	}
+
+	m_pProfiler->setEnabled(enable, reportInterval.getValue(), resetAfterReport);
+	return true;
+}
+
+bool MIPComponentChain::isProfilingEnabled() const
+{
+	return m_pProfiler->m_enabled;
+}
+
+void MIPComponentChain::getProfile(MIPChainProfile &profile) const
+{
+	m_pProfiler->getProfile(profile);
+}
+
+void MIPComponentChain::resetProfile()
+{
+	m_pProfiler->reset();
+}
+
+bool MIPComponentChain::setOverloadProtection(bool enable, MIPTime iterationBudget, real_t overloadFraction,
+                                              real_t recoveryFraction, int recoveryIterations)
+{
+	if (enable && (iterationBudget.getValue() <= 0 || overloadFraction <= 0 || recoveryFraction <= 0 ||
+	               recoveryFraction > overloadFraction || recoveryIterations < 1))
+	{
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_BADOVERLOADPARAMS);
+		return false;
+	}
+
+	m_chainMutex.Lock();
+	m_overloadProtection = enable;
+	m_iterationBudget = iterationBudget.getValue();
+	m_overloadFraction = overloadFraction;
+	m_recoveryFraction = recoveryFraction;
+	m_recoveryIterations = recoveryIterations;
+	m_calmIterations = 0;
+	m_numShedLevels = 0;
+	m_shedPriority = MIPCOMPONENTCHAIN_NOSHEDPRIORITY;
+	m_chainMutex.Unlock();
+	return true;
+}
+
+bool MIPComponentChain::isOverloadProtectionEnabled() const
+{
+	return m_overloadProtection;
+}
+
+void MIPComponentChain::updateOverloadState(real_t processingTime)
+{
+	// Called with the chain mutex locked, at the end of each iteration. One
+	// priority level is shed in each overloaded iteration, while a level is only
+	// restored after the load has been low for a while, to avoid oscillating
+	// between both states
+
+	if (processingTime > m_overloadFraction*m_iterationBudget)
+	{
+		m_calmIterations = 0;
+		if (m_numShedLevels < (int)m_shedLevels.size())
+			m_numShedLevels++;
+	}
+	else if (processingTime < m_recoveryFraction*m_iterationBudget)
+	{
+		if (m_numShedLevels > 0 && ++m_calmIterations >= m_recoveryIterations)
+		{
+			m_calmIterations = 0;
+			m_numShedLevels--;
+		}
+	}
+	else
+		m_calmIterations = 0;
+
+	m_shedPriority = (m_numShedLevels > 0)?m_shedLevels[m_numShedLevels-1]:MIPCOMPONENTCHAIN_NOSHEDPRIORITY;
+}
+
+void MIPComponentChain::getUsedComponents(const std::list<MIPConnection> &orderedList, std::set<MIPComponent *> &components)
+{
+	std::list<MIPConnection>::const_iterator it;
+
+	components.insert(m_pInputChainStart);
+	for (it = orderedList.begin() ; it != orderedList.end() ; it++)
+	{
+		components.insert((*it).getPullComponent());
+		components.insert((*it).getPushComponent());
+	}
+}
+
+bool MIPComponentChain::registerComponents(const std::set<MIPComponent *> &components, std::set<const MIPComponent *> &used,
+                                           std::set<const MIPComponent *> &privateComponents)
+{
+	// An alias locks the component it refers to as well, so that component
+	// is considered to be used by this chain too. Components which were
+	// already registered by this chain stay registered once.
+
+	std::set<MIPComponent *>::const_iterator it;
+	std::set<const MIPComponent *>::const_iterator usedIt;
+
+	for (it = components.begin() ; it != components.end() ; it++)
+	{
+		const MIPComponent *pComp = *it;
+		const MIPComponent *pTarget = pComp->getComponentPointer();
+
+		if (pTarget != pComp)
+		{
+			if (pComp->isChainPrivate() || pTarget->isChainPrivate())
+			{
+				setErrorString(std::string(MIPCOMPONENTCHAIN_ERRSTR_PRIVATEALIAS) + pTarget->getComponentName());
+				return false;
+			}
+			used.insert(pTarget);
+		}
+		used.insert(pComp);
+	}
+
+	const std::set<const MIPComponent *> &alreadyUsed = m_usedComponents;
+	std::lock_guard<std::mutex> guard(s_componentUseMutex);
+
+	for (usedIt = used.begin() ; usedIt != used.end() ; usedIt++)
+	{
+		const MIPComponent *pComp = *usedIt;
+		std::map<const MIPComponent *, std::pair<int, const MIPComponentChain *> >::const_iterator useIt = s_componentUse.find(pComp);
+
+		if (useIt == s_componentUse.end())
+			continue;
+
+		int otherChains = useIt->second.first;
+
+		if (alreadyUsed.find(pComp) != alreadyUsed.end())
+			otherChains--;
+
+		if (otherChains > 0 && (pComp->isChainPrivate() || (useIt->second.second != 0 && useIt->second.second != this)))
+		{
+			setErrorString(std::string(MIPCOMPONENTCHAIN_ERRSTR_PRIVATESHARED) + pComp->getComponentName());
+			return false;
+		}
+	}
+
+	for (usedIt = used.begin() ; usedIt != used.end() ; usedIt++)
+	{
+		const MIPComponent *pComp = *usedIt;
+		std::pair<int, const MIPComponentChain *> &use = s_componentUse[pComp];
+
+		if (alreadyUsed.find(pComp) == alreadyUsed.end())
+			use.first++;
+
+		// Only a component that is used directly can be private
+		if (pComp->isChainPrivate())
+		{
+			use.second = this;
+			privateComponents.insert(pComp);
+		}
+		else
+			use.second = 0;
+	}
+	return true;
+}
+
+void MIPComponentChain::unregisterComponents(const std::set<const MIPComponent *> &components)
+{
+	// The components themselves may no longer exist at this point
+	std::set<const MIPComponent *>::const_iterator usedIt;
+	std::lock_guard<std::mutex> guard(s_componentUseMutex);
+
+	for (usedIt = components.begin() ; usedIt != components.end() ; usedIt++)
+	{
+		std::map<const MIPComponent *, std::pair<int, const MIPComponentChain *> >::iterator useIt = s_componentUse.find(*usedIt);
+
+		if (useIt == s_componentUse.end())
+			continue;
+		if (useIt->second.second == this)
+			useIt->second.second = 0;
+		if (--useIt->second.first == 0)
+			s_componentUse.erase(useIt);
+	}
+}
+
 bool MIPComponentChain::clearChain()
 {
 	m_inputConnections.clear();
@@ -178,7 +823,7 @@ bool MIPComponentChain::setChainStart(MIPComponent *startComponent)
 }
 
 bool MIPComponentChain::addConnection(MIPComponent *pPullComponent, MIPComponent *pPushComponent, bool feedback,
-		                     uint32_t allowedMessageTypes, uint32_t allowedSubmessageTypes)
+		                     uint32_t allowedMessageTypes, uint32_t allowedSubmessageTypes, int priority)
 {
 	if (pPullComponent == 0 || pPushComponent == 0)
 	{
@@ -186,7 +831,7 @@ bool MIPComponentChain::addConnection(MIPComponent *pPullComponent, MIPComponent
 		return false;
 	}
 	
-	m_inputConnections.push_back(MIPConnection(pPullComponent, pPushComponent, feedback, allowedMessageTypes, allowedSubmessageTypes));
+	m_inputConnections.push_back(MIPConnection(pPullComponent, pPushComponent, feedback, allowedMessageTypes, allowedSubmessageTypes, priority));
 	return true;
 }
 
@@ -232,65 +877,176 @@ void *MIPComponentChain::Thread()
 	m_loopMutex.Lock();
 	done = m_stopLoop;
 	m_loopMutex.Unlock();
+
+	// This needs to be done before start returns, so that the report is available then
+	if (!m_threadSettings.isDefault())
+		m_threadSettings.applyToCurrentThread(m_threadSettingsReport);
 	
 	JThread::ThreadStarted();
 	
-	MIPSystemMessage startMsg(MIPSYSTEMMESSAGE_TYPE_WAITTIME);
+	MIPChainProfile profileReport;
 	
 	while (!done && !error)
 	{
-		MIPTime::wait(MIPTime(0,0));
-		m_chainMutex.Lock();
-		m_pInternalChainStart->lock();
-#ifdef MIPDEBUG2
-		std::cout << std::endl << m_chainName << " START " << iteration << std::endl;
-		std::cout << m_chainName << " push start: " << m_pInternalChainStart->getComponentName() << std::endl;
-#endif // MIPDEBUG2
-#ifdef MIPDEBUG3
-		std::cout << std::endl << "I " << iteration << " start in chain \"" << m_chainName << std::endl;
-		std::cout << "    pushing WaitTime to: " << m_pInternalChainStart->getComponentName() << std::endl;
-#endif // MIPDEBUG3
+		// Just give other threads a chance to run; a zero length sleep would be
+		// subject to the timer slack of the thread
+		std::this_thread::yield();
 
-		if (!m_pInternalChainStart->push(*this, iteration, &startMsg))
+		if (!processIteration(iteration, profileReport, errorComponent, errorString))
 		{
 			error = true;
-			errorComponent = m_pInternalChainStart->getComponentName();
-			errorString = m_pInternalChainStart->getErrorString();
-			m_pInternalChainStart->unlock();
-			m_chainMutex.Unlock();
 			break;
 		}
-#ifdef MIPDEBUG2
-		std::cout << m_chainName << " push stop:  " << m_pInternalChainStart->getComponentName() << std::endl;
-#endif // MIPDEBUG2
-		m_pInternalChainStart->unlock();
+		
+		//std::cerr << std::endl;
+		
+		m_loopMutex.Lock();
+		done = m_stopLoop;
+		m_loopMutex.Unlock();
+		iteration++;
 
 #ifdef MIPDEBUG
-	//	MIPTime curTime = MIPTime::getCurrentTime();
+//		MIPTime diff = MIPTime::getCurrentTime();
+//		diff -= curTime;
+//		std::cout << "Loop time: " << diff.getString() << std::endl;
 #endif // MIPDEBUG
-		
-		std::list<MIPConnection>::const_iterator it;
-
-		for (it = m_orderedConnections.begin() ; !error && it != m_orderedConnections.end() ; it++)
-		{
-			MIPComponent *pPullComp = (*it).getPullComponent();
-			MIPComponent *pPushComp = (*it).getPushComponent();
-			uint32_t mask1 = (*it).getMask1();
-			uint32_t mask2 = (*it).getMask2();
-
-			pPullComp->lock();
-			if (pPushComp->getComponentPointer() != pPullComp->getComponentPointer())
-				pPushComp->lock();
-
-			MIPMessage *msg = 0;
+	}
+	
+	onThreadExit(error, errorComponent, errorString);
+	
+#ifdef MIPDEBUG
+	std::cout << "MIPComponentChain::Thread stopped" << std::endl;
+#endif // MIPDEBUG
+	
+	return 0;
+}
+
+bool MIPComponentChain::processIteration(int64_t iteration, MIPChainProfile &profileReport, std::string &errorComponent, std::string &errorString)
+{
+	MIPSystemMessage startMsg(MIPSYSTEMMESSAGE_TYPE_WAITTIME);
+	bool error = false;
+	bool profiling = m_pProfiler->m_enabled;
+	bool reportProfile = false;
+	real_t startTime = 0, afterStartTime = 0, t0 = 0;
+	int shedPriority = 0;
+
+	m_chainMutex.Lock();
+	if (m_havePendingState)
+		applyPendingState();
+	shedPriority = m_shedPriority;
+	m_activity = m_initialActivity;
+	if (profiling)
+		startTime = Profiler::getTime();
+	if (m_lockStart)
+		m_pInternalChainStart->lock();
+#ifdef MIPDEBUG2
+	std::cout << std::endl << m_chainName << " START " << iteration << std::endl;
+	std::cout << m_chainName << " push start: " << m_pInternalChainStart->getComponentName() << std::endl;
+#endif // MIPDEBUG2
+#ifdef MIPDEBUG3
+	std::cout << std::endl << "I " << iteration << " start in chain \"" << m_chainName << std::endl;
+	std::cout << "    pushing WaitTime to: " << m_pInternalChainStart->getComponentName() << std::endl;
+#endif // MIPDEBUG3
+
+	m_pInternalChainStart->m_pVerifiedChain = 0;
+	if (!m_pInternalChainStart->onIterationStart(*this, iteration) || 
+	    !m_pInternalChainStart->push(*this, iteration, &startMsg) ||
+	    (m_endStartComponent && !m_pInternalChainStart->onIterationEnd(*this, iteration)))
+	{
+		error = true;
+		errorComponent = m_pInternalChainStart->getComponentName();
+		errorString = m_pInternalChainStart->getErrorString();
+		if (m_lockStart)
+			m_pInternalChainStart->unlock();
+		m_chainMutex.Unlock();
+		return false;
+	}
+#ifdef MIPDEBUG2
+	std::cout << m_chainName << " push stop:  " << m_pInternalChainStart->getComponentName() << std::endl;
+#endif // MIPDEBUG2
+	if (m_lockStart)
+		m_pInternalChainStart->unlock();
+	if (profiling || m_overloadProtection)
+		afterStartTime = Profiler::getTime();
+
+#ifdef MIPDEBUG
+//	MIPTime curTime = MIPTime::getCurrentTime();
+#endif // MIPDEBUG
+	
+	int numSteps = (int)m_connectionSteps.size();
+
+	if (m_pParallelExec)
+	{
+		if (!m_pParallelExec->runIteration(iteration, profiling, shedPriority, errorComponent, errorString))
+			error = true;
+		numSteps = 0;
+	}
+
+	for (int connIndex = 0 ; !error && connIndex < numSteps ; connIndex++)
+	{
+		const ConnectionStep &step = m_connectionSteps[connIndex];
+		MIPComponent *pPullComp = step.m_pPull;
+		MIPComponent *pPushComp = step.m_pPush;
+		uint32_t mask1 = step.m_mask1;
+		uint32_t mask2 = step.m_mask2;
+		bool transfer = (step.m_priority > shedPriority);
+		real_t connStartTime = 0;
+
+		if (profiling)
+			connStartTime = Profiler::getTime();
+
+		if (step.m_lockPull)
+			pPullComp->lock();
+		if (step.m_lockPush)
+			pPushComp->lock();
+
+		MIPMessage *msg = 0;
 #ifdef MIPDEBUG3
-			int msgCount = 0;
+		int msgCount = 0;
 #endif // MIPDEBUG3
+
+		if (step.m_startPull)
+			pPullComp->m_pVerifiedChain = (step.m_verifiedPull)?this:0;
+		if (step.m_startPush)
+			pPushComp->m_pVerifiedChain = (step.m_verifiedPush)?this:0;
+
+		if (step.m_startPull && !pPullComp->onIterationStart(*this, iteration))
+		{
+			error = true;
+			errorComponent = pPullComp->getComponentName();
+			errorString = pPullComp->getErrorString();
+		}
+		else if (step.m_startPush && !pPushComp->onIterationStart(*this, iteration))
+		{
+			error = true;
+			errorComponent = pPushComp->getComponentName();
+			errorString = pPushComp->getErrorString();
+		}
+
+		if (!error)
+		{
+			// Components which are idle, or which only get input from idle ones,
+			// are not pulled
+			if (isPullActive(step, iteration))
+				markPushInput(step);
+			else
+				transfer = false;
+		}
+
+		if (!error && transfer && step.m_batchPull)
+		{
+			if (!processBatchStep(step, connIndex, iteration, profiling, errorComponent, errorString))
+				error = true;
+		}
+		else if (!error && transfer)
+		{
 			do
 			{
 #ifdef MIPDEBUG2
 				std::cout << m_chainName << " pull start: " << pPullComp->getComponentName() << std::endl;
 #endif // MIPDEBUG2
+				if (profiling)
+					t0 = Profiler::getTime();
 				if (!pPullComp->pull(*this, iteration, &msg))
 				{
 					error = true;
@@ -299,6 +1055,8 @@ void *MIPComponentChain::Thread()
 				}
 				else
 				{
+					if (profiling)
+						m_pProfiler->m_pullTimes[m_pProfiler->m_pullSlots[connIndex]] += Profiler::getTime() - t0;
 #ifdef MIPDEBUG2
 					std::cout << m_chainName << " pull stop:  " << pPullComp->getComponentName() << std::endl;
 #endif // MIPDEBUG2
@@ -316,12 +1074,19 @@ void *MIPComponentChain::Thread()
 #ifdef MIPDEBUG2
 							std::cout << m_chainName << " push start: " << pPushComp->getComponentName() << std::endl;
 #endif // MIPDEBUG2
+							if (profiling)
+								t0 = Profiler::getTime();
 							if(!pPushComp->push(*this, iteration, msg))
 							{
 								error = true;
 								errorComponent = pPushComp->getComponentName();
 								errorString = pPushComp->getErrorString();
 							}
+							if (profiling)
+							{
+								m_pProfiler->m_pushTimes[m_pProfiler->m_pushSlots[connIndex]] += Profiler::getTime() - t0;
+								m_pProfiler->m_connectionMessages[connIndex]++;
+							}
 #ifdef MIPDEBUG2
 							std::cout << m_chainName << " push stop:  " << pPushComp->getComponentName() << std::endl;
 #endif // MIPDEBUG2
@@ -333,96 +1098,265 @@ void *MIPComponentChain::Thread()
 
 				}
 			} while (!error && msg);
-			
-			pPullComp->unlock();
-			if (pPushComp->getComponentPointer() != pPullComp->getComponentPointer())
-				pPushComp->unlock();
-#ifdef MIPDEBUG3
-			std::cout << "   Transferred " << msgCount << " messages from " << pPullComp->getComponentName() << " (" << (void *)pPullComp << ") to " << pPushComp->getComponentName() << " (" << (void  *)pPushComp << ")" << std::endl;
-#endif // MIPDEBUG3
 		}
 
-		if (error)
+		if (!error && step.m_endPull && !pPullComp->onIterationEnd(*this, iteration))
 		{
-			m_chainMutex.Unlock();
-			break;
+			error = true;
+			errorComponent = pPullComp->getComponentName();
+			errorString = pPullComp->getErrorString();
+		}
+		if (!error && step.m_endPush && !pPushComp->onIterationEnd(*this, iteration))
+		{
+			error = true;
+			errorComponent = pPushComp->getComponentName();
+			errorString = pPushComp->getErrorString();
 		}
 		
-		std::list<MIPComponent *>::const_iterator fbIt;
-		MIPFeedback feedback;
-		int64_t chainID = 0;
-		
+		if (error) // the chain stops, so release everything we're holding
+		{
+			if (!step.m_privatePull)
+				pPullComp->unlock();
+			if (step.m_separatePush && !step.m_privatePush)
+				pPushComp->unlock();
+		}
+		else
+		{
+			if (step.m_unlockPull)
+				pPullComp->unlock();
+			if (step.m_unlockPush)
+				pPushComp->unlock();
+		}
+		if (profiling)
+			m_pProfiler->m_connectionTimes[connIndex] += Profiler::getTime() - connStartTime;
+#ifdef MIPDEBUG3
+		std::cout << "   Transferred " << msgCount << " messages from " << pPullComp->getComponentName() << " (" << (void *)pPullComp << ") to " << pPushComp->getComponentName() << " (" << (void  *)pPushComp << ")" << std::endl;
+#endif // MIPDEBUG3
+	}
+
+	if (error)
+	{
+		m_chainMutex.Unlock();
+		return false;
+	}
+	
+	MIPFeedback feedback;
+	int64_t chainID = 0;
+	int numFeedbackSteps = (int)m_feedbackSteps.size();
+	
 #ifdef MIPDEBUG4
-		//std::cerr << "Processing feedback:" << std::endl;
+	//std::cerr << "Processing feedback:" << std::endl;
 #endif // MIPDEBUG4
-		
+	
 #ifdef MIPDEBUG4
-		std::cerr << "\tNEW CHAIN" << std::endl;
+	std::cerr << "\tNEW CHAIN" << std::endl;
 #endif // MIPDEBUG4
 
-		for (fbIt = m_feedbackChain.begin() ; !error && fbIt != m_feedbackChain.end() ; fbIt++)
+	for (int fbIndex = 0 ; !error && fbIndex < numFeedbackSteps ; fbIndex++)
+	{
+		MIPComponent *pFbComp = m_feedbackSteps[fbIndex];
+
+		if (pFbComp == 0)
 		{
-			if ((*fbIt) == 0)
-			{
-				feedback = MIPFeedback(); // reinitialize feedback
-				chainID++;
+			feedback = MIPFeedback(); // reinitialize feedback
+			chainID++;
 #ifdef MIPDEBUG4
-				std::cerr << "\tNEW CHAIN" << std::endl;
+			std::cerr << "\tNEW CHAIN" << std::endl;
 #endif // MIPDEBUG4
-			}
-			else
-			{
-				MIPComponent *pFbComp = *fbIt;
+		}
+		else
+		{
+			if (m_feedbackLocks[fbIndex])
 				pFbComp->lock();
 #ifdef MIPDEBUG4
-				std::cerr << "\t\t" << pFbComp->getComponentName() << " " << ((void *)pFbComp) << std::endl;
+			std::cerr << "\t\t" << pFbComp->getComponentName() << " " << ((void *)pFbComp) << std::endl;
 #endif // MIPDEBUG4
-				if (!pFbComp->processFeedback(*this, chainID, &feedback))
-				{
-					error = true;
-					errorComponent = pFbComp->getComponentName();
-					errorString = pFbComp->getErrorString();
-				}
-				pFbComp->unlock();
+			if (profiling)
+				t0 = Profiler::getTime();
+			if (!pFbComp->processFeedback(*this, chainID, &feedback))
+			{
+				error = true;
+				errorComponent = pFbComp->getComponentName();
+				errorString = pFbComp->getErrorString();
 			}
+			if (profiling)
+				m_pProfiler->m_feedbackTimes[m_pProfiler->m_feedbackSlots[fbIndex]] += Profiler::getTime() - t0;
+			if (m_feedbackLocks[fbIndex])
+				pFbComp->unlock();
 		}
+	}
 
-		m_chainMutex.Unlock();
-		
-		if (error)
-			break;
-		
-		//std::cerr << std::endl;
-		
-		m_loopMutex.Lock();
-		done = m_stopLoop;
-		m_loopMutex.Unlock();
-		iteration++;
+	if (!error)
+	{
+		real_t endTime = (profiling || m_overloadProtection)?Profiler::getTime():0;
 
-#ifdef MIPDEBUG
-//		MIPTime diff = MIPTime::getCurrentTime();
-//		diff -= curTime;
-//		std::cout << "Loop time: " << diff.getString() << std::endl;
-#endif // MIPDEBUG
+		if (profiling)
+			reportProfile = m_pProfiler->endIteration(startTime, afterStartTime, endTime, profileReport);
+		if (m_overloadProtection)
+			updateOverloadState(endTime - afterStartTime);
 	}
+
+	m_chainMutex.Unlock();
 	
-	onThreadExit(error, errorComponent, errorString);
-	
-#ifdef MIPDEBUG
-	std::cout << "MIPComponentChain::Thread stopped" << std::endl;
-#endif // MIPDEBUG
-	
-	return 0;
+	if (error)
+		return false;
+
+	if (reportProfile)
+		onProfileReport(profileReport);
+
+	return true;
+}
+
+bool MIPComponentChain::isPullActive(const ConnectionStep &step, int64_t iteration)
+{
+	uint8_t &activity = m_activity[step.m_pullSlot];
+
+	if (step.m_firstPull)
+	{
+		if (activity == MIPCOMPONENTCHAIN_ACTIVITY_HASINPUT && step.m_pPull->isActiveInIteration(*this, iteration))
+			activity = MIPCOMPONENTCHAIN_ACTIVITY_ACTIVE;
+		else
+			activity = MIPCOMPONENTCHAIN_ACTIVITY_IDLE;
+	}
+	return (activity == MIPCOMPONENTCHAIN_ACTIVITY_ACTIVE);
+}
+
+void MIPComponentChain::markPushInput(const ConnectionStep &step)
+{
+	uint8_t &activity = m_activity[step.m_pushSlot];
+
+	if (activity == MIPCOMPONENTCHAIN_ACTIVITY_NOINPUT)
+		activity = MIPCOMPONENTCHAIN_ACTIVITY_HASINPUT;
+}
+
+bool MIPComponentChain::processBatchStep(const ConnectionStep &step, int connIndex, int64_t iteration, bool profiling, std::string &errorComponent, std::string &errorString)
+{
+	MIPMessage * const *pMessages = 0;
+	size_t numMessages = 0;
+	real_t t0 = 0;
+
+	if (profiling)
+		t0 = Profiler::getTime();
+	if (!step.m_pPull->pullBatch(*this, iteration, pMessages, numMessages))
+	{
+		errorComponent = step.m_pPull->getComponentName();
+		errorString = step.m_pPull->getErrorString();
+		return false;
+	}
+	if (profiling)
+		m_pProfiler->m_pullTimes[m_pProfiler->m_pullSlots[connIndex]] += Profiler::getTime() - t0;
+
+	// Only when the connection filters messages, we need to make a selection
+
+	if (step.m_mask1 != MIPMESSAGE_TYPE_ALL || step.m_mask2 != MIPMESSAGE_TYPE_ALL)
+	{
+		m_batchMessages.clear();
+		for (size_t i = 0 ; i < numMessages ; i++)
+		{
+			if ((pMessages[i]->getMessageType()&step.m_mask1) && (pMessages[i]->getMessageSubtype()&step.m_mask2))
+				m_batchMessages.push_back(pMessages[i]);
+		}
+		numMessages = m_batchMessages.size();
+		pMessages = (numMessages > 0)?&m_batchMessages[0]:0;
+	}
+
+	if (numMessages == 0)
+		return true;
+
+	if (profiling)
+		t0 = Profiler::getTime();
+	if (!step.m_pPush->pushBatch(*this, iteration, pMessages, numMessages))
+	{
+		errorComponent = step.m_pPush->getComponentName();
+		errorString = step.m_pPush->getErrorString();
+		return false;
+	}
+	if (profiling)
+	{
+		m_pProfiler->m_pushTimes[m_pProfiler->m_pushSlots[connIndex]] += Profiler::getTime() - t0;
+		m_pProfiler->m_connectionMessages[connIndex] += numMessages;
+	}
+	return true;
+}
+
+bool MIPComponentChain::getIterationStartTime(int64_t iteration, MIPTime &startTime, std::string &errorComponent, std::string &errorString)
+{
+	bool status = true;
+
+	m_chainMutex.Lock();
+	if (m_lockStart)
+		m_pInternalChainStart->lock();
+	if (!m_pInternalChainStart->getIterationStartTime(*this, iteration, startTime))
+	{
+		errorComponent = m_pInternalChainStart->getComponentName();
+		errorString = m_pInternalChainStart->getErrorString();
+		status = false;
+	}
+	if (m_lockStart)
+		m_pInternalChainStart->unlock();
+	m_chainMutex.Unlock();
+
+	return status;
+}
+
+bool MIPComponentChain::ScheduledTask::execute(MIPTime &nextTime)
+{
+	std::string errorComponent, errorString;
+	MIPTime startTime;
+
+	m_chain.m_loopMutex.Lock();
+	bool done = m_chain.m_stopLoop;
+	m_chain.m_loopMutex.Unlock();
+
+	if (done)
+		return false;
+
+	if (!m_chain.getIterationStartTime(m_iteration, startTime, errorComponent, errorString))
+		return finish(errorComponent, errorString);
+
+	// The start component won't need to wait if the iteration is due
+	if (startTime <= MIPTime::getCurrentTime())
+	{
+		if (!m_chain.processIteration(m_iteration, m_profileReport, errorComponent, errorString))
+			return finish(errorComponent, errorString);
+		m_iteration++;
+
+		if (!m_chain.getIterationStartTime(m_iteration, startTime, errorComponent, errorString))
+			return finish(errorComponent, errorString);
+	}
+
+	nextTime = startTime;
+	return true;
+}
+
+bool MIPComponentChain::ScheduledTask::finish(const std::string &errorComponent, const std::string &errorString)
+{
+	m_chain.onThreadExit(true, errorComponent, errorString);
+
+	m_chain.m_loopMutex.Lock();
+	m_chain.m_scheduledRunning = false;
+	m_chain.m_loopMutex.Unlock();
+
+	return false;
 }
 
 bool MIPComponentChain::orderConnections(std::list<MIPConnection> &orderedConnections)
 {
+	// The connections are ordered in layers: first the ones starting from the start
+	// component, then the ones starting from the components these lead to, and so on.
+	// Within a layer, the order in which the connections were added is kept. A component
+	// is only handled the first time it is encountered, since all its connections are
+	// ordered at that point.
+
 	std::list<MIPConnection> orderedList;
 	std::list<MIPConnection>::iterator it;
-	std::list<MIPComponent *> componentLayer;
+	std::map<MIPComponent *, std::vector<MIPConnection *> > outgoing;
+	std::set<MIPComponent *> handledComponents;
+	std::vector<MIPComponent *> componentLayer;
+	size_t numConnections = 0;
 
-	for (it = m_inputConnections.begin() ; it != m_inputConnections.end() ; it++)
-		(*it).setMark(false);
+	for (it = m_inputConnections.begin() ; it != m_inputConnections.end() ; it++, numConnections++)
+		outgoing[(*it).getPullComponent()].push_back(&(*it));
 
 #ifdef MIPDEBUG3
 	int layerNumber = 0;
@@ -436,185 +1370,1237 @@ bool MIPComponentChain::orderConnections(std::list<MIPConnection> &orderedConnec
 		layerNumber++;
 		std::cout << "Layer " << layerNumber << ":" << std::endl;
 #endif // MIPDEBUG3
-		std::list<MIPComponent *> newLayer;
-		std::list<MIPComponent *>::const_iterator compit;
+		std::vector<MIPComponent *> newLayer;
+		std::set<MIPComponent *> newLayerComponents;
 		
-		for (compit = componentLayer.begin() ; compit != componentLayer.end() ; compit++)
+		for (size_t i = 0 ; i < componentLayer.size() ; i++)
 		{
-			for (it = m_inputConnections.begin() ; it != m_inputConnections.end() ; it++)
+			if (!handledComponents.insert(componentLayer[i]).second)
+				continue;
+
+			std::map<MIPComponent *, std::vector<MIPConnection *> >::const_iterator outIt = outgoing.find(componentLayer[i]);
+
+			if (outIt == outgoing.end())
+				continue;
+
+			const std::vector<MIPConnection *> &connections = outIt->second;
+
+			for (size_t j = 0 ; j < connections.size() ; j++)
 			{
-				if (!(*it).isMarked()) // check that we haven't processed this connection yet
-				{
-					if ((*it).getPullComponent() == (*compit)) // check that this connection starts from the component under consideration
-					{
-						// mark the connection as processed
-						(*it).setMark(true);
-						// copy the connection in the ordered list
-						orderedList.push_back(*it);
-
-						// get the other end of the connection and add that
-						// component to the new layer
-						// we'll make sure that the component isn't already
-						// in the list
-
-						bool found = false;
-						MIPComponent *component = (*it).getPushComponent();
-						std::list<MIPComponent *>::const_iterator compit2;
+				MIPComponent *component = connections[j]->getPushComponent();
 #ifdef MIPDEBUG3
-						std::cout << "   " << (*it).getPullComponent()->getComponentName() << " (" << (void *)((*it).getPullComponent()) << ") -> " << (*it).getPushComponent()->getComponentName() << " (" << (void*)((*it).getPushComponent()) << ")" <<std::endl;
+				std::cout << "   " << connections[j]->getPullComponent()->getComponentName() << " (" << (void *)(connections[j]->getPullComponent()) << ") -> " << component->getComponentName() << " (" << (void*)component << ")" <<std::endl;
 #endif // MIPDEBUG3
+				orderedList.push_back(*connections[j]);
 
-						for (compit2 = newLayer.begin() ; !found && compit2 != newLayer.end() ; compit2++)
-						{
-							if ((*compit2) == component)
-								found = true;
-						}
-
-						if (!found)
-							newLayer.push_back(component);
-					}
-				}
+				// add the other end of the connection to the new layer, if
+				// it isn't already in there
+				if (newLayerComponents.insert(component).second)
+					newLayer.push_back(component);
 			}
 		}
 		
-		componentLayer = newLayer;
+		componentLayer.swap(newLayer);
 	}
 	
 #ifdef MIPDEBUG3
 	std::cout << "End of connection ordering" << std::endl;
 #endif // MIPDEBUG3
 
-	for (it = m_inputConnections.begin() ; it != m_inputConnections.end() ; it++)
+	if (orderedList.size() != numConnections)
 	{
-		if (!(*it).isMarked())
-		{
-			setErrorString(MIPCOMPONENTCHAIN_ERRSTR_UNUSEDCONNECTION);
-			return false;		
-		}
+		setErrorString(MIPCOMPONENTCHAIN_ERRSTR_UNUSEDCONNECTION);
+		return false;		
 	}
 
-	orderedConnections = orderedList;
+	orderedConnections.swap(orderedList);
 	
 	return true;
 }
 
-bool MIPComponentChain::buildFeedbackList(std::list<MIPConnection> &orderedList, std::list<MIPComponent *> &feedbackComponentChain)
+static bool producesMessages(const MIPComponent *pComp, uint32_t mask1, uint32_t mask2)
 {
-	std::list<MIPConnection>::iterator it;
-	std::list<MIPComponent *> subChain;
-	std::list<MIPComponent *> feedbackChain;
-	bool done = false;
+	std::vector<MIPMessageFormat> formats;
 
-	for (it = orderedList.begin() ; it != orderedList.end() ; it++)
+	if (!pComp->getOutputMessageFormats(formats))
+		return true;
+
+	for (size_t i = 0 ; i < formats.size() ; i++)
 	{
-		if (!(*it).giveFeedback())
-			(*it).setMark(true);
-		else
-			(*it).setMark(false);
+		if ((formats[i].getMessageType()&mask1) && (formats[i].getMessageSubtypes()&mask2))
+			return true;
 	}
-	
-	while (!done)
-	{
-		bool found = false;
+	return false;
+}
 
-		it = orderedList.begin();
-		while (!found && it != orderedList.end())
-		{
-			if (!(*it).isMarked() && (*it).giveFeedback())
-				found = true;
-			else
-				it++;
-		}
+bool MIPComponentChain::negotiateFormats(std::list<MIPConnection> &orderedList, CompiledState &state)
+{
+	// The connections are checked in the order in which they will be processed. When
+	// a format isn't accepted, the connection is replaced by one to a sequence of
+	// converters for that message type, followed by one for the other message types.
+	// A connection between converters or from or to a converter is not converted
+	// again.
+
+	std::map<const MIPComponent *, std::pair<int, int> > inputProperties;
+	std::map<const MIPComponent *, int> remainingInputs;
+	std::set<const MIPComponent *> unverified, receivers, converters;
+	std::set<const MIPComponent *>::const_iterator recIt;
+	std::list<MIPConnection> negotiatedList;
+	std::list<MIPConnection>::const_iterator it;
+
+	for (it = orderedList.begin() ; it != orderedList.end() ; it++)
+		remainingInputs[(*it).getPushComponent()]++;
+
+	// The start component receives the WAITTIME message from the chain itself
+	unverified.insert(m_pInputChainStart);
 
-		if (found) // ok, found a starting point, build the subchain
+	for (it = orderedList.begin() ; it != orderedList.end() ; it++)
+	{
+		std::list<MIPConnection> pending(1, *it);
+
+		while (!pending.empty())
 		{
-			(*it).setMark(true);
-			
-			// The connections are ordered! We'll make use of this by only
-			// considering connections further down the road
-			
-			subChain.clear();
+			MIPConnection conn = pending.front();
+			MIPComponent *pPull = conn.getPullComponent();
+			MIPComponent *pPush = conn.getPushComponent();
+			std::vector<MIPMessageFormat> accepted;
+			MIPMessageFormat mismatch(0, 0);
 
-			// connection is from pull to push
-			subChain.push_back((*it).getPullComponent());
-			subChain.push_back((*it).getPushComponent());
+			pending.pop_front();
 
-			(*it).setMark(true);
+			int status = checkFormats(conn, inputProperties, remainingInputs, accepted, mismatch);
 
-			std::list<MIPConnection>::iterator startIt = it;
-			bool done2 = false;
-			
-			while (!done2)
+			if (status != MIPCOMPONENTCHAIN_FORMATS_MISMATCH)
 			{
-				std::list<MIPConnection>::iterator nextStartIt;
-				bool foundNextStartIt = false;
+				if (status == MIPCOMPONENTCHAIN_FORMATS_UNKNOWN)
+					unverified.insert(pPush);
+				remainingInputs[pPush]--;
+				receivers.insert(pPush);
+				negotiatedList.push_back(conn);
+				continue;
+			}
 
-				it = startIt;
-				it++;
-				while (it != orderedList.end())
-				{
-					// The check for isMarked causes some problems when a feedback chain splits
-					// into two parts. By omitting this check, two separate chains should be
-					// created, which both have a common part
-					if (/*!(*it).isMarked() &&*/ (*it).giveFeedback())
-					{
-						if ((*it).getPullComponent() == (*startIt).getPushComponent())
-						{
-							if (foundNextStartIt)
-							{
-								setErrorString(MIPCOMPONENTCHAIN_ERRSTR_CANTMERGEFEEDBACK);
-								return false;
-							}
-							foundNextStartIt = true;
-							nextStartIt = it;
-							subChain.push_back((*it).getPushComponent());
-							(*it).setMark(true);
-						}
-					}
-					it++;
-				}
+			std::vector<MIPComponent *> newConverters;
 
-				if (!foundNextStartIt)
-					done2 = true;
-				else
-					startIt = nextStartIt;
+			if (m_pConverterFactory == 0 || converters.find(pPull) != converters.end() || converters.find(pPush) != converters.end() ||
+			    !m_pConverterFactory->createConverters(mismatch, accepted, newConverters) || newConverters.empty())
+			{
+				for (size_t i = 0 ; i < newConverters.size() ; i++)
+					delete newConverters[i];
+				setErrorString(std::string(MIPCOMPONENTCHAIN_ERRSTR_INCOMPATIBLEFORMATS) + pPull->getComponentName() + " to " + pPush->getComponentName());
+				return false;
 			}
 
-			// add the subchain to the feedbacklist in reverse
-		
-			if (!feedbackChain.empty())
-				feedbackChain.push_front(0); // mark new subchain
+			std::list<MIPConnection> replacement;
+			MIPComponent *pPrev = pPull;
+			uint32_t mask1 = conn.getMask1()&mismatch.getMessageType();
+			uint32_t mask2 = conn.getMask2();
 
-			std::list<MIPComponent *>::const_iterator it2;
+			for (size_t i = 0 ; i < newConverters.size() ; i++)
+			{
+				MIPComponent *pConv = newConverters[i];
 
-			for (it2 = subChain.begin() ; it2 != subChain.end() ; it2++)
-				feedbackChain.push_front(*it2);
-		}
-		else
-			done = true;
-	}
+				pConv->setChainPrivate(true); // only this chain knows about it
+				state.m_converters.push_back(pConv);
+				converters.insert(pConv);
+				remainingInputs[pConv] = 1;
 
-	feedbackComponentChain = feedbackChain;
-	
-	return true;
+				replacement.push_back(MIPConnection(pPrev, pConv, conn.giveFeedback(), mask1, mask2, conn.getPriority()));
+				pPrev = pConv;
+				mask1 = MIPMESSAGE_TYPE_ALL;
+				mask2 = MIPMESSAGE_TYPE_ALL;
+			}
+			replacement.push_back(MIPConnection(pPrev, pPush, conn.giveFeedback(), mask1, mask2, conn.getPriority()));
+
+			uint32_t restMask1 = conn.getMask1()&~mismatch.getMessageType();
+
+			if (producesMessages(pPull, restMask1, conn.getMask2()))
+			{
+				replacement.push_back(MIPConnection(pPull, pPush, false, restMask1, conn.getMask2(), conn.getPriority()));
+				remainingInputs[pPush]++;
+			}
+			pending.splice(pending.begin(), replacement);
+		}
+	}
+
+	for (recIt = receivers.begin() ; recIt != receivers.end() ; recIt++)
+	{
+		if (unverified.find(*recIt) == unverified.end())
+			state.m_verifiedComponents.insert(*recIt);
+	}
+
+	orderedList.swap(negotiatedList);
+	return true;
 }
 
-void MIPComponentChain::copyConnectionInfo(const std::list<MIPConnection> &orderedList, const std::list<MIPComponent *> &feedbackChain)
+int MIPComponentChain::checkFormats(const MIPConnection &conn, std::map<const MIPComponent *, std::pair<int, int> > &inputProperties, 
+                                    const std::map<const MIPComponent *, int> &remainingInputs, std::vector<MIPMessageFormat> &accepted,
+                                    MIPMessageFormat &mismatch)
+{
+	MIPComponent *pPull = conn.getPullComponent();
+	MIPComponent *pPush = conn.getPushComponent();
+	std::vector<MIPMessageFormat> produced, passed;
+	int status = MIPCOMPONENTCHAIN_FORMATS_VERIFIED;
+	bool declared = true;
+
+	accepted.clear();
+	if (!pPull->getOutputMessageFormats(produced) || !pPush->getInputMessageFormats(accepted))
+	{
+		status = MIPCOMPONENTCHAIN_FORMATS_UNKNOWN;
+		declared = false;
+	}
+	else
+	{
+		// A produced format without sampling rate or number of channels has the
+		// same ones as the messages which the pull component receives, but these
+		// are only known when all its incoming connections were checked already
+
+		std::map<const MIPComponent *, std::pair<int, int> >::const_iterator propIt = inputProperties.find(pPull);
+		std::map<const MIPComponent *, int>::const_iterator remIt = remainingInputs.find(pPull);
+		int inRate = 0, inChannels = 0;
+
+		if (propIt != inputProperties.end() && remIt != remainingInputs.end() && remIt->second == 0)
+		{
+			inRate = propIt->second.first;
+			inChannels = propIt->second.second;
+		}
+
+		for (size_t i = 0 ; i < produced.size() ; i++)
+		{
+			const MIPMessageFormat &f = produced[i];
+			uint32_t subtypes = f.getMessageSubtypes()&conn.getMask2();
+			int rate = (f.getSamplingRate() != 0)?f.getSamplingRate():inRate;
+			int channels = (f.getNumberOfChannels() != 0)?f.getNumberOfChannels():inChannels;
+
+			if (!(f.getMessageType()&conn.getMask1()))
+				continue;
+
+			for (uint32_t flag = 1 ; flag != 0 ; flag <<= 1)
+			{
+				if (subtypes&flag)
+					passed.push_back(MIPMessageFormat(f.getMessageType(), flag, rate, channels));
+			}
+		}
+
+		for (size_t i = 0 ; i < passed.size() ; i++)
+		{
+			const MIPMessageFormat &f = passed[i];
+			bool found = false;
+			bool unknown = false;
+
+			for (size_t j = 0 ; !found && j < accepted.size() ; j++)
+			{
+				const MIPMessageFormat &a = accepted[j];
+
+				if (!(a.getMessageType()&f.getMessageType()) || !(a.getMessageSubtypes()&f.getMessageSubtypes()))
+					continue;
+
+				if ((a.getSamplingRate() == 0 || a.getSamplingRate() == f.getSamplingRate()) &&
+				    (a.getNumberOfChannels() == 0 || a.getNumberOfChannels() == f.getNumberOfChannels()))
+					found = true;
+				else if ((a.getSamplingRate() != 0 && f.getSamplingRate() == 0) || (a.getNumberOfChannels() != 0 && f.getNumberOfChannels() == 0))
+					unknown = true;
+			}
+
+			if (!found)
+			{
+				if (!unknown)
+				{
+					mismatch = f;
+					return MIPCOMPONENTCHAIN_FORMATS_MISMATCH;
+				}
+				status = MIPCOMPONENTCHAIN_FORMATS_UNKNOWN;
+			}
+		}
+	}
+
+	// Keep track of the sampling rate and number of channels of the audio messages
+	// which the push component receives, if these are the same for all of them
+
+	bool firstInput = (inputProperties.find(pPush) == inputProperties.end());
+	std::pair<int, int> &props = inputProperties[pPush];
+
+	if (!declared)
+		props = std::pair<int, int>(0, 0);
+
+	for (size_t i = 0 ; i < passed.size() ; i++)
+	{
+		const MIPMessageFormat &f = passed[i];
+
+		if (!(f.getMessageType()&(MIPMESSAGE_TYPE_AUDIO_RAW|MIPMESSAGE_TYPE_AUDIO_ENCODED)))
+			continue;
+
+		if (firstInput)
+		{
+			props = std::pair<int, int>(f.getSamplingRate(), f.getNumberOfChannels());
+			firstInput = false;
+		}
+		else
+		{
+			if (props.first != f.getSamplingRate())
+				props.first = 0;
+			if (props.second != f.getNumberOfChannels())
+				props.second = 0;
+		}
+	}
+	return status;
+}
+
+bool MIPComponentChain::buildFeedbackList(std::list<MIPConnection> &orderedList, std::list<MIPComponent *> &feedbackComponentChain)
+{
+	std::list<MIPConnection>::iterator it;
+	std::vector<MIPConnection *> feedbackConnections;
+	std::map<MIPComponent *, std::vector<size_t> > feedbackFrom;
+	std::vector<bool> marked;
+	std::list<MIPComponent *> subChain;
+	std::list<MIPComponent *> feedbackChain;
+
+	// Only the connections which give feedback are relevant here; for each
+	// component, we store the positions of the ones which start from it
+
+	for (it = orderedList.begin() ; it != orderedList.end() ; it++)
+	{
+		if ((*it).giveFeedback())
+		{
+			feedbackFrom[(*it).getPullComponent()].push_back(feedbackConnections.size());
+			feedbackConnections.push_back(&(*it));
+		}
+	}
+	marked.resize(feedbackConnections.size(), false);
+
+	for (size_t start = 0 ; start < feedbackConnections.size() ; start++)
+	{
+		if (marked[start]) // not a starting point
+			continue;
+
+		// found a starting point, build the subchain
+
+		marked[start] = true;
+			
+		// The connections are ordered! We'll make use of this by only
+		// considering connections further down the road
+			
+		subChain.clear();
+
+		// connection is from pull to push
+		subChain.push_back(feedbackConnections[start]->getPullComponent());
+		subChain.push_back(feedbackConnections[start]->getPushComponent());
+
+		size_t cur = start;
+		bool done = false;
+			
+		while (!done)
+		{
+			// Connections which were already marked are considered as well, since a
+			// feedback chain which splits into two parts is handled by creating two
+			// separate chains, which both have a common part
+			std::map<MIPComponent *, std::vector<size_t> >::const_iterator fbIt = feedbackFrom.find(feedbackConnections[cur]->getPushComponent());
+
+			if (fbIt == feedbackFrom.end())
+				done = true;
+			else
+			{
+				const std::vector<size_t> &positions = fbIt->second;
+				std::vector<size_t>::const_iterator posIt = std::upper_bound(positions.begin(), positions.end(), cur);
+
+				if (posIt == positions.end())
+					done = true;
+				else if (positions.end() - posIt > 1)
+				{
+					setErrorString(MIPCOMPONENTCHAIN_ERRSTR_CANTMERGEFEEDBACK);
+					return false;
+				}
+				else
+				{
+					cur = *posIt;
+					subChain.push_back(feedbackConnections[cur]->getPushComponent());
+					marked[cur] = true;
+				}
+			}
+		}
+
+		// add the subchain to the feedbacklist in reverse
+		
+		if (!feedbackChain.empty())
+			feedbackChain.push_front(0); // mark new subchain
+
+		std::list<MIPComponent *>::const_iterator it2;
+
+		for (it2 = subChain.begin() ; it2 != subChain.end() ; it2++)
+			feedbackChain.push_front(*it2);
+	}
+
+	feedbackComponentChain.swap(feedbackChain);
+	
+	return true;
+}
+
+void MIPComponentChain::compileState(const std::list<MIPConnection> &orderedList, const std::list<MIPComponent *> &feedbackChain, CompiledState &state)
 {
+	std::list<MIPConnection>::const_iterator it;
+	std::vector<ConnectionStep> &steps = state.m_steps;
+
+	for (it = orderedList.begin() ; it != orderedList.end() ; it++)
+	{
+		bool separatePush = ((*it).getPullComponent()->getComponentPointer() != (*it).getPushComponent()->getComponentPointer());
+
+		steps.push_back(ConnectionStep(*it, separatePush));
+		steps.back().m_batchPull = (*it).getPullComponent()->supportsPullBatch();
+
+		if ((*it).getPriority() < 0)
+			state.m_shedLevels.push_back((*it).getPriority());
+	}
+
+	// The priority levels which can be shed, in the order in which this happens
+	std::sort(state.m_shedLevels.begin(), state.m_shedLevels.end());
+	state.m_shedLevels.erase(std::unique(state.m_shedLevels.begin(), state.m_shedLevels.end()), state.m_shedLevels.end());
+
+	// A component which was locked in a step, is kept locked for the next step
+	// if it is that step's pull component (which is locked first anyway), or if
+	// it is the step's push component and the pull component is kept locked as
+	// well. This way, no lock is ever acquired while holding one that would 
+	// otherwise only have been acquired later, and the locking order between
+	// chains sharing components stays the same. Only identical component
+	// instances are considered, since an alias has its own lock as well.
+
+	for (size_t i = 0 ; i+1 < steps.size() ; i++)
+	{
+		ConnectionStep &cur = steps[i];
+		ConnectionStep &next = steps[i+1];
+		bool keepPull = false;
+		bool keepPush = false;
+
+		if (cur.m_pPull == next.m_pPull)
+			keepPull = true;
+		else if (cur.m_separatePush && cur.m_pPush == next.m_pPull)
+			keepPush = true;
+
+		if (next.m_separatePush && (keepPull || keepPush))
+		{
+			if (cur.m_pPull == next.m_pPush)
+				keepPull = true;
+			else if (cur.m_separatePush && cur.m_pPush == next.m_pPush)
+				keepPush = true;
+		}
+
+		if (keepPull)
+		{
+			cur.m_unlockPull = false;
+			if (cur.m_pPull == next.m_pPull)
+				next.m_lockPull = false;
+			else
+				next.m_lockPush = false;
+		}
+		if (keepPush)
+		{
+			cur.m_unlockPush = false;
+			if (cur.m_pPush == next.m_pPull)
+				next.m_lockPull = false;
+			else
+				next.m_lockPush = false;
+		}
+	}
+
+	// Chain-private components are not locked at all
+
+	const std::set<const MIPComponent *> &privateComps = state.m_privateComponents;
+	const std::set<const MIPComponent *> &verifiedComps = state.m_verifiedComponents;
+
+	for (size_t i = 0 ; i < steps.size() ; i++)
+	{
+		ConnectionStep &step = steps[i];
+
+		step.m_verifiedPull = (verifiedComps.find(step.m_pPull) != verifiedComps.end());
+		step.m_verifiedPush = (verifiedComps.find(step.m_pPush) != verifiedComps.end());
+
+		if (privateComps.find(step.m_pPull) != privateComps.end())
+		{
+			step.m_privatePull = true;
+			step.m_lockPull = false;
+			step.m_unlockPull = false;
+		}
+		if (step.m_separatePush && privateComps.find(step.m_pPush) != privateComps.end())
+		{
+			step.m_privatePush = true;
+			step.m_lockPush = false;
+			step.m_unlockPush = false;
+		}
+	}
+
+	// Determine in which steps the components are used for the first and the
+	// last time in an iteration, as an alias and the component itself are the 
+	// same component in this respect. The start component is used first to send
+	// the WAITTIME message to.
+
+	const MIPComponent *pStartID = m_pInputChainStart->getComponentPointer();
+	std::set<const MIPComponent *> usedComponents;
+	std::map<const MIPComponent *, size_t> lastUse;
+	std::map<const MIPComponent *, size_t>::const_iterator useIt;
+
+	usedComponents.insert(pStartID);
+	for (size_t i = 0 ; i < steps.size() ; i++)
+	{
+		ConnectionStep &step = steps[i];
+		const MIPComponent *pPullID = step.m_pPull->getComponentPointer();
+		const MIPComponent *pPushID = step.m_pPush->getComponentPointer();
+
+		if (usedComponents.insert(pPullID).second)
+			step.m_startPull = true;
+		lastUse[pPullID] = i*2;
+
+		if (step.m_separatePush)
+		{
+			if (usedComponents.insert(pPushID).second)
+				step.m_startPush = true;
+			lastUse[pPushID] = i*2+1;
+		}
+	}
+	for (useIt = lastUse.begin() ; useIt != lastUse.end() ; useIt++)
+	{
+		if (useIt->second%2 == 0)
+			steps[useIt->second/2].m_endPull = true;
+		else
+			steps[useIt->second/2].m_endPush = true;
+	}
+
+	// Each component gets a slot in the table which keeps track of whether it's active
+	// in an iteration. A component is only pulled if it received input from an active
+	// component first, so the start component, and components which receive input only
+	// after they were pulled for the first time (or from themselves), always count as
+	// having input.
+
+	std::map<const MIPComponent *, int> slots;
+	std::map<const MIPComponent *, size_t> firstPull;
+
+	slots[pStartID] = 0;
+	for (size_t i = 0 ; i < steps.size() ; i++)
+	{
+		ConnectionStep &step = steps[i];
+		const MIPComponent *pPullID = step.m_pPull->getComponentPointer();
+		const MIPComponent *pPushID = step.m_pPush->getComponentPointer();
+
+		if (slots.find(pPullID) == slots.end())
+		{
+			int slot = (int)slots.size();
+
+			slots[pPullID] = slot;
+		}
+		if (slots.find(pPushID) == slots.end())
+		{
+			int slot = (int)slots.size();
+
+			slots[pPushID] = slot;
+		}
+		step.m_pullSlot = slots[pPullID];
+		step.m_pushSlot = slots[pPushID];
+
+		if (firstPull.insert(std::pair<const MIPComponent *, size_t>(pPullID, i)).second)
+			step.m_firstPull = true;
+	}
+
+	state.m_initialActivity.assign(slots.size(), MIPCOMPONENTCHAIN_ACTIVITY_NOINPUT);
+	state.m_initialActivity[0] = MIPCOMPONENTCHAIN_ACTIVITY_HASINPUT;
+	for (size_t i = 0 ; i < steps.size() ; i++)
+	{
+		useIt = firstPull.find(steps[i].m_pPush->getComponentPointer());
+
+		if (useIt != firstPull.end() && useIt->second <= i)
+			state.m_initialActivity[steps[i].m_pushSlot] = MIPCOMPONENTCHAIN_ACTIVITY_HASINPUT;
+	}
+
+	state.m_endStartComponent = (lastUse.find(pStartID) == lastUse.end());
+	state.m_feedbackSteps.assign(feedbackChain.begin(), feedbackChain.end());
+	for (size_t i = 0 ; i < state.m_feedbackSteps.size() ; i++)
+		state.m_feedbackLocks.push_back(privateComps.find(state.m_feedbackSteps[i]) == privateComps.end());
+	state.m_lockStart = (privateComps.find(m_pInputChainStart) == privateComps.end());
+	state.m_pStart = m_pInputChainStart;
+	state.m_orderedList = orderedList;
+	state.m_feedbackChain = feedbackChain;
+
+	if (m_pParallelExec)
+		m_pParallelExec->buildNodes(orderedList, steps, state.m_nodes);
+}
+
+void MIPComponentChain::installState(CompiledState &state)
+{
+	// Called with the chain mutex locked; afterwards, 'state' contains the 
+	// previous tables, so that these can be freed outside of the chain's thread
+
+	m_connectionSteps.swap(state.m_steps);
+	m_feedbackSteps.swap(state.m_feedbackSteps);
+	m_feedbackLocks.swap(state.m_feedbackLocks);
+	m_initialActivity.swap(state.m_initialActivity);
+	m_activity.resize(m_initialActivity.size());
+	std::swap(m_endStartComponent, state.m_endStartComponent);
+	std::swap(m_lockStart, state.m_lockStart);
+	m_converters.swap(state.m_converters);
+	std::swap(m_pInternalChainStart, state.m_pStart);
+
+	if (m_pParallelExec)
+		m_pParallelExec->m_nodes.swap(state.m_nodes);
+
+	// Keep shedding as much work as possible after a rebuild
+	m_shedLevels.swap(state.m_shedLevels);
+	if (m_numShedLevels > (int)m_shedLevels.size())
+		m_numShedLevels = (int)m_shedLevels.size();
+	m_shedPriority = (m_numShedLevels > 0)?m_shedLevels[m_numShedLevels-1]:MIPCOMPONENTCHAIN_NOSHEDPRIORITY;
+
+	m_pProfiler->build(state.m_orderedList, state.m_feedbackChain);
+	state.m_installed = true;
+}
+
+void MIPComponentChain::applyPendingState()
+{
+	m_pendingMutex.lock();
+	if (m_pPendingState)
+	{
+		installState(*m_pPendingState);
+		m_pPendingState = 0;
+	}
+	m_havePendingState = false;
+	m_pendingMutex.unlock();
+
+	m_pendingCond.notify_all();
+}
+
+MIPComponentChain::ParallelNode::~ParallelNode()
+{
+	for (size_t i = 0 ; i < m_targets.size() ; i++)
+		delete m_targets[i];
+}
+
+void MIPComponentChain::ParallelNode::addDependency(ParallelNode *pNode)
+{
+	if (pNode == 0 || pNode == this)
+		return;
+
+	for (size_t i = 0 ; i < m_dependencies.size() ; i++)
+	{
+		if (m_dependencies[i] == pNode)
+			return;
+	}
+
+	m_dependencies.push_back(pNode);
+	pNode->m_successors.push_back(this);
+	m_numDependencies++;
+}
+
+void MIPComponentChain::ParallelNode::addConnection(const MIPConnection &conn, const ConnectionStep &step, int connectionIndex)
+{
+	const MIPComponent *pPushID = conn.getPushComponent()->getComponentPointer();
+
+	if (m_firstConnection < 0)
+		m_firstConnection = connectionIndex;
+	if (conn.getPriority() > m_maxPriority)
+		m_maxPriority = conn.getPriority();
+
+	for (size_t i = 0 ; i < m_targets.size() ; i++)
+	{
+		if (m_targets[i]->m_pPushComponent->getComponentPointer() == pPushID)
+		{
+			m_targets[i]->m_connections.push_back(conn);
+			m_targets[i]->m_connectionIndices.push_back(connectionIndex);
+			return;
+		}
+	}
+
+	// The pull component is already locked by the node itself
+	bool lockPush = (pPushID != m_pPullComponent->getComponentPointer() && !step.m_privatePush);
+	ParallelTarget *pTarget = new ParallelTarget(*this, conn.getPushComponent(), lockPush);
+
+	pTarget->m_connections.push_back(conn);
+	pTarget->m_connectionIndices.push_back(connectionIndex);
+	m_targets.push_back(pTarget);
+}
+
+void MIPComponentChain::ParallelNode::run()
+{
+	// Nodes which become ready are executed in this thread if possible, so
+	// that a linear sequence of nodes doesn't need to pass through the queue
+
+	ParallelNode *pNode = this;
+
+	while (pNode)
+	{
+		ParallelNode *pNext = 0;
+
+		pNode->execute();
+
+		for (size_t i = 0 ; i < pNode->m_successors.size() ; i++)
+		{
+			ParallelNode *pSucc = pNode->m_successors[i];
+
+			if (--pSucc->m_dependenciesLeft == 0)
+			{
+				if (pNext == 0)
+					pNext = pSucc;
+				else
+					m_exec.m_pool.submit(pSucc, m_exec.m_group);
+			}
+		}
+		pNode = pNext;
+	}
+}
+
+void MIPComponentChain::ParallelNode::execute()
+{
+	if (m_exec.m_abort)
+		return;
+
+	const MIPComponentChain &chain = m_exec.m_chain;
+	int64_t iteration = m_exec.m_iteration;
+	MIPMessage *pMsg = 0;
+	Profiler *pProfiler = (m_exec.m_profiling)?m_exec.m_chain.m_pProfiler:0;
+	real_t t0 = 0;
+
+	if (m_lockPull)
+		m_pPullComponent->lock();
+	m_messages.clear();
+
+	if (m_startPull)
+		m_pPullComponent->m_pVerifiedChain = (m_verifiedPull)?&chain:0;
+	if (m_startPull && !m_pPullComponent->onIterationStart(chain, iteration))
+	{
+		m_error = true;
+		m_errorComponent = m_pPullComponent->getComponentName();
+		m_errorString = m_pPullComponent->getErrorString();
+		m_exec.m_abort = true;
+		if (m_lockPull)
+			m_pPullComponent->unlock();
+		return;
+	}
+
+	// Dependencies make sure the nodes which provide input to this component have
+	// already updated the activity table
+	m_active = m_exec.m_chain.isPullActive(m_exec.m_chain.m_connectionSteps[m_firstConnection], iteration);
+
+	if (pProfiler)
+		t0 = Profiler::getTime();
+
+	if (!m_active)
+	{
+		// Idle, the component isn't pulled in this iteration
+	}
+	else if (m_maxPriority <= m_exec.m_shedPriority)
+	{
+		// All connections are being shed, so the messages aren't needed
+	}
+	else if (m_batchPull)
+	{
+		MIPMessage * const *pMessages = 0;
+		size_t numMessages = 0;
+
+		if (!m_pPullComponent->pullBatch(chain, iteration, pMessages, numMessages))
+		{
+			m_error = true;
+			m_errorComponent = m_pPullComponent->getComponentName();
+			m_errorString = m_pPullComponent->getErrorString();
+			m_exec.m_abort = true;
+			if (m_lockPull)
+				m_pPullComponent->unlock();
+			return;
+		}
+		m_messages.assign(pMessages, pMessages + numMessages);
+	}
+	else
+	{
+		do
+		{
+			if (!m_pPullComponent->pull(chain, iteration, &pMsg))
+			{
+				m_error = true;
+				m_errorComponent = m_pPullComponent->getComponentName();
+				m_errorString = m_pPullComponent->getErrorString();
+				m_exec.m_abort = true;
+				if (m_lockPull)
+					m_pPullComponent->unlock();
+				return;
+			}
+			if (pMsg)
+				m_messages.push_back(pMsg);
+		} while (pMsg);
+	}
+
+	if (pProfiler)
+		pProfiler->m_pullTimes[pProfiler->m_pullSlots[m_firstConnection]] += Profiler::getTime() - t0;
+
+	// The pull component stays locked until all targets have received the
+	// messages, just like in the serial case
+
+	for (size_t i = 1 ; i < m_targets.size() ; i++)
+		m_exec.m_pool.submit(m_targets[i], m_targetGroup);
+
+	m_targets[0]->run();
+
+	if (m_targets.size() > 1)
+		m_exec.m_pool.wait(m_targetGroup);
+
+	if (m_endPull && !m_exec.m_abort && !m_pPullComponent->onIterationEnd(chain, iteration))
+	{
+		m_error = true;
+		m_errorComponent = m_pPullComponent->getComponentName();
+		m_errorString = m_pPullComponent->getErrorString();
+		m_exec.m_abort = true;
+	}
+
+	if (m_lockPull)
+		m_pPullComponent->unlock();
+}
+
+void MIPComponentChain::ParallelTarget::run()
+{
+	const MIPComponentChain &chain = m_node.m_exec.m_chain;
+	int64_t iteration = m_node.m_exec.m_iteration;
+	const std::vector<MIPMessage *> &messages = m_node.m_messages;
+	Profiler *pProfiler = (m_node.m_exec.m_profiling)?m_node.m_exec.m_chain.m_pProfiler:0;
+
+	if (m_lockPush)
+		m_pPushComponent->lock();
+
+	for (size_t i = 0 ; !m_error && i < m_connections.size() ; i++)
+	{
+		const MIPConnection &conn = m_connections[i];
+		const ConnectionStep &step = chain.m_connectionSteps[m_connectionIndices[i]];
+		MIPComponent *pPushComp = conn.getPushComponent();
+		uint32_t mask1 = conn.getMask1();
+		uint32_t mask2 = conn.getMask2();
+		int64_t numMessages = 0;
+		real_t t0 = 0;
+
+		if (step.m_startPush)
+			pPushComp->m_pVerifiedChain = (step.m_verifiedPush)?&chain:0;
+		if (step.m_startPush && !pPushComp->onIterationStart(chain, iteration))
+		{
+			m_error = true;
+			m_errorComponent = pPushComp->getComponentName();
+			m_errorString = pPushComp->getErrorString();
+			m_node.m_exec.m_abort = true;
+			break;
+		}
+
+		if (m_node.m_active)
+			m_node.m_exec.m_chain.markPushInput(step);
+
+		if (pProfiler)
+			t0 = Profiler::getTime();
+
+		if (step.m_priority <= m_node.m_exec.m_shedPriority)
+		{
+			// Nothing is passed on over a connection which is being shed
+		}
+		else if (m_node.m_batchPull) // pass the messages on in one batch as well
+		{
+			MIPMessage * const *pMessages = (messages.empty())?0:&messages[0];
+			size_t num = messages.size();
+
+			if (mask1 != MIPMESSAGE_TYPE_ALL || mask2 != MIPMESSAGE_TYPE_ALL)
+			{
+				m_batchMessages.clear();
+				for (size_t j = 0 ; j < num ; j++)
+				{
+					if ((pMessages[j]->getMessageType()&mask1) && (pMessages[j]->getMessageSubtype()&mask2))
+						m_batchMessages.push_back(pMessages[j]);
+				}
+				num = m_batchMessages.size();
+				pMessages = (num > 0)?&m_batchMessages[0]:0;
+			}
+
+			numMessages = (int64_t)num;
+			if (num > 0 && !pPushComp->pushBatch(chain, iteration, pMessages, num))
+			{
+				m_error = true;
+				m_errorComponent = pPushComp->getComponentName();
+				m_errorString = pPushComp->getErrorString();
+				m_node.m_exec.m_abort = true;
+			}
+		}
+		else
+		{
+			for (size_t j = 0 ; j < messages.size() ; j++)
+			{
+				MIPMessage *pMsg = messages[j];
+
+				if ((pMsg->getMessageType()&mask1) && (pMsg->getMessageSubtype()&mask2))
+				{
+					numMessages++;
+					if (!pPushComp->push(chain, iteration, pMsg))
+					{
+						m_error = true;
+						m_errorComponent = pPushComp->getComponentName();
+						m_errorString = pPushComp->getErrorString();
+						m_node.m_exec.m_abort = true;
+						break;
+					}
+				}
+			}
+		}
+
+		if (pProfiler)
+		{
+			int connIndex = m_connectionIndices[i];
+			real_t dt = Profiler::getTime() - t0;
+
+			pProfiler->m_pushTimes[pProfiler->m_pushSlots[connIndex]] += dt;
+			pProfiler->m_connectionTimes[connIndex] += dt;
+			pProfiler->m_connectionMessages[connIndex] += numMessages;
+		}
+
+		if (!m_error && step.m_endPush && !pPushComp->onIterationEnd(chain, iteration))
+		{
+			m_error = true;
+			m_errorComponent = pPushComp->getComponentName();
+			m_errorString = pPushComp->getErrorString();
+			m_node.m_exec.m_abort = true;
+		}
+	}
+
+	if (m_lockPush)
+		m_pPushComponent->unlock();
+}
+
+void MIPComponentChain::ParallelExecution::clearNodes()
+{
+	for (size_t i = 0 ; i < m_nodes.size() ; i++)
+		delete m_nodes[i];
+	m_nodes.clear();
+}
+
+void MIPComponentChain::ParallelExecution::buildNodes(const std::list<MIPConnection> &orderedList, const std::vector<ConnectionStep> &steps,
+                                                      std::vector<ParallelNode *> &nodes)
+{
+	// The ordered connections are translated into a dependency graph in which
+	// each node only depends on the nodes which handled the same components
+	// before it. Since a node only depends on nodes which were created earlier,
+	// the graph cannot contain cycles.
+
+	std::map<const MIPComponent *, ParallelNode *> lastNode;
+	std::map<const MIPComponent *, ParallelNode *> openGroup;
+	std::list<MIPConnection>::const_iterator it;
+	int connIndex = 0;
+
+	for (it = orderedList.begin() ; it != orderedList.end() ; it++, connIndex++)
+	{
+		const MIPComponent *pPullID = (*it).getPullComponent()->getComponentPointer();
+		const MIPComponent *pPushID = (*it).getPushComponent()->getComponentPointer();
+		ParallelNode *pPrevPull = lastNode[pPullID];
+		ParallelNode *pPrevPush = lastNode[pPushID];
+		ParallelNode *pNode = 0;
+
+		// The connection can be added to the node which last retrieved the messages
+		// of the same component, provided that nothing happened to that component
+		// in the meantime, and that the target component was not used by a later node.
+		// A connection from a component to itself is always handled separately.
+		if (pPullID != pPushID && pPrevPull != 0 && openGroup[pPullID] == pPrevPull &&
+		    (pPrevPush == 0 || pPrevPush->m_index <= pPrevPull->m_index))
+			pNode = pPrevPull;
+
+		const ConnectionStep &step = steps[connIndex];
+
+		if (pNode == 0)
+		{
+			pNode = new ParallelNode(*this, (*it).getPullComponent(), (int)nodes.size());
+			pNode->m_lockPull = !step.m_privatePull;
+			nodes.push_back(pNode);
+			pNode->addDependency(pPrevPull);
+		}
+		pNode->addDependency(pPrevPush);
+		pNode->addConnection(*it, step, connIndex);
+
+		lastNode[pPullID] = pNode;
+		lastNode[pPushID] = pNode;
+
+		// The iteration hooks of the pull component are called by the node
+
+		if (step.m_startPull && pNode->m_firstConnection == connIndex)
+		{
+			pNode->m_startPull = true;
+			pNode->m_verifiedPull = step.m_verifiedPull;
+		}
+		if (step.m_endPull)
+			pNode->m_endPull = true;
+		pNode->m_batchPull = step.m_batchPull;
+
+		if (pPullID != pPushID)
+			openGroup[pPullID] = pNode;
+		else
+			openGroup[pPullID] = 0;
+	}
+}
+
+bool MIPComponentChain::ParallelExecution::runIteration(int64_t iteration, bool profiling, int shedPriority, std::string &errorComponent, std::string &errorString)
+{
+	m_iteration = iteration;
+	m_abort = false;
+	m_profiling = profiling;
+	m_shedPriority = shedPriority;
+
+	for (size_t i = 0 ; i < m_nodes.size() ; i++)
+		m_nodes[i]->m_dependenciesLeft = m_nodes[i]->m_numDependencies;
+
+	for (size_t i = 0 ; i < m_nodes.size() ; i++)
+	{
+		if (m_nodes[i]->m_numDependencies == 0)
+			m_pool.submit(m_nodes[i], m_group);
+	}
+
+	m_pool.wait(m_group);
+
+	if (!m_abort)
+		return true;
+
+	// Report the error in the same way as the serial version would: the first
+	// component which failed, in the order of the connections
+
+	for (size_t i = 0 ; i < m_nodes.size() ; i++)
+	{
+		ParallelNode *pNode = m_nodes[i];
+
+		if (pNode->m_error)
+		{
+			errorComponent = pNode->m_errorComponent;
+			errorString = pNode->m_errorString;
+			return false;
+		}
+
+		for (size_t j = 0 ; j < pNode->m_targets.size() ; j++)
+		{
+			ParallelTarget *pTarget = pNode->m_targets[j];
+
+			if (pTarget->m_error)
+			{
+				errorComponent = pTarget->m_errorComponent;
+				errorString = pTarget->m_errorString;
+				return false;
+			}
+		}
+	}
+	return false;
+}
+
+MIPComponentChain::Profiler::Profiler()
+{
+	int status;
+
+	if ((status = m_mutex.Init()) < 0)
+	{
+		std::cerr << "Error: can't initialize profiler mutex (JMutex error code " << status << ")" << std::endl; 
+		exit(-1);
+	}
+
+	m_enabled = false;
+	m_havePrevStart = false;
+	m_prevStartTime = 0;
+	m_reportInterval = 0;
+	m_lastReportTime = -1;
+	m_resetAfterReport = true;
+}
+
+void MIPComponentChain::Profiler::setEnabled(bool enable, real_t reportInterval, bool resetAfterReport)
+{
+	m_mutex.Lock();
+	m_reportInterval = reportInterval;
+	m_resetAfterReport = resetAfterReport;
+	m_lastReportTime = -1;
+	m_havePrevStart = false;
+	m_enabled = enable;
+	m_mutex.Unlock();
+}
+
+int MIPComponentChain::Profiler::getSlot(MIPComponent *pComp, std::map<MIPComponent *, int> &slots, 
+                                         const std::vector<MIPChainProfile::ComponentInfo> &oldComponents,
+                                         const std::map<const MIPComponent *, size_t> &oldComponentIndex)
+{
+	std::map<MIPComponent *, int>::const_iterator it = slots.find(pComp);
+
+	if (it != slots.end())
+		return it->second;
+
+	int slot = (int)m_profile.m_components.size();
+	std::map<const MIPComponent *, size_t>::const_iterator oldIt = oldComponentIndex.find(pComp);
+
+	// Keep the statistics that were gathered before a rebuild
+	if (oldIt != oldComponentIndex.end())
+		m_profile.m_components.push_back(oldComponents[oldIt->second]);
+	else
+		m_profile.m_components.push_back(MIPChainProfile::ComponentInfo(pComp, pComp->getComponentName()));
+
+	m_componentUsage.push_back(0);
+	slots[pComp] = slot;
+	return slot;
+}
+
+void MIPComponentChain::Profiler::build(const std::list<MIPConnection> &orderedList, const std::list<MIPComponent *> &feedbackChain)
+{
+	std::vector<MIPChainProfile::ComponentInfo> oldComponents;
+	std::vector<MIPChainProfile::ConnectionInfo> oldConnections;
+	std::map<const MIPComponent *, size_t> oldComponentIndex;
+	std::map<std::pair<const MIPComponent *, const MIPComponent *>, std::list<size_t> > oldConnectionIndex;
+	std::map<MIPComponent *, int> slots;
 	std::list<MIPConnection>::const_iterator it;
 	std::list<MIPComponent *>::const_iterator it2;
 
-	m_chainMutex.Lock();
-	
-	m_orderedConnections.clear();
-	m_feedbackChain.clear();
-	
+	m_mutex.Lock();
+
+	oldComponents.swap(m_profile.m_components);
+	oldConnections.swap(m_profile.m_connections);
+	for (size_t i = 0 ; i < oldComponents.size() ; i++)
+		oldComponentIndex[oldComponents[i].m_pComponent] = i;
+	for (size_t i = 0 ; i < oldConnections.size() ; i++)
+		oldConnectionIndex[std::make_pair(oldConnections[i].m_pPull, oldConnections[i].m_pPush)].push_back(i);
+	m_componentUsage.clear();
+	m_pullSlots.clear();
+	m_pushSlots.clear();
+	m_feedbackSlots.clear();
+
 	for (it = orderedList.begin() ; it != orderedList.end() ; it++)
-		m_orderedConnections.push_back(*it);
+	{
+		MIPComponent *pPullComp = (*it).getPullComponent();
+		MIPComponent *pPushComp = (*it).getPushComponent();
+		int pullSlot = getSlot(pPullComp, slots, oldComponents, oldComponentIndex);
+		int pushSlot = getSlot(pPushComp, slots, oldComponents, oldComponentIndex);
+		std::list<size_t> &oldIndices = oldConnectionIndex[std::make_pair((const MIPComponent *)pPullComp, (const MIPComponent *)pPushComp)];
+
+		m_componentUsage[pullSlot] |= UsedForPull;
+		m_componentUsage[pushSlot] |= UsedForPush;
+		m_pullSlots.push_back(pullSlot);
+		m_pushSlots.push_back(pushSlot);
+
+		if (!oldIndices.empty())
+		{
+			m_profile.m_connections.push_back(oldConnections[oldIndices.front()]);
+			oldIndices.pop_front();
+		}
+		else
+			m_profile.m_connections.push_back(MIPChainProfile::ConnectionInfo(pPullComp, pPullComp->getComponentName(), 
+			                                                                  pPushComp, pPushComp->getComponentName()));
+	}
+
 	for (it2 = feedbackChain.begin() ; it2 != feedbackChain.end() ; it2++)
-		m_feedbackChain.push_back(*it2);
-	
-	m_pInternalChainStart = m_pInputChainStart;
+	{
+		if ((*it2) == 0)
+			m_feedbackSlots.push_back(-1);
+		else
+		{
+			int slot = getSlot(*it2, slots, oldComponents, oldComponentIndex);
 
-	m_chainMutex.Unlock();
-}	
+			m_componentUsage[slot] |= UsedForFeedback;
+			m_feedbackSlots.push_back(slot);
+		}
+	}
+
+	m_pullTimes.assign(m_profile.m_components.size(), 0);
+	m_pushTimes.assign(m_profile.m_components.size(), 0);
+	m_feedbackTimes.assign(m_profile.m_components.size(), 0);
+	m_connectionTimes.assign(m_profile.m_connections.size(), 0);
+	m_connectionMessages.assign(m_profile.m_connections.size(), 0);
+
+	m_mutex.Unlock();
+}
+
+bool MIPComponentChain::Profiler::endIteration(real_t startTime, real_t afterStartTime, real_t endTime, MIPChainProfile &report)
+{
+	bool doReport = false;
+
+	m_mutex.Lock();
+
+	if (m_havePrevStart)
+		m_profile.m_interval.add(afterStartTime - m_prevStartTime);
+	m_havePrevStart = true;
+	m_prevStartTime = afterStartTime;
+	m_profile.m_wait.add(afterStartTime - startTime);
+	m_profile.m_processing.add(endTime - afterStartTime);
+
+	for (size_t i = 0 ; i < m_profile.m_components.size() ; i++)
+	{
+		MIPChainProfile::ComponentInfo &info = m_profile.m_components[i];
+		int usage = m_componentUsage[i];
+
+		if (usage&UsedForPull)
+			info.m_pull.add(m_pullTimes[i]);
+		if (usage&UsedForPush)
+			info.m_push.add(m_pushTimes[i]);
+		if (usage&UsedForFeedback)
+			info.m_feedback.add(m_feedbackTimes[i]);
+		info.m_totalTime.add(m_pullTimes[i] + m_pushTimes[i] + m_feedbackTimes[i]);
+
+		m_pullTimes[i] = 0;
+		m_pushTimes[i] = 0;
+		m_feedbackTimes[i] = 0;
+	}
+
+	for (size_t i = 0 ; i < m_profile.m_connections.size() ; i++)
+	{
+		MIPChainProfile::ConnectionInfo &info = m_profile.m_connections[i];
+		int64_t num = m_connectionMessages[i];
+
+		if (info.m_duration.getCount() == 0 || num < info.m_minMessages)
+			info.m_minMessages = num;
+		if (num > info.m_maxMessages)
+			info.m_maxMessages = num;
+		info.m_numMessages += num;
+		info.m_duration.add(m_connectionTimes[i]);
+
+		m_connectionTimes[i] = 0;
+		m_connectionMessages[i] = 0;
+	}
+
+	if (m_reportInterval > 0)
+	{
+		if (m_lastReportTime < 0)
+			m_lastReportTime = endTime;
+		else if (endTime - m_lastReportTime >= m_reportInterval)
+		{
+			report = m_profile;
+			if (m_resetAfterReport)
+				clearStatistics();
+			m_lastReportTime = endTime;
+			doReport = true;
+		}
+	}
+
+	m_mutex.Unlock();
+
+	return doReport;
+}
+
+void MIPComponentChain::Profiler::getProfile(MIPChainProfile &profile)
+{
+	m_mutex.Lock();
+	profile = m_profile;
+	m_mutex.Unlock();
+}
+
+void MIPComponentChain::Profiler::reset()
+{
+	m_mutex.Lock();
+	clearStatistics();
+	m_havePrevStart = false;
+	m_mutex.Unlock();
+}
+
+void MIPComponentChain::Profiler::clearStatistics()
+{
+	m_profile.m_interval.reset();
+	m_profile.m_wait.reset();
+	m_profile.m_processing.reset();
+
+	for (size_t i = 0 ; i < m_profile.m_components.size() ; i++)
+	{
+		MIPChainProfile::ComponentInfo &info = m_profile.m_components[i];
+
+		info.m_push.reset();
+		info.m_pull.reset();
+		info.m_feedback.reset();
+		info.m_totalTime.reset();
+	}
+
+	for (size_t i = 0 ; i < m_profile.m_connections.size() ; i++)
+	{
+		MIPChainProfile::ConnectionInfo &info = m_profile.m_connections[i];
+
+		info.m_duration.reset();
+		info.m_numMessages = 0;
+		info.m_minMessages = 0;
+		info.m_maxMessages = 0;
+	}
+}
@@ -33,11 +33,27 @@
 #include "mipconfig.h"
 #include "miperrorbase.h"
 #include "mipmessage.h"
+#include "miptime.h"
+#include "mipchainprofile.h"
+#include "mipthreadsettings.h"
+#include "mipmessageformat.h"
 #include <jthread/jthread.h>
 #include <string>
 #include <list>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <climits>
+#include <set>
+#include <map>
+
+/** Value returned by MIPComponentChain::getShedPriority when no work is being shed. */
+#define MIPCOMPONENTCHAIN_NOSHEDPRIORITY			INT_MIN
 
 class MIPComponent;
+class MIPChainScheduler;
+class MIPClock;
 
 /** A chain of components.
  *  This class describes a collection of links which exist between specific components. When the
@@ -96,10 +112,15 @@ public:
 	 *  If the feedback flag is set to true, a MIPFeedback message will be passed over this link. This way,
 	 *  it is possible to provide feedback (about introduced delay for example) to components higher up
 	 *  in the chain.
+	 *
+	 *  The priority of a connection is only used when overload protection is enabled (see
+	 *  MIPComponentChain::setOverloadProtection). Connections with a negative priority are
+	 *  considered optional: when the chain is overloaded, no messages are transferred over
+	 *  them anymore, starting with the lowest priority.
 	 */
 	bool addConnection(MIPComponent *pPullComponent, MIPComponent *pPushCompontent, bool feedback = false,
 	                  uint32_t allowedMessageTypes = MIPMESSAGE_TYPE_ALL, 
-	                  uint32_t allowedSubmessageTypes = MIPMESSAGE_TYPE_ALL);
+	                  uint32_t allowedSubmessageTypes = MIPMESSAGE_TYPE_ALL, int priority = 0);
 
 	/** Removes a connection previously added by the addConnection function. */
 	bool deleteConnection(MIPComponent *pPullComponent, MIPComponent *pPushCompontent, bool feedback = false,
@@ -111,8 +132,160 @@ public:
 	 */
 	std::string getName() const									{ return m_chainName; }
 	
-	/** Rebuilds a running chain. */
+	/** Rebuilds a running chain.
+	 *  Rebuilds a running chain, after connections have been added or deleted. The new
+	 *  order in which the connections are processed is determined in the thread which calls
+	 *  this function, and is handed over to the chain, which starts using it at the beginning
+	 *  of its next iteration. The chain itself is therefore not delayed by the rebuild. When
+	 *  the function returns, the new connections are in use, so components which are no
+	 *  longer part of the chain can safely be deleted.
+	 */
 	bool rebuild();
+
+	/** Enables or disables the parallel execution of independent branches of the chain.
+	 *  By default, all connections of the chain are processed one after the other in
+	 *  the chain's background thread. If \c numThreads is larger than zero, a pool of
+	 *  \c numThreads worker threads is started together with the chain, and in each
+	 *  iteration the connections which do not depend on each other are processed
+	 *  concurrently by these threads and the chain's own thread. Every component still
+	 *  sees its MIPComponent::pull and MIPComponent::push calls in the same order as in
+	 *  the serial case, and the feedback pass is only started when all connections have
+	 *  been processed. When a component feeds several other components, its messages are
+	 *  retrieved once and then delivered to these components concurrently, while the
+	 *  component itself remains locked. Components in different branches should therefore
+	 *  not share unprotected state. Setting \c numThreads to zero (the default) disables
+	 *  the parallel mode. This setting can only be changed while the chain is not running.
+	 */
+	bool setNumberOfWorkerThreads(int numThreads);
+
+	/** Returns the number of worker threads used for parallel execution, zero meaning
+	 *  that the connections are processed serially. */
+	int getNumberOfWorkerThreads() const								{ return m_numWorkerThreads; }
+
+	/** Lets the chain be executed by a shared scheduler instead of its own thread.
+	 *  By default, each chain creates its own background thread when it is started. When
+	 *  \c pScheduler is set, the chain is registered with that MIPChainScheduler instead
+	 *  when MIPComponentChain::start is called, and each iteration is executed by one
+	 *  of the scheduler's worker threads when its MIPComponent::getIterationStartTime 
+	 *  function of the start component indicates that it is due. The start, stop and
+	 *  rebuild functions behave in the same way as before, and MIPComponentChain::onThreadExit
+	 *  is still called when the chain stops; after a call to MIPComponentChain::stop this
+	 *  happens in the thread calling that function. The scheduler must remain valid as long
+	 *  as the chain exists, and this setting can only be changed while the chain is not
+	 *  running. Passing a null pointer restores the default behaviour.
+	 */
+	bool setScheduler(MIPChainScheduler *pScheduler);
+
+	/** Returns the scheduler set by MIPComponentChain::setScheduler, or null if the chain
+	 *  uses its own thread. */
+	MIPChainScheduler *getScheduler() const								{ return m_pScheduler; }
+
+	/** Sets the clock which the components in the chain should use.
+	 *  By default, the real-time clock returned by MIPClock::getRealTimeClock is used. By
+	 *  setting a MIPVirtualClock instead, a chain which is driven by a MIPAverageTimer
+	 *  no longer waits for the real time to elapse, but runs as fast as possible while
+	 *  producing the same output. A virtual clock cannot be combined with a scheduler
+	 *  (see MIPComponentChain::setScheduler). The clock must remain valid as long as the
+	 *  chain exists, and this setting can only be changed while the chain is not running.
+	 *  Passing a null pointer restores the default clock.
+	 */
+	bool setClock(MIPClock *pClock);
+
+	/** Returns the clock that should be used by the components of this chain. */
+	MIPClock &getClock() const									{ return *m_pClock; }
+
+	/** Sets how the background thread of the chain should be run.
+	 *  The settings, which can for example request real-time scheduling or restrict the
+	 *  thread to certain processors, are applied by the background thread itself when
+	 *  it is launched by MIPComponentChain::start, before the first iteration is processed.
+	 *  Failing to apply them is not considered an error; use 
+	 *  MIPComponentChain::getThreadSettingsReport to find out what succeeded. When the chain
+	 *  is executed by a scheduler (see MIPComponentChain::setScheduler), the threads are 
+	 *  shared and the settings are not applied. This can only be changed while the chain
+	 *  is not running.
+	 */
+	bool setThreadSettings(const MIPThreadSettings &settings);
+
+	/** Returns the settings set by MIPComponentChain::setThreadSettings. */
+	const MIPThreadSettings &getThreadSettings() const						{ return m_threadSettings; }
+
+	/** Describes which of the thread settings could be applied the last time the
+	 *  chain was started; this information is available when MIPComponentChain::start
+	 *  returns. */
+	const MIPThreadSettingsReport &getThreadSettingsReport() const					{ return m_threadSettingsReport; }
+
+	/** Enables or disables the gathering of profiling information.
+	 *  When profiling is enabled, the chain measures in each iteration how much time is
+	 *  spent in the MIPComponent::push, MIPComponent::pull and MIPComponent::processFeedback
+	 *  functions of each component, how much time each connection takes and how many messages
+	 *  are passed over it, and how long the iteration itself takes compared to the time
+	 *  between iterations. This information can be retrieved at any time using 
+	 *  MIPComponentChain::getProfile. If \c reportInterval is positive, the
+	 *  MIPComponentChain::onProfileReport function will be called from the background thread
+	 *  with a snapshot of the information each time this interval has elapsed; if
+	 *  \c resetAfterReport is true, the information is cleared after each such report.
+	 *  Profiling can be enabled or disabled while the chain is running and is disabled by
+	 *  default. 
+	 */
+	bool setProfiling(bool enable, MIPTime reportInterval = MIPTime(0), bool resetAfterReport = true);
+
+	/** Returns true if profiling is enabled. */
+	bool isProfilingEnabled() const;
+
+	/** Stores a snapshot of the profiling information gathered so far in \c profile. */
+	void getProfile(MIPChainProfile &profile) const;
+
+	/** Clears the profiling information gathered so far. */
+	void resetProfile();
+
+	/** Enables or disables the shedding of low-priority work when the chain is overloaded.
+	 *  When enabled, the chain measures how long the processing of each iteration takes,
+	 *  not counting the time the start component spends waiting. If this exceeds the
+	 *  fraction \c overloadFraction of \c iterationBudget, which is typically the time
+	 *  between iterations, the connections with the lowest negative priority (see
+	 *  MIPComponentChain::addConnection) are no longer used from the next iteration on. This
+	 *  is repeated for the next priority level as long as the overload persists. Once the
+	 *  processing time has stayed below the fraction \c recoveryFraction of the budget for
+	 *  \c recoveryIterations successive iterations, the most recently shed level is
+	 *  restored again. Components are still locked and their MIPComponent::onIterationStart
+	 *  and MIPComponent::onIterationEnd functions are still called when their connections
+	 *  are shed; they can use MIPComponentChain::isPriorityShed to degrade their own work
+	 *  instead. This can be changed while the chain is running and is disabled by default.
+	 */
+	bool setOverloadProtection(bool enable, MIPTime iterationBudget = MIPTime(0), real_t overloadFraction = 0.9,
+	                           real_t recoveryFraction = 0.6, int recoveryIterations = 50);
+
+	/** Returns true if overload protection is enabled. */
+	bool isOverloadProtectionEnabled() const;
+
+	/** Returns true if connections are currently being shed because of overload. */
+	bool isShedding() const										{ return m_shedPriority != MIPCOMPONENTCHAIN_NOSHEDPRIORITY; }
+
+	/** Returns the highest priority which is currently being shed, or MIPCOMPONENTCHAIN_NOSHEDPRIORITY
+	 *  if the chain is not overloaded. */
+	int getShedPriority() const									{ return m_shedPriority; }
+
+	/** Returns true if work with the specified priority is currently being shed. */
+	bool isPriorityShed(int priority) const								{ return priority <= m_shedPriority; }
+
+	/** Enables or disables the verification of the message formats along the connections.
+	 *  When enabled, MIPComponentChain::start and MIPComponentChain::rebuild compare for each
+	 *  connection the formats which the pull component declares in MIPComponent::getOutputMessageFormats
+	 *  (restricted by the message filter of the connection) with those that the push component
+	 *  declares in MIPComponent::getInputMessageFormats. If a format would not be accepted, the
+	 *  chain is not started, unless \c pFactory is set and can create converters for it, for
+	 *  example a MIPSampleEncoder or a MIPSamplingRateConverter (see MIPDefaultConverterFactory).
+	 *  These are then inserted into the connection internally, and are owned by the chain; 
+	 *  a rebuild creates new ones. Connections for which not all formats are known are allowed,
+	 *  but only components for which all incoming connections could be verified will see
+	 *  MIPComponent::isInputVerified return true. The factory must remain valid as long as the
+	 *  chain uses it, and this setting can only be changed while the chain is not running.
+	 *  Negotiation is disabled by default.
+	 */
+	bool setFormatNegotiation(bool enable, MIPMessageConverterFactory *pFactory = 0);
+
+	/** Returns true if format negotiation is enabled. */
+	bool isFormatNegotiationEnabled() const								{ return m_negotiateFormats; }
 protected:
 	/** Function called when the background thread exits.
 	 *  This function is called when the background thread exits. This can happen if the 
@@ -124,12 +297,21 @@ protected:
 	 */
 	virtual void onThreadExit(bool error, const std::string &errorComponent,
 	                          const std::string &errorDescription)					{ }
+
+	/** Function called periodically when profiling is enabled.
+	 *  When a report interval was specified in MIPComponentChain::setProfiling, this
+	 *  function is called from the background thread each time that interval has elapsed.
+	 *  The chain's components are not locked at that time, but the next iteration of the
+	 *  chain is only started after this function returns, so an implementation should not
+	 *  block.
+	 */
+	virtual void onProfileReport(const MIPChainProfile &)						{ }
 private:
 	class MIPConnection
 	{
 	public:
 		MIPConnection(MIPComponent *pPull, MIPComponent *pPush, bool feedback, uint32_t mask1,
-		              uint32_t mask2)								{ m_mask1 = mask1; m_mask2 = mask2; m_pPull = pPull; m_pPush = pPush; m_marked = false; m_feedback = feedback; }
+		              uint32_t mask2, int priority = 0)						{ m_mask1 = mask1; m_mask2 = mask2; m_pPull = pPull; m_pPush = pPush; m_marked = false; m_feedback = feedback; m_priority = priority; }
 		MIPComponent *getPullComponent() const							{ return m_pPull; }
 		MIPComponent *getPushComponent() const							{ return m_pPush; }
 		bool isMarked() const									{ return m_marked; }
@@ -137,6 +319,7 @@ private:
 		uint32_t getMask1() const								{ return m_mask1; }
 		uint32_t getMask2() const								{ return m_mask2; }
 		bool giveFeedback() const								{ return m_feedback; }
+		int getPriority() const									{ return m_priority; }
 		bool operator==(const MIPConnection &c)	const						{ if (m_pPull == c.m_pPull && m_pPush == c.m_pPush && m_mask1 == c.m_mask1 && m_mask2 == c.m_mask2 && m_feedback == c.m_feedback) return true; return false; }
 	private:
 		MIPComponent *m_pPull, *m_pPush;
@@ -144,17 +327,82 @@ private:
 		uint32_t m_mask2;
 		bool m_marked;
 		bool m_feedback;
+		int m_priority;
+	};
+
+	// A connection, together with the locking actions which are needed when the
+	// connections are processed in order. A component which is used in successive
+	// connections stays locked if this does not change the order in which locks
+	// are acquired. The start and end flags indicate that a component is used for
+	// the first or last time in an iteration. If the pull component supports it,
+	// its messages are retrieved and passed on in one batch. Nothing is transferred
+	// over the connection while its priority is being shed. Chain-private components
+	// are never locked. The verified flags indicate that all messages passed to a
+	// component in this chain were checked against its declared input formats.
+	class ConnectionStep
+	{
+	public:
+		ConnectionStep(const MIPConnection &conn, bool separatePush)				{ m_pPull = conn.getPullComponent(); m_pPush = conn.getPushComponent(); m_mask1 = conn.getMask1(); m_mask2 = conn.getMask2(); m_priority = conn.getPriority();
+													  m_separatePush = separatePush; m_lockPull = true; m_lockPush = m_separatePush; m_unlockPull = true; m_unlockPush = m_separatePush;
+													  m_startPull = false; m_startPush = false; m_endPull = false; m_endPush = false; m_batchPull = false;
+													  m_privatePull = false; m_privatePush = false; m_verifiedPull = false; m_verifiedPush = false;
+													  m_pullSlot = 0; m_pushSlot = 0; m_firstPull = false; }
+
+		MIPComponent *m_pPull, *m_pPush;
+		uint32_t m_mask1, m_mask2;
+		int m_priority;
+		bool m_separatePush;
+		bool m_lockPull, m_lockPush;
+		bool m_unlockPull, m_unlockPush;
+		bool m_startPull, m_startPush;
+		bool m_endPull, m_endPush;
+		bool m_batchPull;
+		bool m_privatePull, m_privatePush;
+		bool m_verifiedPull, m_verifiedPush;
+		int m_pullSlot, m_pushSlot;
+		bool m_firstPull;
 	};
 
+	class CompiledState;
+	class ParallelExecution;
+	class ParallelNode;
+	class ParallelTarget;
+	class Profiler;
+	class ScheduledTask;
+
 	void *Thread();
+	bool isRunning();
+	bool processIteration(int64_t iteration, MIPChainProfile &profileReport, std::string &errorComponent, std::string &errorString);
+	bool isPullActive(const ConnectionStep &step, int64_t iteration);
+	void markPushInput(const ConnectionStep &step);
+	bool processBatchStep(const ConnectionStep &step, int connIndex, int64_t iteration, bool profiling, std::string &errorComponent, std::string &errorString);
+	bool getIterationStartTime(int64_t iteration, MIPTime &startTime, std::string &errorComponent, std::string &errorString);
 	bool orderConnections(std::list<MIPConnection> &orderedConnections);
+	bool negotiateFormats(std::list<MIPConnection> &orderedList, CompiledState &state);
+	int checkFormats(const MIPConnection &conn, std::map<const MIPComponent *, std::pair<int, int> > &inputProperties, 
+	                 const std::map<const MIPComponent *, int> &remainingInputs, std::vector<MIPMessageFormat> &accepted,
+	                 MIPMessageFormat &mismatch);
 	bool buildFeedbackList(std::list<MIPConnection> &orderedList, std::list<MIPComponent *> &feedbackChain);
-	void copyConnectionInfo(const std::list<MIPConnection> &orderedList, const std::list<MIPComponent *> &feedbackChain);
+	void compileState(const std::list<MIPConnection> &orderedList, const std::list<MIPComponent *> &feedbackChain, CompiledState &state);
+	void installState(CompiledState &state);
+	void applyPendingState();
+	void updateOverloadState(real_t processingTime);
+	void getUsedComponents(const std::list<MIPConnection> &orderedList, std::set<MIPComponent *> &components);
+	bool registerComponents(const std::set<MIPComponent *> &components, std::set<const MIPComponent *> &used,
+	                        std::set<const MIPComponent *> &privateComponents);
+	void unregisterComponents(const std::set<const MIPComponent *> &components);
 	
 	std::string m_chainName;
 	std::list<MIPConnection> m_inputConnections;
-	std::list<MIPConnection> m_orderedConnections;
-	std::list<MIPComponent *> m_feedbackChain;
+	std::vector<ConnectionStep> m_connectionSteps;
+	std::vector<MIPComponent *> m_feedbackSteps;
+	std::vector<bool> m_feedbackLocks;
+	std::vector<MIPMessage *> m_batchMessages;
+	std::vector<uint8_t> m_initialActivity, m_activity;
+	bool m_endStartComponent;
+	bool m_lockStart;
+	std::set<const MIPComponent *> m_usedComponents;
+	std::vector<MIPComponent *> m_converters;
 	MIPComponent *m_pInputChainStart;	
 	MIPComponent *m_pInternalChainStart;
 
@@ -162,6 +410,32 @@ private:
 	jthread::JMutex m_chainMutex;
 	bool m_stopLoop;
 
+	CompiledState *m_pPendingState;
+	std::atomic<bool> m_havePendingState;
+	std::mutex m_pendingMutex;
+	std::condition_variable m_pendingCond;
+
+	int m_numWorkerThreads;
+	ParallelExecution *m_pParallelExec;
+	Profiler *m_pProfiler;
+
+	MIPChainScheduler *m_pScheduler, *m_pActiveScheduler;
+	MIPClock *m_pClock;
+	MIPThreadSettings m_threadSettings;
+	MIPThreadSettingsReport m_threadSettingsReport;
+	ScheduledTask *m_pScheduledTask;
+	bool m_scheduledRunning;
+
+	bool m_negotiateFormats;
+	MIPMessageConverterFactory *m_pConverterFactory;
+
+	bool m_overloadProtection;
+	real_t m_iterationBudget, m_overloadFraction, m_recoveryFraction;
+	int m_recoveryIterations, m_calmIterations;
+	std::vector<int> m_shedLevels;
+	int m_numShedLevels;
+	std::atomic<int> m_shedPriority;
+
 	uint32_t m_dummy;
 };
 
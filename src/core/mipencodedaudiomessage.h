@@ -33,6 +33,7 @@
 #include "mipconfig.h"
 #include "mipaudiomessage.h"
 #include "miptime.h"
+#include "mipsharedbuffer.h"
 #include <string.h>
 
 /**
@@ -78,8 +79,23 @@ public:
 	 */
 	MIPEncodedAudioMessage(uint32_t subType, int samplingRate, int numChannels, 
 	                       int numFrames, uint8_t *pData, size_t numBytes, bool deleteData) : MIPAudioMessage(false, subType, samplingRate, numChannels, numFrames)
-													{ m_deleteData = deleteData; m_pData = pData; m_dataLength = numBytes; }
-	~MIPEncodedAudioMessage()									{ if (m_deleteData) delete [] m_pData; }
+													{ m_deleteData = deleteData; m_pData = pData; m_dataLength = numBytes; m_pSharedData = 0; }
+
+	/** Creates an encoded audio message which refers to a shared buffer.
+	 *  Creates an encoded audio message which refers to a shared buffer. The message takes
+	 *  over the caller's reference to \c pSharedData, and copies of the message will refer
+	 *  to the same buffer instead of duplicating the encoded data.
+	 *  \param subType The subtype of the message.
+	 *  \param samplingRate The sampling rate.
+	 *  \param numChannels The number of channels.
+	 *  \param numFrames The number of frames contained in the message.
+	 *  \param pSharedData The buffer containing the encoded audio data.
+	 *  \param numBytes The length of the encoded audio data.
+	 */
+	MIPEncodedAudioMessage(uint32_t subType, int samplingRate, int numChannels, 
+	                       int numFrames, MIPSharedBuffer<uint8_t> *pSharedData, size_t numBytes) : MIPAudioMessage(false, subType, samplingRate, numChannels, numFrames)
+													{ m_deleteData = false; m_pData = pSharedData->getData(); m_dataLength = numBytes; m_pSharedData = pSharedData; }
+	~MIPEncodedAudioMessage()									{ if (m_pSharedData) m_pSharedData->release(); else if (m_deleteData) delete [] m_pData; }
 
 	/** Returns a pointer to the encoded audio data. */
 	const uint8_t *getData() const									{ return m_pData; }
@@ -90,22 +106,30 @@ public:
 	/** Sets the length of the encoded audio to 'l'. */
 	void setDataLength(size_t l)									{ m_dataLength = l; }
 
-	/** Creates a copy of this message. */
+	/** Creates a copy of this message, which shares the encoded data with this message if possible. */
 	MIPMediaMessage *createCopy() const;
 private:
 	bool m_deleteData;
 	uint8_t *m_pData;
 	size_t m_dataLength;
+	MIPSharedBuffer<uint8_t> *m_pSharedData;
 };
 
 inline MIPMediaMessage *MIPEncodedAudioMessage::createCopy() const
 {
-	uint8_t *pBytes = new uint8_t [m_dataLength];
+	MIPSharedBuffer<uint8_t> *pSharedData = m_pSharedData;
+
+	if (pSharedData)
+		pSharedData->addReference();
+	else
+	{
+		pSharedData = MIPSharedBuffer<uint8_t>::create(m_dataLength);
+		memcpy(pSharedData->getData(), m_pData, m_dataLength);
+	}
 
-	memcpy(pBytes, m_pData, m_dataLength);
 	MIPMediaMessage *pMsg = new MIPEncodedAudioMessage(getMessageSubtype(), getSamplingRate(),
 			                                   getNumberOfChannels(), getNumberOfFrames(),
-							   pBytes, m_dataLength, true);
+							   pSharedData, m_dataLength);
 	pMsg->copyMediaInfoFrom(*this);
 	return pMsg;
 }
@@ -34,6 +34,7 @@
 #include "mipvideomessage.h"
 #include "miptypes.h"
 #include "miptime.h"
+#include "mipsharedbuffer.h"
 #include <string.h>
 
 /**
@@ -59,8 +60,21 @@ public:
 	 *                    be deleted when this message is destroyed.
 	 */
 	MIPEncodedVideoMessage(uint32_t msgSubtype, int width, int height, uint8_t *pData, size_t dataLength, bool deleteData) : MIPVideoMessage(false, msgSubtype, width, height)
-												{ m_pData = pData; m_dataLength = dataLength; m_deleteData = deleteData; }
-	~MIPEncodedVideoMessage()								{ if (m_deleteData) delete [] m_pData; }
+												{ m_pData = pData; m_dataLength = dataLength; m_deleteData = deleteData; m_pSharedData = 0; }
+
+	/** Creates an encoded video message which refers to a shared buffer.
+	 *  Creates an encoded video message which refers to a shared buffer. The message takes
+	 *  over the caller's reference to \c pSharedData, and copies of the message will refer
+	 *  to the same buffer instead of duplicating the encoded data.
+	 *  \param msgSubtype Message subtype.
+	 *  \param width Width of the video frame.
+	 *  \param height Height of the video frame.
+	 *  \param pSharedData The buffer containing the encoded video data.
+	 *  \param dataLength The length of the encoded video data.
+	 */
+	MIPEncodedVideoMessage(uint32_t msgSubtype, int width, int height, MIPSharedBuffer<uint8_t> *pSharedData, size_t dataLength) : MIPVideoMessage(false, msgSubtype, width, height)
+												{ m_pData = pSharedData->getData(); m_dataLength = dataLength; m_deleteData = false; m_pSharedData = pSharedData; }
+	~MIPEncodedVideoMessage()								{ if (m_pSharedData) m_pSharedData->release(); else if (m_deleteData) delete [] m_pData; }
 	
 	/** Returns the encoded image data. */
 	const uint8_t *getImageData() const							{ return m_pData; }
@@ -71,13 +85,21 @@ public:
 	/** Sets the length of the encoded image data. */
 	void setDataLength(size_t l)								{ m_dataLength = l; }
 
-	/** Create a copy of this message. */
+	/** Create a copy of this message, which shares the encoded data with this message if possible. */
 	MIPMediaMessage *createCopy() const
 	{
-		uint8_t *pData = new uint8_t [m_dataLength];
-		memcpy(pData, m_pData, m_dataLength);
+		MIPSharedBuffer<uint8_t> *pSharedData = m_pSharedData;
+
+		if (pSharedData)
+			pSharedData->addReference();
+		else
+		{
+			pSharedData = MIPSharedBuffer<uint8_t>::create(m_dataLength);
+			memcpy(pSharedData->getData(), m_pData, m_dataLength);
+		}
+
 		MIPMediaMessage *pMsg = new MIPEncodedVideoMessage(getMessageSubtype(), getWidth(), getHeight(),
-		                                                   pData, m_dataLength, true);
+		                                                   pSharedData, m_dataLength);
 		pMsg->copyMediaInfoFrom(*this);
 		return pMsg;
 	}
@@ -85,6 +107,7 @@ private:
 	bool m_deleteData;
 	uint8_t *m_pData;
 	size_t m_dataLength;
+	MIPSharedBuffer<uint8_t> *m_pSharedData;
 };
 
 #endif // MIPENCODEDVIDEOMESSAGE_H
@@ -0,0 +1,93 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipmessageformat.h
+ */
+
+#ifndef MIPMESSAGEFORMAT_H
+
+#define MIPMESSAGEFORMAT_H
+
+#include "mipconfig.h"
+#include "miptypes.h"
+#include <vector>
+
+class MIPComponent;
+
+/** Describes a kind of message which a component accepts or produces.
+ *  A format consists of a message type, a set of message subtypes (the subtypes
+ *  used in EMIPLIB are bit flags, so several can be combined), and for audio
+ *  messages optionally a sampling rate and a number of channels. Components use
+ *  this in MIPComponent::getInputMessageFormats and MIPComponent::getOutputMessageFormats,
+ *  so that a chain can verify the connections between them when it is started.
+ *  A sampling rate or number of channels of zero means that any value is accepted,
+ *  or, for a produced format, that the value is the same as that of the incoming
+ *  messages.
+ */
+class EMIPLIB_IMPORTEXPORT MIPMessageFormat
+{
+public:
+	MIPMessageFormat(uint32_t messageType, uint32_t messageSubtypes, int samplingRate = 0, int numChannels = 0)
+													{ m_type = messageType; m_subtypes = messageSubtypes; m_sampRate = samplingRate; m_channels = numChannels; }
+
+	/** Returns the message type. */
+	uint32_t getMessageType() const									{ return m_type; }
+
+	/** Returns the combination of message subtypes. */
+	uint32_t getMessageSubtypes() const								{ return m_subtypes; }
+
+	/** Returns the sampling rate, or zero if it isn't specified. */
+	int getSamplingRate() const									{ return m_sampRate; }
+
+	/** Returns the number of channels, or zero if it isn't specified. */
+	int getNumberOfChannels() const									{ return m_channels; }
+private:
+	uint32_t m_type, m_subtypes;
+	int m_sampRate, m_channels;
+};
+
+/** Interface used by a chain to create components which convert between message formats.
+ *  When format negotiation is enabled with a factory (see MIPComponentChain::setFormatNegotiation),
+ *  the chain asks the factory for converters for each connection over which messages are
+ *  sent which the receiving component doesn't accept.
+ */
+class EMIPLIB_IMPORTEXPORT MIPMessageConverterFactory
+{
+public:
+	MIPMessageConverterFactory()									{ }
+	virtual ~MIPMessageConverterFactory()								{ }
+
+	/** Creates the components needed to convert messages of format \c produced into one of 
+	 *  the formats in \c accepted. The subtype of \c produced contains a single flag. The
+	 *  components should be initialized and stored in \c converters, in the order in which
+	 *  the messages should pass through them; they will be deleted by the chain. If no 
+	 *  conversion is possible, false should be returned.
+	 */
+	virtual bool createConverters(const MIPMessageFormat &produced, const std::vector<MIPMessageFormat> &accepted, 
+	                              std::vector<MIPComponent *> &converters) = 0;
+};
+
+#endif // MIPMESSAGEFORMAT_H
+
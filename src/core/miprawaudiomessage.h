@@ -33,6 +33,7 @@
 #include "mipconfig.h"
 #include "mipaudiomessage.h"
 #include "miptime.h"
+#include "mipsharedbuffer.h"
 #include <string.h>
 
 /**
@@ -85,8 +86,20 @@ public:
 	 *                      deleted when this message is destroyed or when the data is replaced.
 	 */
 	MIPRawFloatAudioMessage(int sampRate, int numChannels, int numFrames, float *pFrames, bool deleteFrames) : MIPAudioMessage(true, MIPRAWAUDIOMESSAGE_TYPE_FLOAT, sampRate, numChannels, numFrames)
-												{ m_pFrames = pFrames; m_deleteFrames = deleteFrames; }
-	~MIPRawFloatAudioMessage()								{ if (m_deleteFrames) delete [] m_pFrames; }
+												{ m_pFrames = pFrames; m_deleteFrames = deleteFrames; m_pSharedFrames = 0; }
+
+	/** Creates a MIPRawFloatAudioMessage instance which refers to a shared buffer.
+	 *  Creates a MIPRawFloatAudioMessage instance which refers to a shared buffer. The message
+	 *  takes over the caller's reference to \c pSharedFrames, and copies of the message will
+	 *  refer to the same buffer instead of duplicating the audio data.
+	 *  \param sampRate Sampling rate.
+	 *  \param numChannels Number of channels.
+	 *  \param numFrames Number of frames.
+	 *  \param pSharedFrames The buffer containing the audio data.
+	 */
+	MIPRawFloatAudioMessage(int sampRate, int numChannels, int numFrames, MIPSharedBuffer<float> *pSharedFrames) : MIPAudioMessage(true, MIPRAWAUDIOMESSAGE_TYPE_FLOAT, sampRate, numChannels, numFrames)
+												{ m_pFrames = pSharedFrames->getData(); m_deleteFrames = false; m_pSharedFrames = pSharedFrames; }
+	~MIPRawFloatAudioMessage()								{ clearFrames(); }
 
 	/** Returns the audio data. */
 	const float *getFrames() const								{ return m_pFrames; }
@@ -97,23 +110,41 @@ public:
 	 *  \param deleteFrames Flag indicating if the data contained in \c pFrames should be
 	 *                      deleted when this message is destroyed or when the data is replaced.
 	 */
-	void setFrames(float *pFrames, bool deleteFrames)					{ if (m_deleteFrames) delete [] m_pFrames; m_pFrames = pFrames; m_deleteFrames = deleteFrames; }
+	void setFrames(float *pFrames, bool deleteFrames)					{ clearFrames(); m_pFrames = pFrames; m_deleteFrames = deleteFrames; }
 
-	/** Create a copy of this message. */
+	/** Stores audio data contained in a shared buffer, taking over the caller's reference to it. */
+	void setFrames(MIPSharedBuffer<float> *pSharedFrames)					{ clearFrames(); m_pFrames = pSharedFrames->getData(); m_pSharedFrames = pSharedFrames; }
+
+	/** Create a copy of this message.
+	 *  Create a copy of this message. If the audio data is stored in a shared buffer, the
+	 *  copy will refer to the same buffer. Otherwise, the data is copied into a new shared
+	 *  buffer, so that subsequent copies of the copy are cheap.
+	 */
 	MIPMediaMessage *createCopy() const
 	{
-		size_t numSamples = getNumberOfFrames()*getNumberOfChannels();
-		float *pFrames = new float [numSamples];
+		MIPSharedBuffer<float> *pSharedFrames = m_pSharedFrames;
+
+		if (pSharedFrames)
+			pSharedFrames->addReference();
+		else
+		{
+			size_t numSamples = getNumberOfFrames()*getNumberOfChannels();
+
+			pSharedFrames = MIPSharedBuffer<float>::create(numSamples);
+			memcpy(pSharedFrames->getData(), m_pFrames, numSamples*sizeof(float));
+		}
 
-		memcpy(pFrames, m_pFrames, numSamples*sizeof(float));
 		MIPMediaMessage *pMsg = new MIPRawFloatAudioMessage(getSamplingRate(), getNumberOfChannels(),
-		                                                    getNumberOfFrames(), pFrames, true);
+		                                                    getNumberOfFrames(), pSharedFrames);
 		pMsg->copyMediaInfoFrom(*this);
 		return pMsg;
 	}
 private:
+	void clearFrames()									{ if (m_pSharedFrames) { m_pSharedFrames->release(); m_pSharedFrames = 0; } else if (m_deleteFrames) delete [] m_pFrames; m_deleteFrames = false; }
+
 	float *m_pFrames;
 	bool m_deleteFrames;
+	MIPSharedBuffer<float> *m_pSharedFrames;
 };
 
 /** Container for unsigned eight-bit raw audio data. */
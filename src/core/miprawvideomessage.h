@@ -34,6 +34,7 @@
 #include "mipvideomessage.h"
 #include "miptypes.h"
 #include "miptime.h"
+#include "mipsharedbuffer.h"
 #include <string.h>
 
 /**
@@ -69,26 +70,49 @@ public:
 	 *                    deleted when this message is destroyed or when the data is replaced.
 	 */
 	MIPRawYUV420PVideoMessage(int width, int height, uint8_t *pData, bool deleteData) : MIPVideoMessage(true, MIPRAWVIDEOMESSAGE_TYPE_YUV420P, width, height)
-												{ m_pData = pData; m_deleteData = deleteData; }
-	~MIPRawYUV420PVideoMessage()								{ if (m_deleteData) delete [] m_pData; }
+												{ m_pData = pData; m_deleteData = deleteData; m_pSharedData = 0; }
+
+	/** Creates a raw video message with a YUV420P representation, stored in a shared buffer.
+	 *  Creates a raw video message with a YUV420P representation, stored in a shared buffer.
+	 *  The message takes over the caller's reference to \c pSharedData, and copies of the
+	 *  message will refer to the same buffer instead of duplicating the frame.
+	 *  \param width Width of the video frame.
+	 *  \param height Height of the video frame.
+	 *  \param pSharedData The buffer containing the data of the video frame.
+	 */
+	MIPRawYUV420PVideoMessage(int width, int height, MIPSharedBuffer<uint8_t> *pSharedData) : MIPVideoMessage(true, MIPRAWVIDEOMESSAGE_TYPE_YUV420P, width, height)
+												{ m_pData = pSharedData->getData(); m_deleteData = false; m_pSharedData = pSharedData; }
+	~MIPRawYUV420PVideoMessage()								{ if (m_pSharedData) m_pSharedData->release(); else if (m_deleteData) delete [] m_pData; }
 
 	/** Returns the image data. */
 	const uint8_t *getImageData() const							{ return m_pData; }
 
-	/** Returns a copy of the message. */
+	/** Returns a copy of the message.
+	 *  Returns a copy of the message. If the frame is stored in a shared buffer, the copy
+	 *  will refer to the same buffer. Otherwise, the frame is copied into a new shared buffer.
+	 */
 	MIPMediaMessage *createCopy() const
 	{
-		size_t dataSize = (getWidth()*getHeight()*3)/2;
-		uint8_t *pData = new uint8_t [dataSize];
+		MIPSharedBuffer<uint8_t> *pSharedData = m_pSharedData;
 
-		memcpy(pData, m_pData, dataSize);
-		MIPMediaMessage *pMsg = new MIPRawYUV420PVideoMessage(getWidth(), getHeight(), pData, true);
+		if (pSharedData)
+			pSharedData->addReference();
+		else
+		{
+			size_t dataSize = (getWidth()*getHeight()*3)/2;
+
+			pSharedData = MIPSharedBuffer<uint8_t>::create(dataSize);
+			memcpy(pSharedData->getData(), m_pData, dataSize);
+		}
+
+		MIPMediaMessage *pMsg = new MIPRawYUV420PVideoMessage(getWidth(), getHeight(), pSharedData);
 		pMsg->copyMediaInfoFrom(*this);
 		return pMsg;
 	}
 private:
 	bool m_deleteData;
 	uint8_t *m_pData;
+	MIPSharedBuffer<uint8_t> *m_pSharedData;
 };
 
 /** Container for an YUYV encoded raw video frame. */
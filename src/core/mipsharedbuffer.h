@@ -0,0 +1,216 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipsharedbuffer.h
+ */
+
+#ifndef MIPSHAREDBUFFER_H
+
+#define MIPSHAREDBUFFER_H
+
+#include "mipconfig.h"
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+template<class T> class MIPSharedBufferPool;
+
+/** Reference counted block of memory which can be shared by several messages.
+ *  Media messages which are constructed using such a buffer do not need to copy their
+ *  data when MIPMediaMessage::createCopy is called: the copy simply refers to the same
+ *  buffer. Because of this, the contents of the buffer may no longer be modified once
+ *  it has been handed to a message. The buffer is released when the last reference to
+ *  it is dropped, or returned to its MIPSharedBufferPool if it was obtained from one.
+ */
+template<class T>
+class MIPSharedBuffer
+{
+public:
+	/** Creates a shared buffer for \c numElements elements, with a reference count of one. */
+	static MIPSharedBuffer<T> *create(size_t numElements)					{ return new MIPSharedBuffer<T>(new T [numElements], numElements); }
+
+	/** Creates a shared buffer which takes ownership of \c pData.
+	 *  Creates a shared buffer which takes ownership of \c pData, which must have been
+	 *  allocated using \c new []. The reference count of the buffer will be one.
+	 */
+	static MIPSharedBuffer<T> *create(T *pData, size_t numElements)				{ return new MIPSharedBuffer<T>(pData, numElements); }
+
+	/** Returns a pointer to the data, which may only be modified before the buffer is shared. */
+	T *getData() const									{ return m_pData; }
+
+	/** Returns the number of elements in the buffer; for pooled buffers this can be more than was requested. */
+	size_t getNumberOfElements() const							{ return m_numElements; }
+
+	/** Returns \c true if more than one reference to the buffer exists. */
+	bool isShared() const									{ return m_refCount.load(std::memory_order_acquire) > 1; }
+
+	/** Adds a reference to the buffer. */
+	void addReference()									{ m_refCount.fetch_add(1, std::memory_order_relaxed); }
+
+	/** Drops a reference to the buffer, deleting or recycling it when this was the last one. */
+	void release();
+private:
+	MIPSharedBuffer(T *pData, size_t numElements) : m_refCount(1)				{ m_pData = pData; m_numElements = numElements; m_pPool = 0; }
+	~MIPSharedBuffer()									{ delete [] m_pData; }
+
+	T *m_pData;
+	size_t m_numElements;
+	std::atomic<int> m_refCount;
+	MIPSharedBufferPool<T> *m_pPool;
+
+	friend class MIPSharedBufferPool<T>;
+};
+
+/** Pool of MIPSharedBuffer instances, to avoid allocating sample buffers for each block.
+ *  Components which create a new buffer for every message they produce can obtain
+ *  these buffers from a pool instead. When the last message referring to such a buffer
+ *  is destroyed, which usually happens at the start of the next iteration, the buffer is
+ *  put on a free list for its size class instead of being deleted. Size classes are
+ *  powers of two, starting at MinimumElements elements.
+ *
+ *  The pool itself is reference counted as well: the creator holds one reference and
+ *  each buffer which is in use holds another one. This way the pool stays valid as long
+ *  as messages refer to its buffers, even if the component which created it is already
+ *  destroyed.
+ */
+template<class T>
+class MIPSharedBufferPool
+{
+public:
+	/** Smallest size class of the pool. */
+	static const size_t MinimumElements = 64;
+
+	/** Creates a new pool, of which the caller holds the only reference.
+	 *  Creates a new pool, of which the caller holds the only reference.
+	 *  \param maxFreeBuffers The maximum number of unused buffers kept for each size class.
+	 */
+	static MIPSharedBufferPool<T> *create(size_t maxFreeBuffers = 64)			{ return new MIPSharedBufferPool<T>(maxFreeBuffers); }
+
+	/** Returns a buffer which can hold at least \c numElements elements, with a reference count of one. */
+	MIPSharedBuffer<T> *getBuffer(size_t numElements);
+
+	/** Drops the caller's reference to the pool. */
+	void release()										{ if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; }
+private:
+	MIPSharedBufferPool(size_t maxFreeBuffers) : m_refCount(1)				{ m_maxFreeBuffers = maxFreeBuffers; }
+	~MIPSharedBufferPool();
+
+	void recycle(MIPSharedBuffer<T> *pBuf);
+
+	std::mutex m_mutex;
+	std::vector<std::vector<MIPSharedBuffer<T> *> > m_freeBuffers;
+	size_t m_maxFreeBuffers;
+	std::atomic<int> m_refCount;
+
+	friend class MIPSharedBuffer<T>;
+};
+
+template<class T>
+inline void MIPSharedBuffer<T>::release()
+{
+	if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	if (m_pPool)
+		m_pPool->recycle(this);
+	else
+		delete this;
+}
+
+template<class T>
+inline MIPSharedBuffer<T> *MIPSharedBufferPool<T>::getBuffer(size_t numElements)
+{
+	size_t sizeClass = 0;
+	size_t capacity = MinimumElements;
+
+	while (capacity < numElements)
+	{
+		capacity <<= 1;
+		sizeClass++;
+	}
+
+	MIPSharedBuffer<T> *pBuf = 0;
+
+	m_mutex.lock();
+	if (sizeClass < m_freeBuffers.size() && !m_freeBuffers[sizeClass].empty())
+	{
+		pBuf = m_freeBuffers[sizeClass].back();
+		m_freeBuffers[sizeClass].pop_back();
+	}
+	m_mutex.unlock();
+
+	if (pBuf == 0)
+	{
+		pBuf = new MIPSharedBuffer<T>(new T [capacity], capacity);
+		pBuf->m_pPool = this;
+	}
+	else
+		pBuf->m_refCount.store(1, std::memory_order_relaxed);
+
+	m_refCount.fetch_add(1, std::memory_order_relaxed);
+	return pBuf;
+}
+
+template<class T>
+inline void MIPSharedBufferPool<T>::recycle(MIPSharedBuffer<T> *pBuf)
+{
+	size_t sizeClass = 0;
+	size_t capacity = MinimumElements;
+
+	while (capacity < pBuf->m_numElements)
+	{
+		capacity <<= 1;
+		sizeClass++;
+	}
+
+	m_mutex.lock();
+	if (m_freeBuffers.size() <= sizeClass)
+		m_freeBuffers.resize(sizeClass+1);
+
+	if (m_freeBuffers[sizeClass].size() < m_maxFreeBuffers)
+	{
+		m_freeBuffers[sizeClass].push_back(pBuf);
+		pBuf = 0;
+	}
+	m_mutex.unlock();
+
+	if (pBuf)
+		delete pBuf;
+	release();
+}
+
+template<class T>
+inline MIPSharedBufferPool<T>::~MIPSharedBufferPool()
+{
+	for (size_t i = 0 ; i < m_freeBuffers.size() ; i++)
+	{
+		for (size_t j = 0 ; j < m_freeBuffers[i].size() ; j++)
+			delete m_freeBuffers[i][j];
+	}
+}
+
+#endif // MIPSHAREDBUFFER_H
+
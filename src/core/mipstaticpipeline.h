@@ -0,0 +1,353 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipstaticpipeline.h
+ */
+
+#ifndef MIPSTATICPIPELINE_H
+
+#define MIPSTATICPIPELINE_H
+
+#include "mipconfig.h"
+#include "mipcomponent.h"
+#include <stddef.h>
+#include <string>
+#include <tuple>
+
+/** \internal
+ *  Performs the operations of MIPStaticPipeline on stage \c I and the stages after it.
+ *  All calls are qualified with the type of the stage, so that they are resolved
+ *  at compile time instead of through the virtual function table.
+ */
+template<size_t I, bool End, class... Components>
+struct MIPStaticPipelineStages
+{
+	typedef std::tuple<Components *...> Stages;
+	typedef typename std::tuple_element<I, std::tuple<Components...> >::type Stage;
+	typedef MIPStaticPipelineStages<I+1, (I+1 == sizeof...(Components)), Components...> Next;
+
+	static bool onIterationStart(Stages &stages, const MIPComponentChain &chain, int64_t iteration, MIPComponent *&pFailed)
+	{
+		Stage *pStage = std::get<I>(stages);
+
+		if (!pStage->Stage::onIterationStart(chain, iteration))
+		{
+			pFailed = pStage;
+			return false;
+		}
+		return Next::onIterationStart(stages, chain, iteration, pFailed);
+	}
+
+	static bool onIterationEnd(Stages &stages, const MIPComponentChain &chain, int64_t iteration, MIPComponent *&pFailed)
+	{
+		Stage *pStage = std::get<I>(stages);
+
+		if (!pStage->Stage::onIterationEnd(chain, iteration))
+		{
+			pFailed = pStage;
+			return false;
+		}
+		return Next::onIterationEnd(stages, chain, iteration, pFailed);
+	}
+
+	// Feedback travels from the last stage to the first one
+	static bool processFeedback(Stages &stages, const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback, MIPComponent *&pFailed)
+	{
+		if (!Next::processFeedback(stages, chain, feedbackChainID, feedback, pFailed))
+			return false;
+
+		Stage *pStage = std::get<I>(stages);
+
+		if (!pStage->Stage::processFeedback(chain, feedbackChainID, feedback))
+		{
+			pFailed = pStage;
+			return false;
+		}
+		return true;
+	}
+
+	// Passes the messages of the previous stage to this one, and continues with the
+	// next stage; only used for I >= 1. The first pTransferred[I-1] messages of the
+	// previous stage were already passed on in this iteration and are skipped.
+	static bool transfer(Stages &stages, const MIPComponentChain &chain, int64_t iteration, size_t *pTransferred, MIPComponent *&pFailed)
+	{
+		typedef typename std::tuple_element<I-1, std::tuple<Components...> >::type Prev;
+
+		Prev *pPrev = std::get<I-1>(stages);
+		Stage *pStage = std::get<I>(stages);
+
+		if (pPrev->Prev::supportsPullBatch())
+		{
+			MIPMessage * const *pMessages = 0;
+			size_t numMessages = 0;
+
+			if (!pPrev->Prev::pullBatch(chain, iteration, pMessages, numMessages))
+			{
+				pFailed = pPrev;
+				return false;
+			}
+			if (numMessages > pTransferred[I-1] && 
+			    !pStage->Stage::pushBatch(chain, iteration, pMessages + pTransferred[I-1], numMessages - pTransferred[I-1]))
+			{
+				pFailed = pStage;
+				return false;
+			}
+			pTransferred[I-1] = numMessages;
+		}
+		else
+		{
+			MIPMessage *pMsg = 0;
+			size_t count = 0;
+
+			do
+			{
+				if (!pPrev->Prev::pull(chain, iteration, &pMsg))
+				{
+					pFailed = pPrev;
+					return false;
+				}
+				if (pMsg && count++ >= pTransferred[I-1] && !pStage->Stage::push(chain, iteration, pMsg))
+				{
+					pFailed = pStage;
+					return false;
+				}
+			} while (pMsg);
+			pTransferred[I-1] = count;
+		}
+		return Next::transfer(stages, chain, iteration, pTransferred, pFailed);
+	}
+};
+
+/** \internal */
+template<size_t I, class... Components>
+struct MIPStaticPipelineStages<I, true, Components...>
+{
+	typedef std::tuple<Components *...> Stages;
+
+	static bool onIterationStart(Stages &, const MIPComponentChain &, int64_t, MIPComponent *&)			{ return true; }
+	static bool onIterationEnd(Stages &, const MIPComponentChain &, int64_t, MIPComponent *&)			{ return true; }
+	static bool processFeedback(Stages &, const MIPComponentChain &, int64_t, MIPFeedback *, MIPComponent *&)	{ return true; }
+	static bool transfer(Stages &, const MIPComponentChain &, int64_t, size_t *, MIPComponent *&)			{ return true; }
+};
+
+/** A fixed sequence of components which acts as a single component.
+ *  For a topology which never changes, like the send path
+ *  \c MIPSampleEncoder, \c MIPOpusEncoder, \c MIPRTPOpusEncoder, \c MIPRTPComponent, the
+ *  types of the components are known at compile time. This template composes such
+ *  components into one component: messages pushed into the pipeline are passed to the
+ *  first stage, and the messages of each stage are passed to the next one by direct
+ *  calls, without virtual dispatch, message type masks or connection lists. The 
+ *  messages of the last stage can be pulled from the pipeline, which can be used in
+ *  a MIPComponentChain like any other component. For example:
+ *
+ * \code
+ * 	MIPStaticPipeline<MIPSampleEncoder, MIPOpusEncoder, MIPRTPOpusEncoder, MIPRTPComponent> 
+ * 		sendPath("Send path", &sampEnc, &opusEnc, &rtpEnc, &rtpComp);
+ *
+ * 	chain.addConnection(&mixer, &sendPath);
+ * \endcode
+ *
+ *  The stages are not owned by the pipeline and should be initialized as usual. The
+ *  template arguments must be the actual types of the components, since the functions
+ *  of exactly those types are called. Because the chain only locks the pipeline itself,
+ *  the stages should not be used in any chain directly.
+ *
+ *  The messages are passed between the stages right before the first message is pulled
+ *  from the pipeline in an iteration, or in MIPComponent::onIterationEnd if no messages
+ *  are pulled from it, so that all messages pushed into the pipeline in an iteration are 
+ *  processed together, as they would be in a chain. If messages are pushed into the 
+ *  pipeline after it has been pulled from, they are passed on the next time the pipeline 
+ *  is pulled from, or at the end of the iteration. Only the messages which a stage has
+ *  not returned before in that iteration are then passed to the next stage, so a stage
+ *  must return its messages in the order in which they were produced. Iteration callbacks
+ *  are forwarded to all stages, feedback is processed by the stages from the last one 
+ *  to the first.
+ */
+template<class... Components>
+class MIPStaticPipeline : public MIPComponent
+{
+	static_assert(sizeof...(Components) > 0, "A static pipeline needs at least one stage");
+
+	typedef std::tuple<Components *...> Stages;
+	typedef typename std::tuple_element<0, std::tuple<Components...> >::type First;
+	typedef typename std::tuple_element<sizeof...(Components)-1, std::tuple<Components...> >::type Last;
+	typedef MIPStaticPipelineStages<0, false, Components...> AllStages;
+	typedef MIPStaticPipelineStages<1, (sizeof...(Components) == 1), Components...> LaterStages;
+public:
+	/** Creates a pipeline with name \c name, which passes messages through the specified components. */
+	MIPStaticPipeline(const std::string &name, Components *... pComponents) : MIPComponent(name), m_stages(pComponents...)
+													{ m_transferIteration = -1; m_newInput = false; }
+	~MIPStaticPipeline()										{ }
+
+	/** Returns the number of stages in the pipeline. */
+	static size_t getNumberOfStages()								{ return sizeof...(Components); }
+
+	/** Returns the component used as stage \c I. */
+	template<size_t I>
+	typename std::tuple_element<I, std::tuple<Components...> >::type *getStage() const		{ return std::get<I>(m_stages); }
+
+	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+	{
+		First *pFirst = std::get<0>(m_stages);
+
+		m_newInput = true;
+		if (!pFirst->First::push(chain, iteration, pMsg))
+		{
+			setStageError(pFirst);
+			return false;
+		}
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &chain, int64_t iteration, MIPMessage **pMsg)
+	{
+		Last *pLast = std::get<sizeof...(Components)-1>(m_stages);
+
+		if (!transfer(chain, iteration))
+			return false;
+		if (!pLast->Last::pull(chain, iteration, pMsg))
+		{
+			setStageError(pLast);
+			return false;
+		}
+		return true;
+	}
+
+	bool supportsPullBatch() const									{ return std::get<sizeof...(Components)-1>(m_stages)->Last::supportsPullBatch(); }
+
+	bool pullBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages)
+	{
+		Last *pLast = std::get<sizeof...(Components)-1>(m_stages);
+
+		if (!transfer(chain, iteration))
+			return false;
+		if (!pLast->Last::pullBatch(chain, iteration, pMessages, numMessages))
+		{
+			setStageError(pLast);
+			return false;
+		}
+		return true;
+	}
+
+	bool pushBatch(const MIPComponentChain &chain, int64_t iteration, MIPMessage * const *pMessages, size_t numMessages)
+	{
+		First *pFirst = std::get<0>(m_stages);
+
+		m_newInput = true;
+		if (!pFirst->First::pushBatch(chain, iteration, pMessages, numMessages))
+		{
+			setStageError(pFirst);
+			return false;
+		}
+		return true;
+	}
+
+	bool processFeedback(const MIPComponentChain &chain, int64_t feedbackChainID, MIPFeedback *feedback)
+	{
+		MIPComponent *pFailed = 0;
+
+		if (!AllStages::processFeedback(m_stages, chain, feedbackChainID, feedback, pFailed))
+		{
+			setStageError(pFailed);
+			return false;
+		}
+		return true;
+	}
+
+	bool onIterationStart(const MIPComponentChain &chain, int64_t iteration)
+	{
+		MIPComponent *pFailed = 0;
+
+		if (!AllStages::onIterationStart(m_stages, chain, iteration, pFailed))
+		{
+			setStageError(pFailed);
+			return false;
+		}
+		return true;
+	}
+
+	bool onIterationEnd(const MIPComponentChain &chain, int64_t iteration)
+	{
+		MIPComponent *pFailed = 0;
+
+		// A pipeline which ends in a sink is never pulled from
+		if (!transfer(chain, iteration))
+			return false;
+		if (!AllStages::onIterationEnd(m_stages, chain, iteration, pFailed))
+		{
+			setStageError(pFailed);
+			return false;
+		}
+		return true;
+	}
+
+	bool getIterationStartTime(const MIPComponentChain &chain, int64_t iteration, MIPTime &startTime)
+	{
+		First *pFirst = std::get<0>(m_stages);
+
+		if (!pFirst->First::getIterationStartTime(chain, iteration, startTime))
+		{
+			setStageError(pFirst);
+			return false;
+		}
+		return true;
+	}
+
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const			{ return std::get<0>(m_stages)->First::getInputMessageFormats(formats); }
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const			{ return std::get<sizeof...(Components)-1>(m_stages)->Last::getOutputMessageFormats(formats); }
+private:
+	bool transfer(const MIPComponentChain &chain, int64_t iteration)
+	{
+		// In the same iteration, only new input needs to be passed on
+		if (m_transferIteration != iteration)
+		{
+			m_transferIteration = iteration;
+			for (size_t i = 0 ; i < sizeof...(Components) ; i++)
+				m_transferred[i] = 0;
+		}
+		else if (!m_newInput)
+			return true;
+		m_newInput = false;
+
+		MIPComponent *pFailed = 0;
+
+		if (!LaterStages::transfer(m_stages, chain, iteration, m_transferred, pFailed))
+		{
+			setStageError(pFailed);
+			return false;
+		}
+		return true;
+	}
+
+	void setStageError(const MIPComponent *pStage)							{ setErrorString(pStage->getComponentName() + ": " + pStage->getErrorString()); }
+
+	Stages m_stages;
+	int64_t m_transferIteration;
+	size_t m_transferred[sizeof...(Components)];
+	bool m_newInput;
+};
+
+#endif // MIPSTATICPIPELINE_H
+
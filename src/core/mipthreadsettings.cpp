@@ -0,0 +1,190 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipthreadsettings.h"
+#if (defined(WIN32) || defined(_WIN32_WCE))
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <sched.h>
+	#include <sys/mman.h>
+	#include <string.h>
+	#include <errno.h>
+#endif // WIN32 || _WIN32_WCE
+
+#include "mipdebug.h"
+
+#define MIPTHREADSETTINGS_ERRSTR_CANTSETSCHEDULING		"Can't set scheduling policy: "
+#define MIPTHREADSETTINGS_ERRSTR_BADCPU				"Invalid processor number in affinity list"
+#define MIPTHREADSETTINGS_ERRSTR_CANTSETAFFINITY		"Can't set processor affinity: "
+#define MIPTHREADSETTINGS_ERRSTR_NOAFFINITY			"Setting the processor affinity is not supported on this platform"
+#define MIPTHREADSETTINGS_ERRSTR_CANTLOCKMEMORY			"Can't lock memory: "
+#define MIPTHREADSETTINGS_ERRSTR_NOLOCKMEMORY			"Locking memory is not supported on this platform"
+
+#define MIPTHREADSETTINGS_STACKCHUNK				4096
+
+static void touchStack(size_t numBytes)
+{
+	volatile uint8_t buffer[MIPTHREADSETTINGS_STACKCHUNK];
+
+	for (size_t i = 0 ; i < MIPTHREADSETTINGS_STACKCHUNK ; i += 256)
+		buffer[i] = 0;
+
+	if (numBytes > MIPTHREADSETTINGS_STACKCHUNK)
+		touchStack(numBytes - MIPTHREADSETTINGS_STACKCHUNK);
+
+	// Using the buffer after the call makes sure that each call gets its own stack frame
+	buffer[0] = buffer[256];
+}
+
+#if (defined(WIN32) || defined(_WIN32_WCE))
+
+void MIPThreadSettings::applyToCurrentThread(MIPThreadSettingsReport &report) const
+{
+	report.clear();
+	report.m_applied = true;
+
+	if (m_lockMemory)
+		report.addError(MIPTHREADSETTINGS_ERRSTR_NOLOCKMEMORY);
+
+	if (m_policy != Default)
+	{
+		// There's no direct counterpart of the real-time policies, we'll use the
+		// highest thread priority instead
+		if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+			report.m_schedulingSet = true;
+		else
+			report.addError(std::string(MIPTHREADSETTINGS_ERRSTR_CANTSETSCHEDULING) + "SetThreadPriority failed");
+	}
+
+	if (!m_cpus.empty())
+	{
+#ifndef _WIN32_WCE
+		DWORD_PTR mask = 0;
+		bool badCPU = false;
+
+		for (size_t i = 0 ; i < m_cpus.size() ; i++)
+		{
+			if (m_cpus[i] < 0 || m_cpus[i] >= (int)(sizeof(DWORD_PTR)*8))
+				badCPU = true;
+			else
+				mask |= ((DWORD_PTR)1) << m_cpus[i];
+		}
+
+		if (badCPU)
+			report.addError(MIPTHREADSETTINGS_ERRSTR_BADCPU);
+		else if (SetThreadAffinityMask(GetCurrentThread(), mask) != 0)
+			report.m_affinitySet = true;
+		else
+			report.addError(std::string(MIPTHREADSETTINGS_ERRSTR_CANTSETAFFINITY) + "SetThreadAffinityMask failed");
+#else
+		report.addError(MIPTHREADSETTINGS_ERRSTR_NOAFFINITY);
+#endif // !_WIN32_WCE
+	}
+
+	if (m_prefaultStackSize > 0)
+	{
+		touchStack(m_prefaultStackSize);
+		report.m_stackPrefaulted = true;
+	}
+}
+
+#else
+
+void MIPThreadSettings::applyToCurrentThread(MIPThreadSettingsReport &report) const
+{
+	report.clear();
+	report.m_applied = true;
+
+	// Lock the memory first, so that the stack pages we touch below stay resident
+
+	if (m_lockMemory)
+	{
+		if (mlockall(MCL_CURRENT|MCL_FUTURE) == 0)
+			report.m_memoryLocked = true;
+		else
+			report.addError(std::string(MIPTHREADSETTINGS_ERRSTR_CANTLOCKMEMORY) + strerror(errno));
+	}
+
+	if (m_policy != Default)
+	{
+		int policy = (m_policy == FIFO)?SCHED_FIFO:SCHED_RR;
+		struct sched_param param;
+		int status;
+
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = m_priority;
+
+		if ((status = pthread_setschedparam(pthread_self(), policy, &param)) != 0)
+			report.addError(std::string(MIPTHREADSETTINGS_ERRSTR_CANTSETSCHEDULING) + strerror(status));
+		else
+		{
+			int newPolicy = 0;
+
+			// Verify that the request is really in effect
+			if (pthread_getschedparam(pthread_self(), &newPolicy, &param) == 0 && newPolicy == policy && param.sched_priority == m_priority)
+				report.m_schedulingSet = true;
+			else
+				report.addError(std::string(MIPTHREADSETTINGS_ERRSTR_CANTSETSCHEDULING) + "policy was not applied");
+		}
+	}
+
+	if (!m_cpus.empty())
+	{
+#ifdef __linux__
+		cpu_set_t cpuSet;
+		bool badCPU = false;
+
+		CPU_ZERO(&cpuSet);
+		for (size_t i = 0 ; i < m_cpus.size() ; i++)
+		{
+			if (m_cpus[i] < 0 || m_cpus[i] >= CPU_SETSIZE)
+				badCPU = true;
+			else
+				CPU_SET(m_cpus[i], &cpuSet);
+		}
+
+		// sched_setaffinity with pid zero applies to the calling thread, and unlike
+		// pthread_setaffinity_np it is also available on Android
+		if (badCPU)
+			report.addError(MIPTHREADSETTINGS_ERRSTR_BADCPU);
+		else if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+			report.m_affinitySet = true;
+		else
+			report.addError(std::string(MIPTHREADSETTINGS_ERRSTR_CANTSETAFFINITY) + strerror(errno));
+#else
+		report.addError(MIPTHREADSETTINGS_ERRSTR_NOAFFINITY);
+#endif // __linux__
+	}
+
+	if (m_prefaultStackSize > 0)
+	{
+		touchStack(m_prefaultStackSize);
+		report.m_stackPrefaulted = true;
+	}
+}
+
+#endif // WIN32 || _WIN32_WCE
+
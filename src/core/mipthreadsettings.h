@@ -0,0 +1,152 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipthreadsettings.h
+ */
+
+#ifndef MIPTHREADSETTINGS_H
+
+#define MIPTHREADSETTINGS_H
+
+#include "mipconfig.h"
+#include "miptypes.h"
+#include <string>
+#include <vector>
+
+class MIPThreadSettingsReport;
+
+/** Describes how a thread which processes media should be run.
+ *  An instance of this class can be passed to MIPComponentChain::setThreadSettings to 
+ *  request real-time scheduling for the background thread of a chain, to restrict the
+ *  processors on which it may run, to lock the memory of the process so that it can't
+ *  be swapped out, and to touch a part of the thread's stack in advance so that no page
+ *  faults occur there later on. By default, none of these are requested. Which of the
+ *  requests could actually be honoured is described by a MIPThreadSettingsReport
+ *  instance; typically, real-time scheduling and memory locking require special
+ *  privileges.
+ */
+class EMIPLIB_IMPORTEXPORT MIPThreadSettings
+{
+public:
+	/** The scheduling policy of the thread. */
+	enum SchedulingPolicy 
+	{ 
+		/** The scheduling of the thread is not changed. */
+		Default,
+		/** First-in, first-out real-time scheduling (SCHED_FIFO). */
+		FIFO,
+		/** Round-robin real-time scheduling (SCHED_RR). */
+		RoundRobin 
+	};
+
+	MIPThreadSettings()										{ m_policy = Default; m_priority = 0; m_lockMemory = false; m_prefaultStackSize = 0; }
+	~MIPThreadSettings()										{ }
+
+	/** Requests the scheduling policy \c policy with the specified priority; for the
+	 *  real-time policies this should lie in the range allowed by the operating system,
+	 *  typically 1 to 99. */
+	void setSchedulingPolicy(SchedulingPolicy policy, int priority = 0)				{ m_policy = policy; m_priority = priority; }
+
+	/** Returns the requested scheduling policy. */
+	SchedulingPolicy getSchedulingPolicy() const							{ return m_policy; }
+
+	/** Returns the requested priority. */
+	int getPriority() const										{ return m_priority; }
+
+	/** Restricts the thread to the processors which are listed in \c cpus, numbered
+	 *  starting from zero; an empty list means that the affinity is left unchanged. */
+	void setCPUAffinity(const std::vector<int> &cpus)						{ m_cpus = cpus; }
+
+	/** Returns the processors to which the thread should be restricted. */
+	const std::vector<int> &getCPUAffinity() const							{ return m_cpus; }
+
+	/** If set, all current and future memory pages of the process are locked in memory 
+	 *  when the thread starts. Note that this affects the entire process. */
+	void setLockMemory(bool f)									{ m_lockMemory = f; }
+
+	/** Returns true if the memory of the process should be locked. */
+	bool getLockMemory() const									{ return m_lockMemory; }
+
+	/** Sets the number of bytes of the stack which should be touched when the thread starts,
+	 *  zero meaning that this should not be done. */
+	void setPrefaultStackSize(size_t numBytes)							{ m_prefaultStackSize = numBytes; }
+
+	/** Returns the number of bytes of the stack which should be touched in advance. */
+	size_t getPrefaultStackSize() const								{ return m_prefaultStackSize; }
+
+	/** Returns true if nothing needs to be changed for a thread. */
+	bool isDefault() const										{ return m_policy == Default && m_cpus.empty() && !m_lockMemory && m_prefaultStackSize == 0; }
+
+	/** Applies these settings to the calling thread, storing the outcome in \c report. */
+	void applyToCurrentThread(MIPThreadSettingsReport &report) const;
+private:
+	SchedulingPolicy m_policy;
+	int m_priority;
+	std::vector<int> m_cpus;
+	bool m_lockMemory;
+	size_t m_prefaultStackSize;
+};
+
+/** Describes which of the requests in a MIPThreadSettings instance succeeded. */
+class EMIPLIB_IMPORTEXPORT MIPThreadSettingsReport
+{
+public:
+	MIPThreadSettingsReport()									{ clear(); }
+	~MIPThreadSettingsReport()									{ }
+
+	/** Returns true if the settings were applied to a thread at all. */
+	bool isApplied() const										{ return m_applied; }
+
+	/** Returns true if the requested scheduling policy and priority are in effect. */
+	bool isSchedulingSet() const									{ return m_schedulingSet; }
+
+	/** Returns true if the thread was restricted to the requested processors. */
+	bool isAffinitySet() const									{ return m_affinitySet; }
+
+	/** Returns true if the memory of the process was locked. */
+	bool isMemoryLocked() const									{ return m_memoryLocked; }
+
+	/** Returns true if the requested part of the stack was touched. */
+	bool isStackPrefaulted() const									{ return m_stackPrefaulted; }
+
+	/** Returns true if the settings were applied and every request succeeded. */
+	bool isSuccessful() const									{ return m_applied && m_errorString.empty(); }
+
+	/** Describes the requests which failed, or why the settings were not applied. */
+	const std::string &getErrorString() const							{ return m_errorString; }
+private:
+	void clear()											{ m_applied = false; m_schedulingSet = false; m_affinitySet = false; m_memoryLocked = false; m_stackPrefaulted = false; m_errorString = std::string(); }
+	void addError(const std::string &err)								{ if (!m_errorString.empty()) m_errorString += "; "; m_errorString += err; }
+
+	bool m_applied;
+	bool m_schedulingSet, m_affinitySet, m_memoryLocked, m_stackPrefaulted;
+	std::string m_errorString;
+
+	friend class MIPThreadSettings;
+	friend class MIPComponentChain;
+};
+
+#endif // MIPTHREADSETTINGS_H
+
@@ -27,6 +27,12 @@
 #include "mipcompat.h"
 #include <inttypes.h>
 #include <string>
+#if !defined(WIN32) && !defined(_WIN32_WCE)
+	#include <errno.h>
+	#if defined(TIMER_ABSTIME) && defined(CLOCK_MONOTONIC)
+		#define MIPTIME_HAVE_ABSOLUTE_SLEEP
+	#endif // TIMER_ABSTIME && CLOCK_MONOTONIC
+#endif // !WIN32 && !_WIN32_WCE
 
 std::string MIPTime::getString() const
 {
@@ -38,3 +44,84 @@ std::string MIPTime::getString() const
 }
 
 
+
+#ifdef MIPTIME_HAVE_ABSOLUTE_SLEEP
+
+static inline void addToTimeSpec(struct timespec &ts, int64_t nanoSeconds)
+{
+	ts.tv_sec += (time_t)(nanoSeconds/MIPTIME_NANO);
+	ts.tv_nsec += (long)(nanoSeconds%MIPTIME_NANO);
+	if (ts.tv_nsec >= MIPTIME_NANO)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= MIPTIME_NANO;
+	}
+}
+
+static inline bool isBefore(const struct timespec &a, const struct timespec &b)
+{
+	if (a.tv_sec != b.tv_sec)
+		return a.tv_sec < b.tv_sec;
+	return a.tv_nsec < b.tv_nsec;
+}
+
+void MIPTime::waitUntil(const MIPTime &deadline, const MIPTime &spinTime)
+{
+	int64_t remaining = deadline.m_nanoSeconds - getCurrentTime().m_nanoSeconds;
+	int64_t spin = spinTime.m_nanoSeconds;
+
+	if (remaining <= 0)
+		return;
+	if (spin < 0)
+		spin = 0;
+
+	// Translate the deadline to the monotonic clock once, from then on everything
+	// is absolute so that an interrupted sleep doesn't cause any drift
+
+	struct timespec endTime, wakeTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	wakeTime = endTime;
+	addToTimeSpec(endTime, remaining);
+
+	if (remaining > spin)
+	{
+		addToTimeSpec(wakeTime, remaining - spin);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, 0) == EINTR)
+			;
+	}
+
+	if (spin > 0)
+	{
+		struct timespec now;
+
+		do
+		{
+			clock_gettime(CLOCK_MONOTONIC, &now);
+		} while (isBefore(now, endTime));
+	}
+}
+
+#else
+
+void MIPTime::waitUntil(const MIPTime &deadline, const MIPTime &spinTime)
+{
+	int64_t remaining = deadline.m_nanoSeconds - getCurrentTime().m_nanoSeconds;
+	int64_t spin = spinTime.m_nanoSeconds;
+
+	if (remaining <= 0)
+		return;
+	if (spin < 0)
+		spin = 0;
+
+	if (remaining > spin)
+		wait(MIPTime::fromNanoSeconds(remaining - spin));
+
+	if (spin > 0)
+	{
+		while (getCurrentTime().m_nanoSeconds < deadline.m_nanoSeconds)
+			;
+	}
+}
+
+#endif // MIPTIME_HAVE_ABSOLUTE_SLEEP
@@ -39,8 +39,12 @@
 // We're going to use some things from RTPTime
 #include <jrtplib3/rtptimeutilities.h>
 
+#define MIPTIME_NANO									((int64_t)1000000000)
+
 /** This class is used for timing purposes.
- *  This class provides some time handling functions.
+ *  This class provides some time handling functions. Internally, the time is stored as
+ *  a 64-bit integer number of nanoseconds, so that adding, subtracting and comparing
+ *  time values is exact.
  */
 class EMIPLIB_IMPORTEXPORT MIPTime
 {
@@ -50,21 +54,35 @@ public:
 
 	/** Pauses the current thread for the time contained in \c delay. */
 	static void wait(const MIPTime &delay);
+
+	/** Pauses the current thread until the time returned by MIPTime::getCurrentTime reaches \c deadline.
+	 *  Where available, the thread sleeps until an absolute deadline on the monotonic clock, so
+	 *  that interruptions or repeated calls do not accumulate errors. If \c spinTime is positive,
+	 *  the thread only sleeps until that amount of time before the deadline, and then actively 
+	 *  waits for the remaining time, which is more accurate at the cost of processor time.
+	 */
+	static void waitUntil(const MIPTime &deadline, const MIPTime &spinTime = MIPTime(0));
+
+	/** Creates a time object containing the specified number of nanoseconds. */
+	static MIPTime fromNanoSeconds(int64_t nanoSeconds)						{ MIPTime t; t.m_nanoSeconds = nanoSeconds; return t; }
 	
-	/** Creates a time object containing the time corresponding to \c t. */
-	MIPTime(real_t t = 0.0)								{ m_time = t; }
+	/** Creates a time object containing the time corresponding to \c t, rounded to the nearest nanosecond. */
+	MIPTime(real_t t = 0.0)								{ m_nanoSeconds = toNanoSeconds(t); }
 
 	/** Creates a time object containing the time corresponding to the two parameters. */
-	MIPTime(int64_t seconds, int64_t microSeconds)					{ m_time = (((real_t)seconds)+(((real_t)microSeconds)/1000000.0)); }
+	MIPTime(int64_t seconds, int64_t microSeconds)					{ m_nanoSeconds = seconds*MIPTIME_NANO + microSeconds*1000; }
 
 	/** Returns the number of seconds contained in the time object. */
-	int64_t getSeconds() const							{ return (int64_t)m_time; }
+	int64_t getSeconds() const							{ return m_nanoSeconds/MIPTIME_NANO; }
 
 	/** Returns the number of microseconds contained in the time object. */
 	int64_t getMicroSeconds() const;
 
-	/** Returns a real value describing the time contained in this object. */
-	real_t getValue() const 							{ return m_time; }
+	/** Returns the total number of nanoseconds contained in the time object. */
+	int64_t getNanoSeconds() const							{ return m_nanoSeconds; }
+
+	/** Returns a real value describing the time contained in this object, in seconds. */
+	real_t getValue() const 							{ return ((real_t)m_nanoSeconds)/((real_t)MIPTIME_NANO); }
 
 	MIPTime &operator-=(const MIPTime &t);
 	MIPTime &operator+=(const MIPTime &t);
@@ -74,7 +92,9 @@ public:
 	bool operator>=(const MIPTime &t) const;
 	std::string getString() const;
 private:
-	real_t m_time;
+	static int64_t toNanoSeconds(real_t t)						{ real_t ns = t*((real_t)MIPTIME_NANO); return (int64_t)((ns < 0)?(ns-0.5):(ns+0.5)); }
+
+	int64_t m_nanoSeconds;
 };
 
 inline MIPTime MIPTime::getCurrentTime()
@@ -86,57 +106,55 @@ inline MIPTime MIPTime::getCurrentTime()
 
 inline void MIPTime::wait(const MIPTime &delay)
 {
-	if (delay.m_time < 0)
+	if (delay.m_nanoSeconds < 0)
 		return;
-	jrtplib::RTPTime::Wait(jrtplib::RTPTime(delay.m_time));
+	jrtplib::RTPTime::Wait(jrtplib::RTPTime((double)delay.getValue()));
 }
 
 inline int64_t MIPTime::getMicroSeconds() const
 {
-	real_t t = m_time;
+	int64_t t = m_nanoSeconds;
 	if (t < 0)
 		t = -t;
-	t -= (real_t)((int64_t)t);
-	t *= 1000000.0;
-	return (int64_t)t;
+	return (t%MIPTIME_NANO)/1000;
 }
 
 inline MIPTime &MIPTime::operator-=(const MIPTime &t)
 { 
-	m_time -= t.m_time;
+	m_nanoSeconds -= t.m_nanoSeconds;
 	return *this;
 }
 
 inline MIPTime &MIPTime::operator+=(const MIPTime &t)
 { 
-	m_time += t.m_time;
+	m_nanoSeconds += t.m_nanoSeconds;
 	return *this;
 }
 
 inline bool MIPTime::operator<(const MIPTime &t) const
 {
-	if (m_time < t.m_time)
+	if (m_nanoSeconds < t.m_nanoSeconds)
 		return true;
 	return false;
 }
 
 inline bool MIPTime::operator>(const MIPTime &t) const
 {
-	if (m_time > t.m_time)
+	if (m_nanoSeconds > t.m_nanoSeconds)
 		return true;
 	return false;
 }
 
 inline bool MIPTime::operator<=(const MIPTime &t) const
 {
-	if (m_time <= t.m_time)
+	if (m_nanoSeconds <= t.m_nanoSeconds)
 		return true;
 	return false;
 }
 
 inline bool MIPTime::operator>=(const MIPTime &t) const
 {
-	if (m_time >= t.m_time)
+	if (m_nanoSeconds >= t.m_nanoSeconds)
 		return true;
 	return false;
 }
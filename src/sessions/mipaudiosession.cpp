@@ -944,6 +944,13 @@ bool MIPAudioSession::init(const MIPAudioSessionParams *pParams, MIPRTPSynchroni
 	addLink(pActiveChain, &pPrevComponent, pSampEnc2, true);
 	addLink(pActiveChain, &pPrevComponent, pOutput, true);
 
+	if (m_pInputChain)
+		m_pInputChain->setThreadSettings(pParams2->getChainThreadSettings());
+	if (m_pOutputChain)
+		m_pOutputChain->setThreadSettings(pParams2->getChainThreadSettings());
+	if (m_pIOChain)
+		m_pIOChain->setThreadSettings(pParams2->getChainThreadSettings());
+
 	// Flag is needed in startChain
 	m_singleThread = singleThread;
 
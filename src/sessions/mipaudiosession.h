@@ -38,6 +38,7 @@
 #include "mipcomponentchain.h"
 #include "miperrorbase.h"
 #include "miptime.h"
+#include "mipthreadsettings.h"
 #include <jrtplib3/rtptransmitter.h>
 #include <string>
 #include <list>
@@ -135,6 +136,9 @@ public:
 	/** Returns \c true if the audio threads will receive high priority (only used on Win32/WinCE; default: false). */
 	bool getUseHighPriority() const							{ return m_highPriority; }
 
+	/** Returns the settings for the background threads of the session's component chains (default: unchanged). */
+	const MIPThreadSettings &getChainThreadSettings() const				{ return m_chainThreadSettings; }
+
 	/** Returns the RTP portbase (default: 5000). */
 	uint16_t getPortbase() const							{ return m_portbase; }
 
@@ -189,6 +193,10 @@ public:
 	/** Sets a flag indicating if high priority audio threads should be used (only used on Win32/WinCE). */
 	void setUseHighPriority(bool f)							{ m_highPriority = f; }
 
+	/** Sets how the background threads of the session's component chains should be run, e.g. using
+	 *  real-time scheduling or restricted to certain processors (see MIPComponentChain::setThreadSettings). */
+	void setChainThreadSettings(const MIPThreadSettings &settings)			{ m_chainThreadSettings = settings; }
+
 	/** Sets the RTP portbase. */
 	void setPortbase(uint16_t p)							{ m_portbase = p; }
 	
@@ -235,6 +243,7 @@ private:
 	unsigned int m_inputDevID, m_outputDevID;
 	std::string m_inputDevName, m_outputDevName;
 	bool m_highPriority;
+	MIPThreadSettings m_chainThreadSettings;
 	uint16_t m_portbase;
 	bool m_acceptOwnPackets;
 	SpeexBandWidth m_speexMode;
@@ -0,0 +1,432 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipmixkernels.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	#define MIPMIXKERNELS_SSE2
+	#define MIPMIXKERNELS_AVX2
+	#define MIPMIXKERNELS_TARGET_SSE2 __attribute__((target("sse2")))
+	#define MIPMIXKERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+	#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define MIPMIXKERNELS_SSE2
+	#define MIPMIXKERNELS_TARGET_SSE2
+	#include <emmintrin.h>
+#endif
+
+#include "mipdebug.h"
+
+#define MIPMIXKERNELS_SOFTCLIP_RANGE		(32767-MIPMIXKERNELS_SOFTCLIP_THRESHOLD)
+
+static inline int16_t softClipSample(int32_t x)
+{
+	// Above the threshold, the excess d is mapped to d*R/(R+d), which has slope one
+	// at the threshold and stays below R
+	if (x > MIPMIXKERNELS_SOFTCLIP_THRESHOLD)
+	{
+		int64_t d = (int64_t)x - MIPMIXKERNELS_SOFTCLIP_THRESHOLD;
+		return (int16_t)(MIPMIXKERNELS_SOFTCLIP_THRESHOLD + (d*MIPMIXKERNELS_SOFTCLIP_RANGE)/(MIPMIXKERNELS_SOFTCLIP_RANGE+d));
+	}
+	if (x < -MIPMIXKERNELS_SOFTCLIP_THRESHOLD)
+	{
+		int64_t d = -(int64_t)x - MIPMIXKERNELS_SOFTCLIP_THRESHOLD;
+		return (int16_t)(-MIPMIXKERNELS_SOFTCLIP_THRESHOLD - (d*MIPMIXKERNELS_SOFTCLIP_RANGE)/(MIPMIXKERNELS_SOFTCLIP_RANGE+d));
+	}
+	return (int16_t)x;
+}
+
+static void addFloatScalar(float *pDest, const float *pSrc, size_t num)
+{
+	for (size_t i = 0 ; i < num ; i++)
+		pDest[i] += pSrc[i];
+}
+
+static void addS16SaturatedScalar(int16_t *pDest, const int16_t *pSrc, size_t num)
+{
+	for (size_t i = 0 ; i < num ; i++)
+	{
+		int32_t sum = (int32_t)pDest[i] + (int32_t)pSrc[i];
+
+		if (sum > 32767)
+			sum = 32767;
+		else if (sum < -32768)
+			sum = -32768;
+		pDest[i] = (int16_t)sum;
+	}
+}
+
+static void addS16To32Scalar(int32_t *pDest, const int16_t *pSrc, size_t num)
+{
+	for (size_t i = 0 ; i < num ; i++)
+		pDest[i] += pSrc[i];
+}
+
+static void softClip32To16Scalar(int16_t *pDest, const int32_t *pSrc, size_t num)
+{
+	for (size_t i = 0 ; i < num ; i++)
+		pDest[i] = softClipSample(pSrc[i]);
+}
+
+static void saturate32To16Scalar(int16_t *pDest, const int32_t *pSrc, size_t num)
+{
+	for (size_t i = 0 ; i < num ; i++)
+	{
+		int32_t x = pSrc[i];
+
+		if (x > 32767)
+			x = 32767;
+		else if (x < -32768)
+			x = -32768;
+		pDest[i] = (int16_t)x;
+	}
+}
+
+static void subtractFloatScalar(float *pDest, const float *pA, const float *pB, size_t num)
+{
+	for (size_t i = 0 ; i < num ; i++)
+		pDest[i] = pA[i] - pB[i];
+}
+
+static void subtract32Scalar(int32_t *pDest, const int32_t *pA, const int32_t *pB, size_t num)
+{
+	for (size_t i = 0 ; i < num ; i++)
+		pDest[i] = pA[i] - pB[i];
+}
+
+#ifdef MIPMIXKERNELS_SSE2
+
+MIPMIXKERNELS_TARGET_SSE2 static void addFloatSSE2(float *pDest, const float *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+4 <= num ; i += 4)
+		_mm_storeu_ps(pDest+i, _mm_add_ps(_mm_loadu_ps(pDest+i), _mm_loadu_ps(pSrc+i)));
+	addFloatScalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_SSE2 static void addS16SaturatedSSE2(int16_t *pDest, const int16_t *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)(pDest+i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(pSrc+i));
+
+		_mm_storeu_si128((__m128i *)(pDest+i), _mm_adds_epi16(a, b));
+	}
+	addS16SaturatedScalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_SSE2 static void addS16To32SSE2(int32_t *pDest, const int16_t *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(pSrc+i));
+		// Sign extension: put each sample in the upper half and shift it back
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		__m128i *pD = (__m128i *)(pDest+i);
+
+		_mm_storeu_si128(pD, _mm_add_epi32(_mm_loadu_si128(pD), lo));
+		_mm_storeu_si128(pD+1, _mm_add_epi32(_mm_loadu_si128(pD+1), hi));
+	}
+	addS16To32Scalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_SSE2 static void softClip32To16SSE2(int16_t *pDest, const int32_t *pSrc, size_t num)
+{
+	const __m128i upper = _mm_set1_epi32(MIPMIXKERNELS_SOFTCLIP_THRESHOLD);
+	const __m128i lower = _mm_set1_epi32(-MIPMIXKERNELS_SOFTCLIP_THRESHOLD);
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)(pSrc+i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(pSrc+i+4));
+		__m128i outside = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(a, upper), _mm_cmplt_epi32(a, lower)),
+		                               _mm_or_si128(_mm_cmpgt_epi32(b, upper), _mm_cmplt_epi32(b, lower)));
+
+		// Loud samples are rare, those groups are handled one sample at a time
+		if (_mm_movemask_epi8(outside) == 0)
+			_mm_storeu_si128((__m128i *)(pDest+i), _mm_packs_epi32(a, b));
+		else
+			softClip32To16Scalar(pDest+i, pSrc+i, 8);
+	}
+	softClip32To16Scalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_SSE2 static void saturate32To16SSE2(int16_t *pDest, const int32_t *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)(pSrc+i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(pSrc+i+4));
+
+		_mm_storeu_si128((__m128i *)(pDest+i), _mm_packs_epi32(a, b));
+	}
+	saturate32To16Scalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_SSE2 static void subtractFloatSSE2(float *pDest, const float *pA, const float *pB, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+4 <= num ; i += 4)
+		_mm_storeu_ps(pDest+i, _mm_sub_ps(_mm_loadu_ps(pA+i), _mm_loadu_ps(pB+i)));
+	subtractFloatScalar(pDest+i, pA+i, pB+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_SSE2 static void subtract32SSE2(int32_t *pDest, const int32_t *pA, const int32_t *pB, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+4 <= num ; i += 4)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)(pA+i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(pB+i));
+
+		_mm_storeu_si128((__m128i *)(pDest+i), _mm_sub_epi32(a, b));
+	}
+	subtract32Scalar(pDest+i, pA+i, pB+i, num-i);
+}
+
+#endif // MIPMIXKERNELS_SSE2
+
+#ifdef MIPMIXKERNELS_AVX2
+
+MIPMIXKERNELS_TARGET_AVX2 static void addFloatAVX2(float *pDest, const float *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+		_mm256_storeu_ps(pDest+i, _mm256_add_ps(_mm256_loadu_ps(pDest+i), _mm256_loadu_ps(pSrc+i)));
+	addFloatScalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_AVX2 static void addS16SaturatedAVX2(int16_t *pDest, const int16_t *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+16 <= num ; i += 16)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i *)(pDest+i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(pSrc+i));
+
+		_mm256_storeu_si256((__m256i *)(pDest+i), _mm256_adds_epi16(a, b));
+	}
+	addS16SaturatedScalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_AVX2 static void addS16To32AVX2(int32_t *pDest, const int16_t *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+	{
+		__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(pSrc+i)));
+		__m256i *pD = (__m256i *)(pDest+i);
+
+		_mm256_storeu_si256(pD, _mm256_add_epi32(_mm256_loadu_si256(pD), v));
+	}
+	addS16To32Scalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_AVX2 static void softClip32To16AVX2(int16_t *pDest, const int32_t *pSrc, size_t num)
+{
+	const __m256i upper = _mm256_set1_epi32(MIPMIXKERNELS_SOFTCLIP_THRESHOLD);
+	const __m256i lower = _mm256_set1_epi32(-MIPMIXKERNELS_SOFTCLIP_THRESHOLD);
+	size_t i = 0;
+
+	for ( ; i+16 <= num ; i += 16)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i *)(pSrc+i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(pSrc+i+8));
+		__m256i outside = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(a, upper), _mm256_cmpgt_epi32(lower, a)),
+		                                  _mm256_or_si256(_mm256_cmpgt_epi32(b, upper), _mm256_cmpgt_epi32(lower, b)));
+
+		if (_mm256_movemask_epi8(outside) == 0)
+		{
+			// The pack works per 128 bit lane, the permutation restores the order
+			__m256i packed = _mm256_packs_epi32(a, b);
+
+			_mm256_storeu_si256((__m256i *)(pDest+i), _mm256_permute4x64_epi64(packed, 0xD8));
+		}
+		else
+			softClip32To16Scalar(pDest+i, pSrc+i, 16);
+	}
+	softClip32To16Scalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_AVX2 static void saturate32To16AVX2(int16_t *pDest, const int32_t *pSrc, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+16 <= num ; i += 16)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i *)(pSrc+i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(pSrc+i+8));
+		__m256i packed = _mm256_packs_epi32(a, b);
+
+		_mm256_storeu_si256((__m256i *)(pDest+i), _mm256_permute4x64_epi64(packed, 0xD8));
+	}
+	saturate32To16Scalar(pDest+i, pSrc+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_AVX2 static void subtractFloatAVX2(float *pDest, const float *pA, const float *pB, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+		_mm256_storeu_ps(pDest+i, _mm256_sub_ps(_mm256_loadu_ps(pA+i), _mm256_loadu_ps(pB+i)));
+	subtractFloatScalar(pDest+i, pA+i, pB+i, num-i);
+}
+
+MIPMIXKERNELS_TARGET_AVX2 static void subtract32AVX2(int32_t *pDest, const int32_t *pA, const int32_t *pB, size_t num)
+{
+	size_t i = 0;
+
+	for ( ; i+8 <= num ; i += 8)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i *)(pA+i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(pB+i));
+
+		_mm256_storeu_si256((__m256i *)(pDest+i), _mm256_sub_epi32(a, b));
+	}
+	subtract32Scalar(pDest+i, pA+i, pB+i, num-i);
+}
+
+#endif // MIPMIXKERNELS_AVX2
+
+MIPMixKernels::InstructionSet MIPMixKernels::getInstructionSet()
+{
+	return getKernels().m_set;
+}
+
+bool MIPMixKernels::isSupported(InstructionSet set)
+{
+#ifdef MIPMIXKERNELS_AVX2
+	// The default kernels can be selected from a static constructor, which may run
+	// before the processor features have been detected
+	__builtin_cpu_init();
+#endif // MIPMIXKERNELS_AVX2
+
+	switch (set)
+	{
+	case Scalar:
+		return true;
+	case SSE2:
+#if defined(MIPMIXKERNELS_SSE2) && defined(__GNUC__)
+		return __builtin_cpu_supports("sse2");
+#elif defined(MIPMIXKERNELS_SSE2)
+		return true;
+#else
+		return false;
+#endif // MIPMIXKERNELS_SSE2
+	case AVX2:
+#ifdef MIPMIXKERNELS_AVX2
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif // MIPMIXKERNELS_AVX2
+	}
+	return false;
+}
+
+bool MIPMixKernels::setInstructionSet(InstructionSet set)
+{
+	if (!isSupported(set))
+		return false;
+
+	selectKernels(getKernels(), set);
+	return true;
+}
+
+MIPMixKernels::Kernels &MIPMixKernels::getKernels()
+{
+	struct DefaultKernels
+	{
+		DefaultKernels()
+		{
+			if (isSupported(AVX2))
+				selectKernels(m_kernels, AVX2);
+			else if (isSupported(SSE2))
+				selectKernels(m_kernels, SSE2);
+			else
+				selectKernels(m_kernels, Scalar);
+		}
+
+		Kernels m_kernels;
+	};
+
+	static DefaultKernels defaultKernels;
+
+	return defaultKernels.m_kernels;
+}
+
+void MIPMixKernels::selectKernels(Kernels &kernels, InstructionSet set)
+{
+	kernels.m_addFloat = addFloatScalar;
+	kernels.m_addS16Saturated = addS16SaturatedScalar;
+	kernels.m_addS16To32 = addS16To32Scalar;
+	kernels.m_softClip32To16 = softClip32To16Scalar;
+	kernels.m_saturate32To16 = saturate32To16Scalar;
+	kernels.m_subtractFloat = subtractFloatScalar;
+	kernels.m_subtract32 = subtract32Scalar;
+	kernels.m_set = Scalar;
+
+#ifdef MIPMIXKERNELS_SSE2
+	if (set == SSE2)
+	{
+		kernels.m_addFloat = addFloatSSE2;
+		kernels.m_addS16Saturated = addS16SaturatedSSE2;
+		kernels.m_addS16To32 = addS16To32SSE2;
+		kernels.m_softClip32To16 = softClip32To16SSE2;
+		kernels.m_saturate32To16 = saturate32To16SSE2;
+		kernels.m_subtractFloat = subtractFloatSSE2;
+		kernels.m_subtract32 = subtract32SSE2;
+		kernels.m_set = SSE2;
+	}
+#endif // MIPMIXKERNELS_SSE2
+#ifdef MIPMIXKERNELS_AVX2
+	if (set == AVX2)
+	{
+		kernels.m_addFloat = addFloatAVX2;
+		kernels.m_addS16Saturated = addS16SaturatedAVX2;
+		kernels.m_addS16To32 = addS16To32AVX2;
+		kernels.m_softClip32To16 = softClip32To16AVX2;
+		kernels.m_saturate32To16 = saturate32To16AVX2;
+		kernels.m_subtractFloat = subtractFloatAVX2;
+		kernels.m_subtract32 = subtract32AVX2;
+		kernels.m_set = AVX2;
+	}
+#endif // MIPMIXKERNELS_AVX2
+}
+
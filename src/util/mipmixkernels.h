@@ -0,0 +1,114 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipmixkernels.h
+ */
+
+#ifndef MIPMIXKERNELS_H
+
+#define MIPMIXKERNELS_H
+
+#include "mipconfig.h"
+#include "miptypes.h"
+#include <stddef.h>
+
+/** Accumulated samples up to this magnitude are not changed by MIPMixKernels::softClip32To16. */
+#define MIPMIXKERNELS_SOFTCLIP_THRESHOLD								24576
+
+/** Sample mixing routines, using SIMD instructions if the processor supports them.
+ *  These functions add a block of samples to another one, which is what an audio mixer
+ *  spends most of its time on. On x86 processors, SSE2 or AVX2 versions are used depending
+ *  on what is available at run time; otherwise, or with other compilers, plain C++ versions
+ *  are used. All versions produce exactly the same results. For 16 bit samples the additions
+ *  saturate instead of wrapping around. Alternatively, 16 bit samples can be accumulated
+ *  in 32 bit values, which are converted back using MIPMixKernels::softClip32To16.
+ */
+class EMIPLIB_IMPORTEXPORT MIPMixKernels
+{
+public:
+	/** The implementations which can be selected. */
+	enum InstructionSet
+	{
+		/** Plain C++ code. */
+		Scalar,
+		/** SSE2 instructions, processing 128 bits at once. */
+		SSE2,
+		/** AVX2 instructions, processing 256 bits at once. */
+		AVX2
+	};
+
+	/** Returns the implementation that is currently used; by default the best one which is supported. */
+	static InstructionSet getInstructionSet();
+
+	/** Returns true if \c set can be used on this processor. */
+	static bool isSupported(InstructionSet set);
+
+	/** Selects a specific implementation, which can be useful for testing; returns false if
+	 *  it's not supported. This should not be called while samples are being mixed. */
+	static bool setInstructionSet(InstructionSet set);
+
+	/** Adds \c num floating point samples from \c pSrc to \c pDest. */
+	static void addFloat(float *pDest, const float *pSrc, size_t num)				{ getKernels().m_addFloat(pDest, pSrc, num); }
+
+	/** Adds \c num 16 bit samples from \c pSrc to \c pDest, limiting the results to the 16 bit range. */
+	static void addS16Saturated(int16_t *pDest, const int16_t *pSrc, size_t num)			{ getKernels().m_addS16Saturated(pDest, pSrc, num); }
+
+	/** Adds \c num 16 bit samples from \c pSrc to the 32 bit accumulators in \c pDest. */
+	static void addS16To32(int32_t *pDest, const int16_t *pSrc, size_t num)				{ getKernels().m_addS16To32(pDest, pSrc, num); }
+
+	/** Converts \c num accumulated samples to 16 bit samples.
+	 *  Values up to MIPMIXKERNELS_SOFTCLIP_THRESHOLD in magnitude are passed unchanged, larger
+	 *  ones are compressed smoothly so that they approach, but never exceed, the 16 bit range.
+	 *  This avoids the harsh distortion of hard clipping when several loud streams overlap.
+	 */
+	static void softClip32To16(int16_t *pDest, const int32_t *pSrc, size_t num)			{ getKernels().m_softClip32To16(pDest, pSrc, num); }
+
+	/** Converts \c num accumulated samples to 16 bit samples, limiting them to the 16 bit range. */
+	static void saturate32To16(int16_t *pDest, const int32_t *pSrc, size_t num)			{ getKernels().m_saturate32To16(pDest, pSrc, num); }
+
+	/** Stores \c pA minus \c pB in \c pDest, for \c num floating point samples. */
+	static void subtractFloat(float *pDest, const float *pA, const float *pB, size_t num)		{ getKernels().m_subtractFloat(pDest, pA, pB, num); }
+
+	/** Stores \c pA minus \c pB in \c pDest, for \c num accumulated samples. */
+	static void subtract32(int32_t *pDest, const int32_t *pA, const int32_t *pB, size_t num)	{ getKernels().m_subtract32(pDest, pA, pB, num); }
+private:
+	struct Kernels
+	{
+		void (*m_addFloat)(float *, const float *, size_t);
+		void (*m_addS16Saturated)(int16_t *, const int16_t *, size_t);
+		void (*m_addS16To32)(int32_t *, const int16_t *, size_t);
+		void (*m_softClip32To16)(int16_t *, const int32_t *, size_t);
+		void (*m_saturate32To16)(int16_t *, const int32_t *, size_t);
+		void (*m_subtractFloat)(float *, const float *, const float *, size_t);
+		void (*m_subtract32)(int32_t *, const int32_t *, const int32_t *, size_t);
+		InstructionSet m_set;
+	};
+
+	static Kernels &getKernels();
+	static void selectKernels(Kernels &kernels, InstructionSet set);
+};
+
+#endif // MIPMIXKERNELS_H
+
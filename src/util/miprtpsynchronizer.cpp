@@ -225,7 +225,10 @@ MIPTime MIPRTPSynchronizer::calculateSynchronizationOffset(int64_t streamID)
 		recalc = true;
 	else
 	{
-		if ((MIPTime::getCurrentTime().getValue() - pGroup->getLastCalculationTime().getValue()) > 5.0) // only perform calculation each five seconds
+		MIPTime elapsed = MIPTime::getCurrentTime();
+
+		elapsed -= pGroup->getLastCalculationTime();
+		if (elapsed > MIPTime(5, 0)) // only perform calculation each five seconds
 			recalc = true;
 	}
 
@@ -0,0 +1,81 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipsourcefilter.h"
+
+#include "mipdebug.h"
+
+MIPSourceFilter::MIPSourceFilter()
+{
+	m_numSources = 0;
+}
+
+MIPSourceFilter::~MIPSourceFilter()
+{
+}
+
+void MIPSourceFilter::addSourceToIgnore(uint64_t id)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	m_sourcesToIgnore[id]++;
+	m_numSources = m_sourcesToIgnore.size();
+}
+
+void MIPSourceFilter::removeSourceToIgnore(uint64_t id)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	auto it = m_sourcesToIgnore.find(id);
+
+	if (it == m_sourcesToIgnore.end())
+		return;
+
+	it->second--;
+	if (it->second <= 0)
+		m_sourcesToIgnore.erase(it);
+	m_numSources = m_sourcesToIgnore.size();
+}
+
+void MIPSourceFilter::clearIgnoreList()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	m_sourcesToIgnore.clear();
+	m_numSources = 0;
+}
+
+bool MIPSourceFilter::isIgnored(uint64_t id) const
+{
+	// This is checked for every packet, avoid the lock in the common case
+	// where nothing needs to be ignored
+	if (m_numSources == 0)
+		return false;
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	return (m_sourcesToIgnore.find(id) != m_sourcesToIgnore.end());
+}
+
@@ -0,0 +1,74 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipsourcefilter.h
+ */
+
+#ifndef MIPSOURCEFILTER_H
+
+#define MIPSOURCEFILTER_H
+
+#include "mipconfig.h"
+#include "miptypes.h"
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+
+/** A set of source IDs which should not be processed.
+ *  An instance of this class can be shared by several components, possibly in different
+ *  chains, to drop the data of certain sources as early as possible. For example, the
+ *  MIPRTPComponent and MIPRTPDecoder components can be configured to use such a filter, so
+ *  that packets from muted participants are discarded before they are decoded, and an
+ *  MIPAudioMixer can store its ignore list in it. Since several of these users may ignore
+ *  the same source, the filter counts how often each identifier was added: a source is
+ *  ignored until it has been removed as often as it was added. All functions are thread-safe.
+ */
+class EMIPLIB_IMPORTEXPORT MIPSourceFilter
+{
+public:
+	MIPSourceFilter();
+	~MIPSourceFilter();
+
+	/** Adds a source identifier which should be ignored, or increases its count if it was already added. */
+	void addSourceToIgnore(uint64_t id);
+
+	/** Decreases the count of a source identifier, and no longer ignores the source once
+	 *  the count reaches zero. */
+	void removeSourceToIgnore(uint64_t id);
+
+	/** Clears the list of sources to ignore, including the identifiers that were added
+	 *  by other users of the filter. */
+	void clearIgnoreList();
+
+	/** Returns \c true if the source with identifier \c id should be ignored. */
+	bool isIgnored(uint64_t id) const;
+private:
+	mutable std::mutex m_mutex;
+	std::unordered_map<uint64_t, int> m_sourcesToIgnore;
+	std::atomic<size_t> m_numSources;
+};
+
+#endif // MIPSOURCEFILTER_H
+
@@ -0,0 +1,197 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+#include "mipconfig.h"
+#include "mipworkerpool.h"
+#include "miptime.h"
+
+#include "mipdebug.h"
+
+#define MIPWORKERPOOL_ERRSTR_ALREADYINIT		"Worker pool is already initialized"
+#define MIPWORKERPOOL_ERRSTR_NOTINIT			"Worker pool is not initialized"
+#define MIPWORKERPOOL_ERRSTR_BADNUMTHREADS		"The number of threads must be at least one"
+#define MIPWORKERPOOL_ERRSTR_CANTSTARTTHREAD		"Can't start a worker thread"
+
+MIPWorkerPool::MIPWorkerPool()
+{
+	m_init = false;
+	m_stop = false;
+}
+
+MIPWorkerPool::~MIPWorkerPool()
+{
+	destroy();
+}
+
+bool MIPWorkerPool::init(int numThreads)
+{
+	if (m_init)
+	{
+		setErrorString(MIPWORKERPOOL_ERRSTR_ALREADYINIT);
+		return false;
+	}
+
+	if (numThreads < 1)
+	{
+		setErrorString(MIPWORKERPOOL_ERRSTR_BADNUMTHREADS);
+		return false;
+	}
+
+	m_stop = false;
+	m_init = true;
+
+	for (int i = 0 ; i < numThreads ; i++)
+	{
+		WorkerThread *pThread = new WorkerThread(*this);
+
+		if (pThread->Start() < 0)
+		{
+			delete pThread;
+			destroy();
+			setErrorString(MIPWORKERPOOL_ERRSTR_CANTSTARTTHREAD);
+			return false;
+		}
+		m_threads.push_back(pThread);
+	}
+
+	return true;
+}
+
+bool MIPWorkerPool::destroy()
+{
+	if (!m_init)
+	{
+		setErrorString(MIPWORKERPOOL_ERRSTR_NOTINIT);
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_stop = true;
+		m_queueCond.notify_all();
+	}
+
+	MIPTime startTime = MIPTime::getCurrentTime();
+
+	for (size_t i = 0 ; i < m_threads.size() ; i++)
+	{
+		WorkerThread *pThread = m_threads[i];
+
+		while (pThread->IsRunning() && (MIPTime::getCurrentTime().getValue() - startTime.getValue()) < 5.0) // wait maximum five seconds
+			MIPTime::wait(MIPTime(0.001));
+
+		if (pThread->IsRunning())
+			pThread->Kill();
+		delete pThread;
+	}
+	m_threads.clear();
+
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		while (!m_queue.empty())
+		{
+			m_queue.front().m_pGroup->m_outstanding--;
+			m_queue.pop_front();
+		}
+		m_doneCond.notify_all();
+	}
+
+	m_init = false;
+	return true;
+}
+
+void MIPWorkerPool::submit(Task *pTask, TaskGroup &group)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	group.m_outstanding++;
+	m_queue.push_back(QueueEntry(pTask, &group));
+	m_queueCond.notify_one();
+	m_doneCond.notify_all(); // a thread waiting for the group may help executing it
+}
+
+void MIPWorkerPool::wait(TaskGroup &group)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (group.m_outstanding > 0)
+	{
+		// Only help with tasks of the group itself: a task of another group may
+		// need a lock the caller holds, or take much longer than this group
+
+		auto it = m_queue.begin();
+
+		while (it != m_queue.end() && it->m_pGroup != &group)
+			++it;
+
+		if (it != m_queue.end())
+		{
+			QueueEntry entry = *it;
+			m_queue.erase(it);
+
+			lock.unlock();
+			runEntry(entry);
+			lock.lock();
+		}
+		else
+			m_doneCond.wait(lock);
+	}
+}
+
+void MIPWorkerPool::runEntry(const QueueEntry &entry)
+{
+	entry.m_pTask->run();
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	entry.m_pGroup->m_outstanding--;
+	if (entry.m_pGroup->m_outstanding == 0)
+		m_doneCond.notify_all();
+}
+
+void *MIPWorkerPool::WorkerThread::Thread()
+{
+	JThread::ThreadStarted();
+
+	std::unique_lock<std::mutex> lock(m_pool.m_mutex);
+
+	while (true)
+	{
+		while (!m_pool.m_stop && m_pool.m_queue.empty())
+			m_pool.m_queueCond.wait(lock);
+
+		if (m_pool.m_stop)
+			break;
+
+		QueueEntry entry = m_pool.m_queue.front();
+		m_pool.m_queue.pop_front();
+
+		lock.unlock();
+		m_pool.runEntry(entry);
+		lock.lock();
+	}
+
+	return 0;
+}
+
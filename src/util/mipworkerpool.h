@@ -0,0 +1,132 @@
+/*
+    
+  This file is a part of EMIPLIB, the EDM Media over IP Library.
+  
+  Copyright (C) 2006-2016  Hasselt University - Expertise Centre for
+                      Digital Media (EDM) (http://www.edm.uhasselt.be)
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  
+  USA
+
+*/
+
+/**
+ * \file mipworkerpool.h
+ */
+
+#ifndef MIPWORKERPOOL_H
+
+#define MIPWORKERPOOL_H
+
+#include "mipconfig.h"
+#include "miperrorbase.h"
+#include <jthread/jthread.h>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+/** A fixed size pool of background threads which execute tasks.
+ *  This class manages a fixed number of background threads which execute
+ *  instances of MIPWorkerPool::Task. Tasks are always submitted as part of a
+ *  MIPWorkerPool::TaskGroup, which keeps track of how many of its tasks are
+ *  still outstanding. A task may submit new tasks to the same group while it
+ *  is running, which makes it possible to execute a graph of dependent tasks.
+ *  The thread which calls MIPWorkerPool::wait helps executing the queued tasks
+ *  of the group until all of them have finished.
+ */
+class EMIPLIB_IMPORTEXPORT MIPWorkerPool : public MIPErrorBase
+{
+public:
+	/** Base class for work which can be executed by the pool. */
+	class EMIPLIB_IMPORTEXPORT Task
+	{
+	public:
+		Task()											{ }
+		virtual ~Task()										{ }
+
+		/** Implement this to perform the actual work; it is called from one
+		 *  of the pool's threads, or from the thread waiting for the task group. */
+		virtual void run() = 0;
+	};
+
+	/** Keeps track of a set of submitted tasks. */
+	class EMIPLIB_IMPORTEXPORT TaskGroup
+	{
+	public:
+		TaskGroup()										{ m_outstanding = 0; }
+	private:
+		friend class MIPWorkerPool;
+		int m_outstanding;
+	};
+
+	MIPWorkerPool();
+	~MIPWorkerPool();
+
+	/** Starts \c numThreads background threads. */
+	bool init(int numThreads);
+
+	/** Stops the background threads; tasks which are still queued are discarded. */
+	bool destroy();
+
+	/** Returns \c true if the pool has been initialized. */
+	bool isInit() const										{ return m_init; }
+
+	/** Returns the number of background threads. */
+	int getNumberOfThreads() const									{ return (int)m_threads.size(); }
+
+	/** Queues \c pTask for execution as part of \c group.
+	 *  Note that the pool does not take ownership of \c pTask, which must remain
+	 *  valid until it has been executed.
+	 */
+	void submit(Task *pTask, TaskGroup &group);
+
+	/** Waits until all tasks of \c group have been executed, running queued tasks of
+	 *  that group in the calling thread while waiting. */
+	void wait(TaskGroup &group);
+private:
+	class WorkerThread : public jthread::JThread
+	{
+	public:
+		WorkerThread(MIPWorkerPool &pool) : m_pool(pool)					{ }
+		~WorkerThread()										{ }
+	private:
+		void *Thread();
+
+		MIPWorkerPool &m_pool;
+	};
+
+	class QueueEntry
+	{
+	public:
+		QueueEntry(Task *pTask, TaskGroup *pGroup)						{ m_pTask = pTask; m_pGroup = pGroup; }
+
+		Task *m_pTask;
+		TaskGroup *m_pGroup;
+	};
+
+	void runEntry(const QueueEntry &entry);
+
+	bool m_init;
+	bool m_stop;
+	std::vector<WorkerThread *> m_threads;
+	std::deque<QueueEntry> m_queue;
+	std::mutex m_mutex;
+	std::condition_variable m_queueCond;
+	std::condition_variable m_doneCond;
+};
+
+#endif // MIPWORKERPOOL_H
+
@@ -0,0 +1,124 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipaudiomixer.h"
+#include "miprawaudiomessage.h"
+#include "miptime.h"
+#include <iostream>
+#include <vector>
+#include <set>
+#include <cstdlib>
+
+// Checks the active speaker selection of MIPAudioMixer: at most two sources are mixed,
+// quiet sources are never mixed, a short pause doesn't change the selection while a
+// long one does, and a new source only gets in when there is room
+
+using namespace std;
+
+#define NUMROUNDS		100
+#define BLOCKFRAMES		160
+
+void checkError(bool returnValue, const MIPComponent &component)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in component: " << component.getComponentName() << std::endl;
+	std::cerr << "Error description: " << component.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+// Sources 1 and 2 are loud, 3 to 6 are below the threshold. Source 1 pauses shortly
+// and stops at round 50, source 7 starts at round 40, and source 2 pauses for 30 rounds
+int getAmplitude(int source, int round)
+{
+	switch (source)
+	{
+	case 1:
+		return ((round >= 20 && round < 25) || round >= 50)?0:8000;
+	case 2:
+		return (round >= 60 && round < 90)?0:8000;
+	case 7:
+		return (round >= 40)?6000:0;
+	default:
+		return 30;
+	}
+}
+
+int main(void)
+{
+	MIPComponentChain chain("Active speaker test");
+	MIPAudioMixer mixer;
+	int status = 0;
+
+	// 20 ms blocks, 200 ms hangover
+	checkError(mixer.init(8000, 1, MIPTime(0.020), false, false), mixer);
+	checkError(mixer.setActiveSpeakerSelection(2, -40, MIPTime(0.2)), mixer);
+
+	for (int round = 1 ; round <= NUMROUNDS ; round++)
+	{
+		for (int source = 1 ; source <= 7 ; source++)
+		{
+			int amplitude = getAmplitude(source, round);
+			vector<int16_t> frames(BLOCKFRAMES);
+
+			for (int i = 0 ; i < BLOCKFRAMES ; i++)
+				frames[i] = (int16_t)((i%2)?amplitude:-amplitude);
+
+			MIPRaw16bitAudioMessage msg(8000, 1, BLOCKFRAMES, true, MIPRaw16bitAudioMessage::Native, (uint16_t *)&frames[0], false);
+
+			msg.setSourceID(source);
+			checkError(mixer.push(chain, round, &msg), mixer);
+		}
+
+		MIPMessage *pMsg = 0;
+
+		checkError(mixer.pull(chain, round, &pMsg), mixer);
+
+		int sample = (int)(int16_t)static_cast<MIPRaw16bitAudioMessage *>(pMsg)->getFrames()[1];
+
+		checkError(mixer.pull(chain, round, &pMsg), mixer);
+
+		vector<uint64_t> active;
+
+		mixer.getActiveSpeakers(active);
+
+		set<uint64_t> activeSet(active.begin(), active.end());
+		set<uint64_t> expectedSet;
+		int expectedSample = 0;
+
+		// The list of active speakers is the selection for the next round, which is 
+		// made using the levels up to this round. Source 7 only gets in when source 1
+		// stops. During the pause of source 2, its smoothed level takes a few rounds
+		// to drop below the threshold, after which it stays selected for the hangover
+		// time; it is mixed again as soon as it resumes, since there's room then.
+		if (round < 50)
+			expectedSet = { 1, 2 };
+		else if (round < 79 || round >= 90)
+			expectedSet = { 2, 7 };
+		else
+			expectedSet = { 7 };
+
+		for (auto source : expectedSet)
+			expectedSample += getAmplitude((int)source, round);
+
+		// When source 1 stops, source 7 is only mixed from the next round on
+		if (round == 50)
+			continue;
+
+		if (activeSet != expectedSet || sample != expectedSample)
+		{
+			cerr << "  Round " << round << ": mix " << sample << ", expected " << expectedSample << "; active";
+			for (auto source : activeSet)
+				cerr << " " << source;
+			cerr << endl;
+			status = -1;
+		}
+	}
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "Wrong sources mixed!" << endl;
+	return status;
+}
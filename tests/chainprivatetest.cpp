@@ -0,0 +1,144 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipcomponentalias.h"
+#include "mipaveragetimer.h"
+#include "miptime.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+// Checks that a chain-private component can't be used by a second chain or
+// through an alias, neither when a chain is started nor when it is rebuilt, and
+// that a chain can rebuild itself while using such a component
+
+using namespace std;
+
+#define ERRSTR_SHARED		"A chain-private component is used by another chain: "
+#define ERRSTR_ALIAS		"A chain-private component can't be used through an alias: "
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+// Accepts every message and never produces any
+class Sink : public MIPComponent
+{
+public:
+	Sink(const std::string &name) : MIPComponent(name)						{ }
+
+	bool push(const MIPComponentChain &, int64_t, MIPMessage *)				{ return true; }
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **pMsg)			{ *pMsg = 0; return true; }
+};
+
+// A chain with its own timer, feeding the components which are connected to it
+class TestChain : public MIPComponentChain
+{
+public:
+	TestChain(const std::string &name) : MIPComponentChain(name), m_timer(MIPTime(0.005))
+	{
+		checkError(setChainStart(&m_timer), *this);
+	}
+
+	void connect(MIPComponent *pComp)
+	{
+		checkError(addConnection(&m_timer, pComp), *this);
+	}
+
+	void disconnect(MIPComponent *pComp)
+	{
+		checkError(deleteConnection(&m_timer, pComp), *this);
+	}
+private:
+	MIPAverageTimer m_timer;
+};
+
+bool check(bool condition, const std::string &description)
+{
+	if (!condition)
+		cerr << "  Failed: " << description << endl;
+	return condition;
+}
+
+bool failsWith(bool returnValue, const MIPComponentChain &chain, const std::string &errStr, const std::string &description)
+{
+	if (returnValue)
+		return check(false, description + " succeeded");
+	return check(chain.getErrorString() == errStr, description + " failed with '" + chain.getErrorString() + "'");
+}
+
+int main(void)
+{
+	Sink privateSink("PrivateSink"), sharedSink("SharedSink"), otherSink("OtherSink");
+	MIPComponentAlias alias(&privateSink);
+	TestChain chain1("Chain 1"), chain2("Chain 2");
+	bool ok = true;
+
+	privateSink.setChainPrivate(true);
+
+	// A second chain can't start with a component that the first one uses privately
+	chain1.connect(&privateSink);
+	chain1.connect(&sharedSink);
+	checkError(chain1.start(), chain1);
+
+	chain2.connect(&privateSink);
+	ok &= failsWith(chain2.start(), chain2, ERRSTR_SHARED "PrivateSink", "starting a second chain with a private component");
+
+	// Nor with a component that it uses itself and which is private in the first one
+	chain2.disconnect(&privateSink);
+	chain2.connect(&otherSink);
+	checkError(chain2.start(), chain2);
+	chain1.connect(&otherSink);
+	otherSink.setChainPrivate(true);
+	ok &= failsWith(chain1.rebuild(), chain1, ERRSTR_SHARED "OtherSink", "rebuilding with a private component of another chain");
+	otherSink.setChainPrivate(false);
+	chain1.disconnect(&otherSink);
+
+	// Rebuilding re-registers the components the chain already uses, which must work
+	for (int i = 0 ; i < 3 ; i++)
+		ok &= check(chain1.rebuild(), "rebuilding a chain with a private component: " + chain1.getErrorString());
+
+	// An alias would lock the component without the chain knowing about it
+	chain1.connect(&alias);
+	ok &= failsWith(chain1.rebuild(), chain1, ERRSTR_ALIAS "PrivateSink", "rebuilding with an alias of a private component");
+	chain1.disconnect(&alias);
+	ok &= check(chain1.rebuild(), "rebuilding after removing the alias: " + chain1.getErrorString());
+
+	// A component that is shared with a running chain can't be made private in a rebuild
+	chain2.stop();
+	chain2.disconnect(&otherSink);
+	chain2.connect(&sharedSink);
+	checkError(chain2.start(), chain2);
+	sharedSink.setChainPrivate(true);
+	ok &= failsWith(chain1.rebuild(), chain1, ERRSTR_SHARED "SharedSink", "rebuilding with a component that another chain uses");
+	sharedSink.setChainPrivate(false);
+	chain2.stop();
+
+	chain1.stop();
+
+	// After the first chain stopped, its private component can be used elsewhere,
+	// but still not through an alias
+	TestChain chain3("Chain 3");
+
+	chain3.connect(&alias);
+	ok &= failsWith(chain3.start(), chain3, ERRSTR_ALIAS "PrivateSink", "starting with an alias of a private component");
+	chain3.disconnect(&alias);
+
+	chain2.disconnect(&sharedSink);
+	chain2.connect(&privateSink);
+	ok &= check(chain2.start(), "starting a chain with a private component that is no longer used: " + chain2.getErrorString());
+	chain2.stop();
+
+	if (ok)
+		cout << "OK" << endl;
+	else
+		cerr << "Chain-private components were not protected!" << endl;
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,238 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipaveragetimer.h"
+#include "miprawaudiomessage.h"
+#include "miptime.h"
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <cstdlib>
+
+// Rebuilds a running chain many times from the main thread, adding and removing
+// connections, and checks that no iteration fails and that a component which was
+// removed is no longer used once MIPComponentChain::rebuild has returned
+
+using namespace std;
+
+#define NUMPROBES		6
+#define NUMREBUILDS		300
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+class MyChain : public MIPComponentChain
+{
+public:
+	MyChain(const std::string &chainName) : MIPComponentChain(chainName)
+	{
+		m_exited = false;
+		m_failed = false;
+	}
+
+	bool exited() const
+	{
+		return m_exited;
+	}
+
+	bool failed() const
+	{
+		return m_failed;
+	}
+private:
+	void onThreadExit(bool error, const std::string &errorComponent, const std::string &errorDescription)
+	{
+		if (error)
+		{
+			std::cerr << "  Unexpected error in " << errorComponent << ": " << errorDescription << std::endl;
+			m_failed = true;
+		}
+		m_exited = true;
+	}
+
+	atomic_bool m_exited, m_failed;
+};
+
+// Produces a single message each time it receives a timer message
+class Source : public MIPComponent
+{
+public:
+	Source() : MIPComponent("Source"), m_msg(8000, 1, 1, m_frames, false)
+	{
+		m_frames[0] = 0;
+		m_gotMsg = false;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *)
+	{
+		m_frames[0] = (float)iteration;
+		m_gotMsg = false;
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **pMsg)
+	{
+		if (!m_gotMsg)
+		{
+			*pMsg = &m_msg;
+			m_gotMsg = true;
+		}
+		else
+		{
+			*pMsg = 0;
+			m_gotMsg = false;
+		}
+		return true;
+	}
+private:
+	float m_frames[1];
+	MIPRawFloatAudioMessage m_msg;
+	bool m_gotMsg;
+};
+
+// Counts the messages it receives, and every use while it's marked as removed
+class Probe : public MIPComponent
+{
+public:
+	Probe() : MIPComponent("Probe")
+	{
+		m_removed = true;
+		m_numMessages = 0;
+		m_numInvalidUses = 0;
+	}
+
+	bool push(const MIPComponentChain &, int64_t, MIPMessage *)
+	{
+		touch();
+		m_numMessages++;
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **pMsg)
+	{
+		touch();
+		*pMsg = 0;
+		return true;
+	}
+
+	bool onIterationStart(const MIPComponentChain &, int64_t)
+	{
+		touch();
+		return true;
+	}
+
+	bool onIterationEnd(const MIPComponentChain &, int64_t)
+	{
+		touch();
+		return true;
+	}
+
+	atomic_bool m_removed;
+	atomic<int64_t> m_numMessages;
+	atomic<int64_t> m_numInvalidUses;
+private:
+	void touch()
+	{
+		if (m_removed)
+			m_numInvalidUses++;
+	}
+};
+
+bool runChain(int numThreads)
+{
+	MyChain chain("Chain rebuild test");
+	MIPAverageTimer timer(MIPTime(0.001));
+	Source source;
+	Probe sink;
+	vector<Probe> probes(NUMPROBES);
+
+	checkError(chain.setNumberOfWorkerThreads(numThreads), chain);
+	checkError(chain.setChainStart(&timer), chain);
+	checkError(chain.addConnection(&timer, &source), chain);
+	checkError(chain.addConnection(&source, &sink), chain);
+	sink.m_removed = false;
+
+	checkError(chain.start(), chain);
+
+	for (int i = 0 ; i < NUMREBUILDS && !chain.exited() ; i++)
+	{
+		Probe &probe = probes[(i*7)%NUMPROBES];
+
+		if (probe.m_removed)
+		{
+			// Can be used as soon as the new connections are installed
+			probe.m_removed = false;
+			checkError(chain.addConnection(&source, &probe), chain);
+			checkError(chain.rebuild(), chain);
+		}
+		else
+		{
+			// Still allowed to be used until the rebuild is done
+			checkError(chain.deleteConnection(&source, &probe), chain);
+			checkError(chain.rebuild(), chain);
+			probe.m_removed = true;
+		}
+
+		if (i%10 == 0)
+			MIPTime::wait(MIPTime(0.002));
+	}
+
+	// Give the chain the time to use the removed components, if it would still do that
+	MIPTime::wait(MIPTime(0.020));
+
+	bool running = !chain.exited();
+
+	chain.stop();
+
+	int64_t numInvalidUses = 0, numProbeMessages = 0;
+
+	for (auto &probe : probes)
+	{
+		numInvalidUses += probe.m_numInvalidUses;
+		numProbeMessages += probe.m_numMessages;
+	}
+
+	cout << ((numThreads == 0)?"Serial:   ":"Parallel: ") << sink.m_numMessages << " iterations, " << numProbeMessages << " messages to probes, "
+	     << numInvalidUses << " uses of removed components" << endl;
+
+	bool ok = true;
+
+	if (!running || chain.failed())
+	{
+		cerr << "  The chain stopped while it was being rebuilt" << endl;
+		ok = false;
+	}
+	if (numInvalidUses != 0 || sink.m_numInvalidUses != 0)
+	{
+		cerr << "  Components were used after they were removed" << endl;
+		ok = false;
+	}
+	if (numProbeMessages == 0)
+	{
+		cerr << "  The added components were never used" << endl;
+		ok = false;
+	}
+	return ok;
+}
+
+int main(void)
+{
+	int status = 0;
+
+	if (!runChain(0) || !runChain(2))
+		status = -1;
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "Rebuilding the running chain failed!" << endl;
+	return status;
+}
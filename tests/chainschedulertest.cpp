@@ -0,0 +1,269 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipchainscheduler.h"
+#include "mipaveragetimer.h"
+#include "miptime.h"
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <set>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+
+// Executes a number of chains with different periods using a MIPChainScheduler,
+// repeatedly stopping and restarting some of them while the others stay scheduled,
+// and checks that each iteration is executed once per period, in order, by the
+// scheduler's threads and not after the chain was stopped
+
+using namespace std;
+
+#define NUMCHAINS		8
+#define NUMTHREADS		2
+#define NUMCYCLES		20
+#define MAXLATENESS		0.050
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+void checkError(bool returnValue, const MIPChainScheduler &scheduler)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in the scheduler" << std::endl;
+	std::cerr << "Error description: " << scheduler.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+mutex threadMutex;
+set<thread::id> threadIDs;
+
+// Checks the iterations of a single run of the chain
+class Recorder : public MIPComponent
+{
+public:
+	Recorder(MIPAverageTimer &timer) : MIPComponent("Recorder"), m_timer(timer)
+	{
+		m_stopped = false;
+		m_numIterations = 0;
+		m_numOutOfOrder = 0;
+		m_numAfterStop = 0;
+		m_maxLateness = 0;
+	}
+
+	void newRun()
+	{
+		m_stopped = false;
+		m_numIterations = 0;
+	}
+
+	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *)
+	{
+		MIPTime deadline;
+
+		if (m_stopped)
+			m_numAfterStop++;
+		if (iteration != m_numIterations + 1)
+			m_numOutOfOrder++;
+		m_numIterations = iteration;
+
+		if (!m_timer.getIterationStartTime(chain, iteration, deadline))
+		{
+			setErrorString(m_timer.getErrorString());
+			return false;
+		}
+
+		MIPTime lateness = MIPTime::getCurrentTime();
+
+		lateness -= deadline;
+		if (lateness.getNanoSeconds() > m_maxLateness)
+			m_maxLateness = lateness.getNanoSeconds();
+
+		lock_guard<mutex> guard(threadMutex);
+		threadIDs.insert(this_thread::get_id());
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **)
+	{
+		setErrorString("Pull not supported");
+		return false;
+	}
+
+	atomic_bool m_stopped;
+	atomic<int64_t> m_numIterations, m_numOutOfOrder, m_numAfterStop, m_maxLateness;
+private:
+	MIPAverageTimer &m_timer;
+};
+
+class TestChain : public MIPComponentChain
+{
+public:
+	TestChain(const std::string &name, MIPChainScheduler &scheduler, MIPTime period) : MIPComponentChain(name), m_timer(period),
+	                                                                                   m_recorder(m_timer), m_period(period)
+	{
+		m_numExits = 0;
+		m_numErrors = 0;
+		m_numBadRuns = 0;
+		m_startTime = MIPTime(0);
+		checkError(setScheduler(&scheduler), *this);
+		checkError(setChainStart(&m_timer), *this);
+		checkError(addConnection(&m_timer, &m_recorder), *this);
+	}
+
+	void startRun()
+	{
+		m_timer.reset();
+		m_recorder.newRun();
+		m_startTime = MIPTime::getCurrentTime();
+		checkError(start(), *this);
+	}
+
+	// Stops the chain and checks that the number of iterations matches the time it
+	// has been running
+	void stopRun()
+	{
+		checkError(stop(), *this);
+
+		MIPTime elapsed = MIPTime::getCurrentTime();
+
+		elapsed -= m_startTime;
+		m_recorder.m_stopped = true;
+
+		int64_t expected = elapsed.getNanoSeconds()/m_period.getNanoSeconds();
+		int64_t numIterations = m_recorder.m_numIterations;
+
+		if (numIterations < expected - 2 || numIterations > expected + 1)
+		{
+			cerr << "  " << getName() << ": " << numIterations << " iterations in " << elapsed.getValue()
+			     << " seconds, expected about " << expected << endl;
+			m_numBadRuns++;
+		}
+	}
+
+	int m_numBadRuns;
+	atomic<int> m_numExits, m_numErrors;
+	MIPAverageTimer m_timer;
+	Recorder m_recorder;
+private:
+	void onThreadExit(bool error, const std::string &errorComponent, const std::string &errorDescription)
+	{
+		if (error)
+		{
+			std::cerr << "  Unexpected error in " << errorComponent << ": " << errorDescription << std::endl;
+			m_numErrors++;
+		}
+		m_numExits++;
+	}
+
+	MIPTime m_period, m_startTime;
+};
+
+int main(void)
+{
+	MIPChainScheduler scheduler;
+	vector<unique_ptr<TestChain> > chains;
+	vector<int> numStops(NUMCHAINS, 0);
+
+	checkError(scheduler.init(NUMTHREADS, MIPTime(0.001)), scheduler);
+
+	for (int i = 0 ; i < NUMCHAINS ; i++)
+	{
+		MIPTime period = MIPTime::fromNanoSeconds((10 + 5*(i%3))*1000000LL);
+
+		chains.push_back(unique_ptr<TestChain>(new TestChain("Chain " + to_string(i), scheduler, period)));
+	}
+
+	for (auto &chain : chains)
+		chain->startRun();
+
+	// Each cycle, a third of the chains is stopped while the others keep their tasks
+	// queued, and is restarted after a while
+	for (int cycle = 0 ; cycle < NUMCYCLES ; cycle++)
+	{
+		MIPTime::wait(MIPTime(0.050));
+
+		for (int i = 0 ; i < NUMCHAINS ; i++)
+		{
+			if ((i + cycle)%3 == 0)
+			{
+				chains[i]->stopRun();
+				numStops[i]++;
+			}
+		}
+
+		// A stopped chain must not be executed anymore
+		MIPTime::wait(MIPTime(0.030));
+
+		for (int i = 0 ; i < NUMCHAINS ; i++)
+		{
+			if ((i + cycle)%3 == 0)
+				chains[i]->startRun();
+		}
+	}
+
+	MIPTime::wait(MIPTime(0.050));
+	for (int i = 0 ; i < NUMCHAINS ; i++)
+	{
+		chains[i]->stopRun();
+		numStops[i]++;
+	}
+
+	checkError(scheduler.destroy(), scheduler);
+
+	int numBad = 0;
+	int64_t maxLateness = 0;
+
+	for (int i = 0 ; i < NUMCHAINS ; i++)
+	{
+		TestChain &chain = *chains[i];
+
+		if (chain.m_numExits != numStops[i] || chain.m_numErrors != 0)
+		{
+			cerr << "  " << chain.getName() << ": " << chain.m_numExits << " exits for " << numStops[i] << " stops, "
+			     << chain.m_numErrors << " errors" << endl;
+			numBad++;
+		}
+		if (chain.m_recorder.m_numOutOfOrder != 0 || chain.m_recorder.m_numAfterStop != 0)
+		{
+			cerr << "  " << chain.getName() << ": " << chain.m_recorder.m_numOutOfOrder << " iterations out of order, "
+			     << chain.m_recorder.m_numAfterStop << " after the chain was stopped" << endl;
+			numBad++;
+		}
+		if (chain.m_recorder.m_maxLateness > maxLateness)
+			maxLateness = chain.m_recorder.m_maxLateness;
+		numBad += chain.m_numBadRuns;
+	}
+
+	if (maxLateness > MIPTime(MAXLATENESS).getNanoSeconds())
+	{
+		cerr << "  Iterations were started up to " << maxLateness/1000000 << " ms late" << endl;
+		numBad++;
+	}
+	if (threadIDs.size() > NUMTHREADS)
+	{
+		cerr << "  The chains were executed by " << threadIDs.size() << " threads" << endl;
+		numBad++;
+	}
+
+	cout << NUMCHAINS << " chains on " << threadIDs.size() << " threads, at most " << maxLateness/1000000
+	     << " ms late, " << numBad << " errors" << endl;
+
+	if (numBad == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "The scheduled chains were not executed as expected!" << endl;
+	return (numBad == 0) ? 0 : -1;
+}
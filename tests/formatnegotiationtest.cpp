@@ -0,0 +1,288 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipaveragetimer.h"
+#include "mipaudiomixer.h"
+#include "mipdefaultconverterfactory.h"
+#include "miprawaudiomessage.h"
+#include "mipsystemmessage.h"
+#include "mipmessageformat.h"
+#include "miptime.h"
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+// Connects a source of 16 kHz, 16 bit audio to a mixer which expects floating
+// point samples at 8 kHz, and checks that the converters which the chain inserts
+// deliver the right audio, and that the chain can't be started without them
+
+using namespace std;
+
+#define NUMITERATIONS		30
+#define SOURCEFRAMES		320
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+void checkError(bool returnValue, const MIPComponent &component)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in component: " << component.getComponentName() << std::endl;
+	std::cerr << "Error description: " << component.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+class MyChain : public MIPComponentChain
+{
+public:
+	MyChain(const std::string &chainName) : MIPComponentChain(chainName)
+	{
+		m_exited = false;
+	}
+
+	bool exited() const
+	{
+		return m_exited;
+	}
+private:
+	void onThreadExit(bool, const std::string &errorComponent, const std::string &errorDescription)
+	{
+		if (errorComponent != "Checker")
+			std::cerr << "  Unexpected error in " << errorComponent << ": " << errorDescription << std::endl;
+		m_exited = true;
+	}
+
+	atomic_bool m_exited;
+};
+
+int getAmplitude(int64_t iteration)
+{
+	return (int)((iteration*1237)%20000) - 10000;
+}
+
+// Produces 20 ms of constant 16 bit audio at 16 kHz each iteration, which is only
+// accepted by the mixer after conversion, and passes on the timer message
+class Source : public MIPComponent
+{
+public:
+	Source() : MIPComponent("Source"), m_audioMsg(16000, 1, SOURCEFRAMES, true, MIPRaw16bitAudioMessage::Native, (uint16_t *)m_frames, false),
+	                                   m_timeMsg(MIPSYSTEMMESSAGE_TYPE_ISTIME)
+	{
+		m_pos = 0;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *)
+	{
+		for (int i = 0 ; i < SOURCEFRAMES ; i++)
+			m_frames[i] = (int16_t)getAmplitude(iteration);
+		m_pos = 0;
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **pMsg)
+	{
+		if (m_pos == 0)
+			*pMsg = &m_timeMsg;
+		else if (m_pos == 1)
+			*pMsg = &m_audioMsg;
+		else
+		{
+			*pMsg = 0;
+			m_pos = 0;
+			return true;
+		}
+		m_pos++;
+		return true;
+	}
+
+	bool getOutputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+	{
+		formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_SYSTEM, MIPSYSTEMMESSAGE_TYPE_ISTIME));
+		formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, MIPRAWAUDIOMESSAGE_TYPE_S16, 16000, 1));
+		return true;
+	}
+private:
+	int16_t m_frames[SOURCEFRAMES];
+	MIPRaw16bitAudioMessage m_audioMsg;
+	MIPSystemMessage m_timeMsg;
+	int m_pos;
+};
+
+// Compares the mixed audio to the source's amplitude, and stops the chain after
+// a number of iterations
+class Checker : public MIPComponent
+{
+public:
+	Checker() : MIPComponent("Checker")
+	{
+		m_numMessages = 0;
+		m_numBad = 0;
+		m_numUnverified = 0;
+	}
+
+	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+	{
+		if (!isInputVerified(chain))
+			m_numUnverified++;
+
+		MIPRawFloatAudioMessage *pAudioMsg = static_cast<MIPRawFloatAudioMessage *>(pMsg);
+		float expected = (float)getAmplitude(iteration)/32768.0f;
+
+		if (pMsg->getMessageSubtype() != MIPRAWAUDIOMESSAGE_TYPE_FLOAT || pAudioMsg->getSamplingRate() != 8000)
+			m_numBad++;
+		else
+		{
+			for (int i = 0 ; i < pAudioMsg->getNumberOfFrames() ; i++)
+			{
+				if (std::fabs(pAudioMsg->getFrames()[i] - expected) > 1e-5)
+				{
+					m_numBad++;
+					break;
+				}
+			}
+		}
+		m_numMessages++;
+
+		if (iteration == NUMITERATIONS)
+		{
+			setErrorString("Stopping after requested number of iterations was reached");
+			return false;
+		}
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **)
+	{
+		setErrorString("Pull not supported");
+		return false;
+	}
+
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+	{
+		formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, MIPRAWAUDIOMESSAGE_TYPE_FLOAT, 8000, 1));
+		return true;
+	}
+
+	atomic<int> m_numMessages, m_numBad, m_numUnverified;
+};
+
+// Counts the timer messages, which reach it over the part of the connection that
+// isn't converted, and the converted audio messages
+class Counter : public MIPComponent
+{
+public:
+	Counter() : MIPComponent("Counter")
+	{
+		m_numTimeMessages = 0;
+		m_numAudioMessages = 0;
+	}
+
+	bool push(const MIPComponentChain &, int64_t, MIPMessage *pMsg)
+	{
+		if (pMsg->getMessageType() == MIPMESSAGE_TYPE_SYSTEM)
+			m_numTimeMessages++;
+		else if (pMsg->getMessageSubtype() == MIPRAWAUDIOMESSAGE_TYPE_FLOAT)
+			m_numAudioMessages++;
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **)
+	{
+		setErrorString("Pull not supported");
+		return false;
+	}
+
+	bool getInputMessageFormats(std::vector<MIPMessageFormat> &formats) const
+	{
+		formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_SYSTEM, MIPSYSTEMMESSAGE_TYPE_ISTIME));
+		formats.push_back(MIPMessageFormat(MIPMESSAGE_TYPE_AUDIO_RAW, MIPRAWAUDIOMESSAGE_TYPE_FLOAT, 8000, 1));
+		return true;
+	}
+
+	atomic<int> m_numTimeMessages, m_numAudioMessages;
+};
+
+bool runConverted()
+{
+	MyChain chain("Format negotiation test");
+	MIPAverageTimer timer(MIPTime(0.010));
+	MIPDefaultConverterFactory factory;
+	MIPAudioMixer mixer;
+	Source source;
+	Checker checker;
+	Counter counter;
+
+	checkError(mixer.init(8000, 1, MIPTime(0.020), false, true), mixer);
+	checkError(chain.setFormatNegotiation(true, &factory), chain);
+	checkError(chain.setChainStart(&timer), chain);
+	checkError(chain.addConnection(&timer, &source), chain);
+	checkError(chain.addConnection(&source, &mixer), chain);
+	checkError(chain.addConnection(&source, &counter), chain);
+	checkError(chain.addConnection(&mixer, &checker), chain);
+
+	checkError(chain.start(), chain);
+	while (!chain.exited())
+		MIPTime::wait(MIPTime(0.001));
+	chain.stop();
+
+	cout << "Converted: " << checker.m_numMessages << " messages, " << checker.m_numBad << " wrong, "
+	     << checker.m_numUnverified << " not verified; " << counter.m_numTimeMessages << " timer and "
+	     << counter.m_numAudioMessages << " audio messages passed on" << endl;
+	return checker.m_numMessages == NUMITERATIONS && checker.m_numBad == 0 && checker.m_numUnverified == 0 &&
+	       counter.m_numTimeMessages >= NUMITERATIONS && counter.m_numAudioMessages == counter.m_numTimeMessages;
+}
+
+bool runWithoutFactory()
+{
+	MyChain chain("Format negotiation test");
+	MIPAverageTimer timer(MIPTime(0.010));
+	MIPAudioMixer mixer;
+	Source source;
+	Checker checker;
+
+	checkError(mixer.init(8000, 1, MIPTime(0.020), false, true), mixer);
+	checkError(chain.setFormatNegotiation(true), chain);
+	checkError(chain.setChainStart(&timer), chain);
+	checkError(chain.addConnection(&timer, &source), chain);
+	checkError(chain.addConnection(&source, &mixer), chain);
+	checkError(chain.addConnection(&mixer, &checker), chain);
+
+	if (chain.start())
+	{
+		chain.stop();
+		cout << "Without factory: the chain was started" << endl;
+		return false;
+	}
+
+	string errStr = chain.getErrorString();
+
+	cout << "Without factory: " << errStr << endl;
+	return errStr.find("Incompatible message formats") == 0 && errStr.find("Source to MIPAudioMixer") != string::npos;
+}
+
+int main(void)
+{
+	int status = 0;
+
+	if (!runConverted() || !runWithoutFactory())
+		status = -1;
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "Format negotiation did not behave as expected!" << endl;
+	return status;
+}
@@ -0,0 +1,130 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "miphandoffqueue.h"
+#include "miprawaudiomessage.h"
+#include "miptime.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+// Checks which messages a MIPHandoffQueue delivers for each overflow policy when
+// the ring buffer is full, and that with the Block policy a waiting producer is
+// woken up as soon as the consumer takes messages
+
+using namespace std;
+
+void checkError(bool returnValue, const MIPComponent &component)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in component: " << component.getComponentName() << std::endl;
+	std::cerr << "Error description: " << component.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+// Hands over the messages with sequence numbers first ... first+num-1, which are
+// stored in the source ID
+void produce(MIPHandoffQueue &queue, const MIPComponentChain &chain, int64_t iteration, int first, int num)
+{
+	MIPComponent *pSink = queue.getSinkComponent();
+	float frames[4] = { 0, 0, 0, 0 };
+
+	for (int i = first ; i < first+num ; i++)
+	{
+		MIPRawFloatAudioMessage msg(8000, 1, 4, frames, false);
+
+		msg.setSourceID(i);
+		checkError(pSink->push(chain, iteration, &msg), *pSink);
+	}
+}
+
+vector<int> consume(MIPHandoffQueue &queue, const MIPComponentChain &chain, int64_t iteration)
+{
+	vector<int> sequence;
+	MIPMessage *pMsg = 0;
+
+	do
+	{
+		checkError(queue.pull(chain, iteration, &pMsg), queue);
+		if (pMsg)
+			sequence.push_back((int)static_cast<MIPAudioMessage *>(pMsg)->getSourceID());
+	} while (pMsg);
+	return sequence;
+}
+
+bool testPolicy(MIPHandoffQueue::OverflowPolicy policy, const vector<int> &expected, const char *name)
+{
+	MIPComponentChain chain("Handoff queue test");
+	MIPHandoffQueue queue;
+
+	checkError(queue.init(4, policy, MIPTime(0.010)), queue);
+	produce(queue, chain, 1, 0, 6);
+
+	vector<int> sequence = consume(queue, chain, 1);
+	bool ok = (sequence == expected && queue.getNumberOfDroppedMessages() == 2 && 
+	           queue.getNumberOfDeliveredMessages() == 4 && queue.getMaximumOccupancy() == 4);
+
+	cout << "  " << name << ": received";
+	for (int i : sequence)
+		cout << " " << i;
+	cout << ", " << queue.getNumberOfDroppedMessages() << " dropped" << endl;
+	return ok;
+}
+
+// The producer fills the queue much faster than the consumer empties it; with
+// the Block policy and a large timeout, nothing may get lost
+bool testBlocking()
+{
+	MIPComponentChain producerChain("Producer"), consumerChain("Consumer");
+	MIPHandoffQueue queue;
+	const int numMessages = 200;
+	vector<int> received;
+
+	checkError(queue.init(4, MIPHandoffQueue::Block, MIPTime(5.0)), queue);
+
+	MIPTime startTime = MIPTime::getCurrentTime();
+	thread producer([&]() { produce(queue, producerChain, 1, 0, numMessages); });
+
+	for (int64_t iteration = 1 ; (int)received.size() < numMessages && iteration < 10*numMessages ; iteration++)
+	{
+		vector<int> sequence = consume(queue, consumerChain, iteration);
+
+		received.insert(received.end(), sequence.begin(), sequence.end());
+		MIPTime::wait(MIPTime(0.0005));
+	}
+	producer.join();
+
+	double duration = MIPTime::getCurrentTime().getValue() - startTime.getValue();
+	bool ok = ((int)received.size() == numMessages && queue.getNumberOfDroppedMessages() == 0);
+
+	for (int i = 0 ; ok && i < numMessages ; i++)
+		ok = (received[i] == i);
+
+	cout << "  Block with consumer thread: received " << received.size() << " of " << numMessages << " in " << duration << " seconds" << endl;
+
+	// A producer which isn't woken up would only continue after the timeout
+	return ok && duration < 5.0;
+}
+
+int main(void)
+{
+	int status = 0;
+
+	if (!testPolicy(MIPHandoffQueue::DropNewest, { 0, 1, 2, 3 }, "DropNewest"))
+		status = -1;
+	if (!testPolicy(MIPHandoffQueue::DropOldest, { 2, 3, 4, 5 }, "DropOldest"))
+		status = -1;
+	if (!testPolicy(MIPHandoffQueue::Block, { 0, 1, 2, 3 }, "Block"))
+		status = -1;
+	if (!testBlocking())
+		status = -1;
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "Wrong messages delivered!" << endl;
+	return status;
+}
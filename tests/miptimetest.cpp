@@ -0,0 +1,76 @@
+#include "mipconfig.h"
+#include "miptime.h"
+#include <iostream>
+#include <string>
+
+// Checks that MIPTime calculates with an exact number of nanoseconds, so that adding
+// the same interval over and over again doesn't make the time drift
+
+using namespace std;
+
+int status = 0;
+
+void check(bool ok, const string &description)
+{
+	if (ok)
+		return;
+
+	cerr << "  Failed: " << description << endl;
+	status = -1;
+}
+
+int main(void)
+{
+	// Conversion from real_t rounds to the nearest nanosecond
+	check(MIPTime(0.020).getNanoSeconds() == 20000000, "0.020 seconds");
+	check(MIPTime(0.0000000006).getNanoSeconds() == 1, "rounding up");
+	check(MIPTime(0.0000000004).getNanoSeconds() == 0, "rounding down");
+	check(MIPTime(-0.25).getNanoSeconds() == -250000000, "negative time");
+
+	// The (seconds, microseconds) constructor is exact, also for large values
+	MIPTime t1(5, 123456);
+
+	check(t1.getNanoSeconds() == INT64_C(5123456000), "seconds and microseconds");
+	check(t1.getSeconds() == 5 && t1.getMicroSeconds() == 123456, "getSeconds and getMicroSeconds");
+	check(t1.getString() == "5.123456", "getString");
+	check(MIPTime(1000000000, 1).getNanoSeconds() == INT64_C(1000000000000001000), "large time");
+	check(MIPTime::fromNanoSeconds(123).getNanoSeconds() == 123, "fromNanoSeconds");
+
+	// Negative times keep the results of the previous floating point implementation
+	MIPTime t2(-1.5);
+
+	check(t2.getSeconds() == -1 && t2.getMicroSeconds() == 500000, "negative seconds and microseconds");
+	check(t2.getString() == "-1.500000", "negative getString");
+
+	// Twenty hours of 20 ms intervals end up at exactly 72000 seconds, and going
+	// back gives exactly zero again
+	MIPTime interval(0.020);
+	MIPTime t3(0);
+	const int numIntervals = 3600000;
+
+	for (int i = 0 ; i < numIntervals ; i++)
+		t3 += interval;
+	check(t3.getNanoSeconds() == INT64_C(72000000000000) && t3.getSeconds() == 72000 && t3.getMicroSeconds() == 0, "repeated addition");
+	for (int i = 0 ; i < numIntervals ; i++)
+		t3 -= interval;
+	check(t3.getNanoSeconds() == 0, "repeated subtraction");
+
+	// Ten times 0.1 seconds is exactly one second
+	MIPTime t4(0);
+
+	for (int i = 0 ; i < 10 ; i++)
+		t4 += MIPTime(0.1);
+	check(t4.getNanoSeconds() == MIPTime(1.0).getNanoSeconds(), "ten times 0.1 seconds");
+	check(!(t4 < MIPTime(1.0)) && !(t4 > MIPTime(1.0)) && t4 <= MIPTime(1.0) && t4 >= MIPTime(1.0), "comparison of equal times");
+
+	// A single nanosecond is still noticed
+	MIPTime t5 = MIPTime::fromNanoSeconds(INT64_C(72000000000001));
+
+	check(t5 > MIPTime(72000.0) && MIPTime(72000.0) < t5, "comparison of times one nanosecond apart");
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "MIPTime calculations are wrong!" << endl;
+	return status;
+}
@@ -0,0 +1,123 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipaudiomixer.h"
+#include "miprawaudiomessage.h"
+#include "miptime.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+// Checks that MIPAudioMixer plays audio at the right position while its circular 
+// block store wraps around many times, and when it has to grow because audio 
+// arrives further ahead than the buffer time specified in MIPAudioMixer::init
+
+using namespace std;
+
+#define NUMROUNDS		200
+#define BLOCKFRAMES		160
+
+void checkError(bool returnValue, const MIPComponent &component)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in component: " << component.getComponentName() << std::endl;
+	std::cerr << "Error description: " << component.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+// Number of blocks (possibly fractional) after which the audio pushed in a round 
+// should be played. A few of these are much larger than the buffer time, so that
+// the block store needs to grow.
+double getDelay(int round)
+{
+	if (round == 50 || round == 120)
+		return 30;
+	if (round == 121)
+		return 45;
+	if (round%7 == 0)
+		return 3.5; // spans two blocks
+	return 2;
+}
+
+bool runMixer(bool floatSamples)
+{
+	MIPComponentChain chain("Mixer buffer test");
+	MIPAudioMixer mixer;
+	MIPTime blockTime(0.020);
+	vector<vector<int> > expected(NUMROUNDS + 64, vector<int>(BLOCKFRAMES, 0));
+	int numBad = 0;
+
+	checkError(mixer.init(8000, 1, blockTime, true, floatSamples, MIPTime(0.040)), mixer);
+
+	for (int round = 1 ; round <= NUMROUNDS ; round++)
+	{
+		double delay = getDelay(round);
+		int value = round%100 + 1;
+		MIPTime t = mixer.getPlaybackTime();
+
+		t += MIPTime(blockTime.getValue()*delay);
+
+		// Audio pushed in a round is played 'delay' rounds later
+		int startFrame = (int)((round + delay)*BLOCKFRAMES + 0.5);
+
+		for (int i = 0 ; i < BLOCKFRAMES ; i++)
+		{
+			int pos = startFrame + i;
+
+			if (pos/BLOCKFRAMES < (int)expected.size())
+				expected[pos/BLOCKFRAMES][pos%BLOCKFRAMES] += value;
+		}
+
+		vector<float> floatFrames(BLOCKFRAMES, (float)value);
+		vector<int16_t> intFrames(BLOCKFRAMES, (int16_t)value);
+
+		if (floatSamples)
+		{
+			MIPRawFloatAudioMessage msg(8000, 1, BLOCKFRAMES, &floatFrames[0], false);
+
+			msg.setSourceID(1);
+			msg.setTime(t);
+			checkError(mixer.push(chain, round, &msg), mixer);
+		}
+		else
+		{
+			MIPRaw16bitAudioMessage msg(8000, 1, BLOCKFRAMES, true, MIPRaw16bitAudioMessage::Native, (uint16_t *)&intFrames[0], false);
+
+			msg.setSourceID(1);
+			msg.setTime(t);
+			checkError(mixer.push(chain, round, &msg), mixer);
+		}
+
+		MIPMessage *pMsg = 0;
+
+		checkError(mixer.pull(chain, round, &pMsg), mixer);
+		for (int i = 0 ; i < BLOCKFRAMES ; i++)
+		{
+			int sample = (floatSamples)?(int)(static_cast<MIPRawFloatAudioMessage *>(pMsg)->getFrames()[i]):
+			                            (int)(static_cast<MIPRaw16bitAudioMessage *>(pMsg)->getFrames()[i]);
+
+			if (sample != expected[round][i])
+				numBad++;
+		}
+		checkError(mixer.pull(chain, round, &pMsg), mixer);
+	}
+
+	cout << "  " << ((floatSamples)?"Float":"16 bit") << " samples: " << numBad << " wrong samples" << endl;
+	return numBad == 0;
+}
+
+int main(void)
+{
+	int status = 0;
+
+	if (!runMixer(true) || !runMixer(false))
+		status = -1;
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "Audio was played at the wrong position!" << endl;
+	return status;
+}
@@ -0,0 +1,143 @@
+#include "mipconfig.h"
+#include "mipmixkernels.h"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+// Checks that all supported SIMD versions of the mixing kernels produce exactly the 
+// same results as the plain C++ versions, for lengths which do and don't fill the
+// vector registers, and that the 16 bit additions saturate
+
+using namespace std;
+
+struct Input
+{
+	Input(int n) : m_a(n), m_b(n), m_acc(n), m_acc2(n), m_fa(n), m_fb(n)
+	{
+		for (int i = 0 ; i < n ; i++)
+		{
+			m_a[i] = (int16_t)(rand()%65536 - 32768);
+			m_b[i] = (int16_t)(rand()%65536 - 32768);
+			m_acc[i] = (i%3 == 0)?(rand()%200000 - 100000):(rand()%40000 - 20000);
+			m_acc2[i] = rand()%200000 - 100000;
+			m_fa[i] = (float)rand()/1000.0f;
+			m_fb[i] = (float)rand()/7.0f;
+		}
+
+		// Make sure the extremes are present
+		if (n >= 4)
+		{
+			m_a[0] = 32767; m_b[0] = 1;
+			m_a[1] = -32768; m_b[1] = -1;
+			m_a[2] = 32767; m_b[2] = 32767;
+			m_a[3] = -32768; m_b[3] = -32768;
+			m_acc[1] = 40000;
+			m_acc[2] = -40000;
+		}
+	}
+
+	vector<int16_t> m_a, m_b;
+	vector<int32_t> m_acc, m_acc2;
+	vector<float> m_fa, m_fb;
+};
+
+struct Output
+{
+	vector<int16_t> m_addS16, m_softClip, m_saturate;
+	vector<int32_t> m_addS16To32, m_subtract32;
+	vector<float> m_addFloat, m_subtractFloat;
+};
+
+Output runKernels(const Input &in, int n)
+{
+	Output out;
+
+	out.m_addS16 = in.m_a;
+	MIPMixKernels::addS16Saturated(out.m_addS16.data(), in.m_b.data(), n);
+	out.m_addS16To32 = in.m_acc;
+	MIPMixKernels::addS16To32(out.m_addS16To32.data(), in.m_b.data(), n);
+	out.m_softClip.resize(n);
+	MIPMixKernels::softClip32To16(out.m_softClip.data(), in.m_acc.data(), n);
+	out.m_saturate.resize(n);
+	MIPMixKernels::saturate32To16(out.m_saturate.data(), in.m_acc.data(), n);
+	out.m_subtract32.resize(n);
+	MIPMixKernels::subtract32(out.m_subtract32.data(), in.m_acc.data(), in.m_acc2.data(), n);
+	out.m_addFloat = in.m_fa;
+	MIPMixKernels::addFloat(out.m_addFloat.data(), in.m_fb.data(), n);
+	out.m_subtractFloat.resize(n);
+	MIPMixKernels::subtractFloat(out.m_subtractFloat.data(), in.m_fa.data(), in.m_fb.data(), n);
+	return out;
+}
+
+bool equal(const Output &o1, const Output &o2, int n)
+{
+	return o1.m_addS16 == o2.m_addS16 && o1.m_addS16To32 == o2.m_addS16To32 && o1.m_softClip == o2.m_softClip &&
+	       o1.m_saturate == o2.m_saturate && o1.m_subtract32 == o2.m_subtract32 &&
+	       memcmp(o1.m_addFloat.data(), o2.m_addFloat.data(), n*sizeof(float)) == 0 &&
+	       memcmp(o1.m_subtractFloat.data(), o2.m_subtractFloat.data(), n*sizeof(float)) == 0;
+}
+
+// Checks the results of the plain C++ versions themselves
+bool checkScalar(const Input &in, const Output &out, int n)
+{
+	for (int i = 0 ; i < n ; i++)
+	{
+		int32_t sum = (int32_t)in.m_a[i] + (int32_t)in.m_b[i];
+		int32_t sat = (sum > 32767)?32767:((sum < -32768)?-32768:sum);
+		int32_t acc = in.m_acc[i];
+		int32_t accSat = (acc > 32767)?32767:((acc < -32768)?-32768:acc);
+
+		if (out.m_addS16[i] != sat || out.m_saturate[i] != accSat)
+			return false;
+		if (out.m_addS16To32[i] != acc + in.m_b[i] || out.m_subtract32[i] != acc - in.m_acc2[i])
+			return false;
+		if (out.m_softClip[i] < -32767 || (acc >= 0 && out.m_softClip[i] > acc) || (acc < 0 && out.m_softClip[i] < acc) ||
+		    (acc > 0 && out.m_softClip[i] < 0) || (acc < 0 && out.m_softClip[i] > 0))
+			return false;
+	}
+	return true;
+}
+
+int main(void)
+{
+	const char *names[] = { "Scalar", "SSE2", "AVX2" };
+	int status = 0;
+
+	cout << "Default: " << names[MIPMixKernels::getInstructionSet()] << endl;
+	srand(1);
+
+	for (int n : { 0, 1, 4, 7, 8, 15, 16, 17, 33, 160, 161, 1001 })
+	{
+		Input in(n);
+
+		MIPMixKernels::setInstructionSet(MIPMixKernels::Scalar);
+
+		Output reference = runKernels(in, n);
+
+		if (!checkScalar(in, reference, n))
+		{
+			cerr << "Wrong scalar result for length " << n << endl;
+			status = -1;
+		}
+
+		for (int set = MIPMixKernels::SSE2 ; set <= MIPMixKernels::AVX2 ; set++)
+		{
+			if (!MIPMixKernels::setInstructionSet((MIPMixKernels::InstructionSet)set))
+			{
+				if (n == 0)
+					cout << names[set] << " is not supported, skipping" << endl;
+				continue;
+			}
+
+			if (!equal(runKernels(in, n), reference, n))
+			{
+				cerr << names[set] << " differs from the scalar version for length " << n << endl;
+				status = -1;
+			}
+		}
+	}
+	if (status == 0)
+		cout << "OK" << endl;
+	return status;
+}
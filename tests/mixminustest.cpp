@@ -0,0 +1,199 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipaudiomixer.h"
+#include "miprawaudiomessage.h"
+#include "mipmixkernels.h"
+#include "miptime.h"
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+
+// Checks that the mix-minus outputs of MIPAudioMixer contain the complete mix
+// without the audio of the source they're meant for, also when the block store
+// grows while these sources are active and after a source has been removed
+
+using namespace std;
+
+#define NUMSOURCES		3
+#define NUMROUNDS		200
+#define BLOCKFRAMES		160
+#define REMOVEROUND		120
+#define RETURNROUND		180
+
+void checkError(bool returnValue, const MIPComponent &component)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in component: " << component.getComponentName() << std::endl;
+	std::cerr << "Error description: " << component.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+// Number of blocks after which the audio pushed in a round should be played. A
+// few of these are much larger than the buffer time, so that the block store and
+// the contributions of the sources need to grow.
+int getDelay(int round)
+{
+	if (round == 40 || round == 100)
+		return 30;
+	if (round == 101)
+		return 70;
+	return 2 + round%3;
+}
+
+// The source with ID 3 leaves for a while, and is removed from the mix-minus outputs
+bool isSending(int sourceID, int round)
+{
+	return !(sourceID == 3 && round >= REMOVEROUND && round < RETURNROUND);
+}
+
+int getAmplitude(int sourceID, int round, bool floatSamples)
+{
+	if (floatSamples)
+		return sourceID*10 + round%7;
+	// Together these exceed the 16 bit range, so the outputs need to be clipped
+	return 9000 + sourceID*2000 + (round%7)*100;
+}
+
+int getExpectedSample(int sum, bool floatSamples, bool softClipping)
+{
+	if (floatSamples)
+		return sum;
+
+	int32_t value = sum;
+	int16_t result = 0;
+
+	if (softClipping)
+		MIPMixKernels::softClip32To16(&result, &value, 1);
+	else
+		MIPMixKernels::saturate32To16(&result, &value, 1);
+	return result;
+}
+
+bool runMixer(bool floatSamples, bool softClipping)
+{
+	MIPComponentChain chain("Mix-minus test");
+	MIPAudioMixer mixer;
+	MIPTime blockTime(0.020);
+	// For each interval, the amplitude of the audio of each source
+	vector<map<int, int> > contributions(NUMROUNDS + 128);
+	map<int, bool> expectedOutputs;
+	int numBad = 0, numClipped = 0;
+
+	checkError(mixer.init(8000, 1, blockTime, true, floatSamples, MIPTime(0.040), softClipping, true), mixer);
+
+	for (int round = 1 ; round <= NUMROUNDS ; round++)
+	{
+		// The mixer has played 'round-1' intervals so far
+		int curInterval = round - 1;
+
+		if (round == REMOVEROUND)
+		{
+			mixer.removeMixMinusSource(3);
+			expectedOutputs.erase(3);
+		}
+
+		for (int sourceID = 1 ; sourceID <= NUMSOURCES ; sourceID++)
+		{
+			if (!isSending(sourceID, round))
+				continue;
+
+			int delay = getDelay(round);
+			int amplitude = getAmplitude(sourceID, round, floatSamples);
+			MIPTime t = mixer.getPlaybackTime();
+
+			t += MIPTime::fromNanoSeconds(blockTime.getNanoSeconds()*delay);
+			contributions[curInterval + delay][sourceID] += amplitude;
+			expectedOutputs[sourceID] = true;
+
+			vector<float> floatFrames(BLOCKFRAMES, (float)amplitude);
+			vector<int16_t> intFrames(BLOCKFRAMES, (int16_t)amplitude);
+
+			if (floatSamples)
+			{
+				MIPRawFloatAudioMessage msg(8000, 1, BLOCKFRAMES, &floatFrames[0], false);
+
+				msg.setSourceID(sourceID);
+				msg.setTime(t);
+				checkError(mixer.push(chain, round, &msg), mixer);
+			}
+			else
+			{
+				MIPRaw16bitAudioMessage msg(8000, 1, BLOCKFRAMES, true, MIPRaw16bitAudioMessage::Native, (uint16_t *)&intFrames[0], false);
+
+				msg.setSourceID(sourceID);
+				msg.setTime(t);
+				checkError(mixer.push(chain, round, &msg), mixer);
+			}
+		}
+
+		map<int, int> &played = contributions[curInterval];
+		int sum = 0;
+
+		for (auto &contribution : played)
+			sum += contribution.second;
+
+		// The complete mix comes first, followed by one message per source
+		MIPMessage *pMsg = 0;
+		vector<uint64_t> sourceIDs;
+
+		checkError(mixer.pull(chain, round, &pMsg), mixer);
+		while (pMsg)
+		{
+			MIPAudioMessage *pAudioMsg = static_cast<MIPAudioMessage *>(pMsg);
+			uint64_t sourceID = pAudioMsg->getSourceID();
+			int expected = getExpectedSample((sourceIDs.empty())?sum:(sum - played[(int)sourceID]), floatSamples, softClipping);
+
+			for (int i = 0 ; i < BLOCKFRAMES ; i++)
+			{
+				int sample = (floatSamples)?(int)(static_cast<MIPRawFloatAudioMessage *>(pMsg)->getFrames()[i]):
+				                            (int)(int16_t)(static_cast<MIPRaw16bitAudioMessage *>(pMsg)->getFrames()[i]);
+
+				if (sample != expected)
+					numBad++;
+			}
+			if (!floatSamples && expected != sum)
+				numClipped++;
+
+			sourceIDs.push_back(sourceID);
+			checkError(mixer.pull(chain, round, &pMsg), mixer);
+		}
+
+		vector<uint64_t> expectedIDs(1, 0);
+
+		for (auto &output : expectedOutputs)
+			expectedIDs.push_back(output.first);
+		if (sourceIDs != expectedIDs)
+		{
+			cerr << "  Round " << round << ": got " << sourceIDs.size() << " messages instead of " << expectedIDs.size() << endl;
+			numBad++;
+		}
+	}
+
+	if (!floatSamples && numClipped == 0)
+	{
+		cerr << "  The 16 bit outputs were never clipped" << endl;
+		numBad++;
+	}
+
+	cout << "  " << ((floatSamples)?"Float":"16 bit") << " samples" << ((softClipping)?" with soft clipping":"")
+	     << ": " << numBad << " errors" << endl;
+	return numBad == 0;
+}
+
+int main(void)
+{
+	int status = 0;
+
+	if (!runMixer(true, false) || !runMixer(false, false) || !runMixer(false, true))
+		status = -1;
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "The mix-minus outputs were not correct!" << endl;
+	return status;
+}
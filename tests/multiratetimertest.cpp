@@ -0,0 +1,178 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipmultiratetimer.h"
+#include "mipfrequencygenerator.h"
+#include "mipclock.h"
+#include "miptime.h"
+#include <iostream>
+#include <atomic>
+#include <set>
+#include <cstdlib>
+
+// Checks that components connected to an output of a MIPMultiRateTimer are only
+// run at that output's rate, by counting the messages of a frequency generator
+// connected to each output
+
+using namespace std;
+
+#define NUMITERATIONS 300
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+class MyChain : public MIPComponentChain
+{
+public:
+	MyChain(const std::string &chainName) : MIPComponentChain(chainName)
+	{
+		m_exited = false;
+	}
+
+	bool exited() const
+	{
+		return m_exited;
+	}
+private:
+	void onThreadExit(bool, const std::string &errorComponent, const std::string &errorDescription)
+	{
+		if (errorComponent != "Counter")
+			std::cerr << "  Unexpected error in " << errorComponent << ": " << errorDescription << std::endl;
+		m_exited = true;
+	}
+
+	atomic_bool m_exited;
+};
+
+// Counts the messages it receives, and the iterations in which they arrived. The
+// counter on the base rate stops the chain once enough iterations have been done.
+class Counter : public MIPComponent
+{
+public:
+	Counter(bool stopChain) : MIPComponent("Counter"), m_stopChain(stopChain)
+	{
+		m_numMessages = 0;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *)
+	{
+		if (iteration > NUMITERATIONS)
+		{
+			if (!m_stopChain)
+				return true;
+			setErrorString("Requested number of iterations reached");
+			return false;
+		}
+		m_numMessages++;
+		m_iterations.insert(iteration);
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **)
+	{
+		setErrorString("Pull not supported");
+		return false;
+	}
+
+	int getNumberOfMessages() const
+	{
+		return m_numMessages;
+	}
+
+	int getNumberOfIterations() const
+	{
+		return (int)m_iterations.size();
+	}
+private:
+	bool m_stopChain;
+	int m_numMessages;
+	set<int64_t> m_iterations;
+};
+
+bool runChain(int numThreads)
+{
+	const real_t baseInterval = 0.010;
+	const real_t periods[] = { 0.010, 0.020, 0.030 };
+	const int numOutputs = 3;
+
+	MyChain chain("Multi-rate timer test");
+	MIPVirtualClock clock;
+	MIPTime baseTime(baseInterval);
+	MIPMultiRateTimer timer(baseTime);
+	MIPFrequencyGenerator generators[numOutputs];
+	Counter *counters[numOutputs];
+
+	checkError(chain.setClock(&clock), chain);
+	checkError(chain.setNumberOfWorkerThreads(numThreads), chain);
+	checkError(chain.setChainStart(&timer), chain);
+
+	for (int i = 0 ; i < numOutputs ; i++)
+	{
+		MIPComponent *pOutput = timer.addOutput(MIPTime(periods[i]));
+
+		if (pOutput == 0)
+		{
+			cerr << timer.getErrorString() << endl;
+			exit(-1);
+		}
+
+		if (!generators[i].init(440, 440, 0.5, 0.5, 8000, MIPTime(periods[i])))
+		{
+			cerr << generators[i].getErrorString() << endl;
+			exit(-1);
+		}
+
+		counters[i] = new Counter(i == 0);
+		checkError(chain.addConnection(&timer, pOutput), chain);
+		checkError(chain.addConnection(pOutput, &generators[i]), chain);
+		checkError(chain.addConnection(&generators[i], counters[i]), chain);
+	}
+
+	checkError(chain.start(), chain);
+	while (!chain.exited())
+		MIPTime::wait(MIPTime(0.001));
+	chain.stop();
+
+	bool ok = true;
+
+	for (int i = 0 ; i < numOutputs ; i++)
+	{
+		int expected = (int)(NUMITERATIONS*baseInterval/periods[i] + 0.5);
+		int numMessages = counters[i]->getNumberOfMessages();
+		int numIterations = counters[i]->getNumberOfIterations();
+
+		cout << "  " << numThreads << " threads, period " << periods[i] << ": " << numMessages << " messages in "
+		     << numIterations << " iterations, expected " << expected << endl;
+
+		// One message per period, and never more than one in an iteration
+		if (numMessages != expected || numIterations != expected)
+			ok = false;
+		delete counters[i];
+	}
+	return ok;
+}
+
+int main(void)
+{
+	int status = 0;
+
+	for (int numThreads = 0 ; numThreads <= 2 ; numThreads += 2)
+	{
+		if (!runChain(numThreads))
+		{
+			cerr << "Wrong number of messages!" << endl;
+			status = -1;
+		}
+	}
+	if (status == 0)
+		cout << "OK" << endl;
+	return status;
+}
@@ -0,0 +1,229 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipaveragetimer.h"
+#include "miprawaudiomessage.h"
+#include "miptime.h"
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <cstdlib>
+
+// Overloads a chain for a number of iterations with a component that takes longer
+// than the iteration budget, and checks that the connections with a negative
+// priority are shed lowest first and restored after the load has been low for a
+// while, both when the chain is executed serially and in parallel
+
+using namespace std;
+
+#define NUMITERATIONS		60
+#define OVERLOADSTART		20
+#define OVERLOADEND		30
+#define RECOVERYITERATIONS	5
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+class MyChain : public MIPComponentChain
+{
+public:
+	MyChain(const std::string &chainName) : MIPComponentChain(chainName)
+	{
+		m_exited = false;
+	}
+
+	bool exited() const
+	{
+		return m_exited;
+	}
+private:
+	void onThreadExit(bool, const std::string &errorComponent, const std::string &errorDescription)
+	{
+		if (errorComponent != "Load")
+			std::cerr << "  Unexpected error in " << errorComponent << ": " << errorDescription << std::endl;
+		m_exited = true;
+	}
+
+	atomic_bool m_exited;
+};
+
+// Produces a single message each time it receives a timer message
+class Source : public MIPComponent
+{
+public:
+	Source() : MIPComponent("Source"), m_msg(8000, 1, 1, m_frames, false)
+	{
+		m_frames[0] = 0;
+		m_gotMsg = false;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *)
+	{
+		m_frames[0] = (float)iteration;
+		m_gotMsg = false;
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **pMsg)
+	{
+		if (!m_gotMsg)
+		{
+			*pMsg = &m_msg;
+			m_gotMsg = true;
+		}
+		else
+		{
+			*pMsg = 0;
+			m_gotMsg = false;
+		}
+		return true;
+	}
+private:
+	float m_frames[1];
+	MIPRawFloatAudioMessage m_msg;
+	bool m_gotMsg;
+};
+
+// Remembers in which iterations it received a message
+class Sink : public MIPComponent
+{
+public:
+	Sink(const std::string &name) : MIPComponent(name), m_received(NUMITERATIONS + 1, 0)	{ }
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *)
+	{
+		if (iteration >= 0 && iteration <= NUMITERATIONS)
+			m_received[iteration] = 1;
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **)
+	{
+		setErrorString("Pull not supported");
+		return false;
+	}
+
+	bool hasReceived(int64_t iteration) const							{ return m_received[iteration] != 0; }
+private:
+	vector<char> m_received;
+};
+
+// Takes longer than the iteration budget in the overloaded iterations, and stops
+// the chain after a number of iterations
+class Load : public Sink
+{
+public:
+	Load() : Sink("Load")										{ }
+
+	bool push(const MIPComponentChain &chain, int64_t iteration, MIPMessage *pMsg)
+	{
+		Sink::push(chain, iteration, pMsg);
+		if (iteration >= OVERLOADSTART && iteration < OVERLOADEND)
+			MIPTime::wait(MIPTime(0.030));
+
+		if (iteration == NUMITERATIONS)
+		{
+			setErrorString("Stopping after requested number of iterations was reached");
+			return false;
+		}
+		return true;
+	}
+};
+
+// The number of priority levels which should be shed in an iteration. The overload
+// of an iteration causes one more level to be shed from the next one on, and each
+// level is restored after RECOVERYITERATIONS iterations without overload.
+int getExpectedShedLevels(int64_t iteration)
+{
+	if (iteration <= OVERLOADSTART)
+		return 0;
+	if (iteration == OVERLOADSTART + 1)
+		return 1;
+	if (iteration < OVERLOADEND + RECOVERYITERATIONS)
+		return 2;
+	if (iteration < OVERLOADEND + 2*RECOVERYITERATIONS)
+		return 1;
+	return 0;
+}
+
+bool runChain(int numThreads)
+{
+	MyChain chain("Overload test");
+	MIPAverageTimer timer(MIPTime(0.020));
+	Source source;
+	Load load;
+	Sink lowSink("LowSink"), lowestSink("LowestSink");
+
+	checkError(chain.setNumberOfWorkerThreads(numThreads), chain);
+	checkError(chain.setOverloadProtection(true, MIPTime(0.020), 0.9, 0.6, RECOVERYITERATIONS), chain);
+	checkError(chain.setChainStart(&timer), chain);
+	checkError(chain.addConnection(&timer, &source), chain);
+	checkError(chain.addConnection(&source, &load), chain);
+	checkError(chain.addConnection(&source, &lowSink, false, MIPMESSAGE_TYPE_ALL, MIPMESSAGE_TYPE_ALL, -1), chain);
+	checkError(chain.addConnection(&source, &lowestSink, false, MIPMESSAGE_TYPE_ALL, MIPMESSAGE_TYPE_ALL, -2), chain);
+
+	checkError(chain.start(), chain);
+	while (!chain.exited())
+		MIPTime::wait(MIPTime(0.010));
+
+	bool shedding = chain.isShedding();
+
+	chain.stop();
+
+	int numBad = 0, numShedLowest = 0, numShedLow = 0;
+
+	// The last iteration is aborted by the load component
+	for (int64_t iteration = 1 ; iteration < NUMITERATIONS ; iteration++)
+	{
+		int levels = getExpectedShedLevels(iteration);
+
+		if (!load.hasReceived(iteration))
+		{
+			cerr << "  Iteration " << iteration << ": the connection with priority 0 was shed" << endl;
+			numBad++;
+		}
+		if (lowestSink.hasReceived(iteration) != (levels < 1) || lowSink.hasReceived(iteration) != (levels < 2))
+		{
+			cerr << "  Iteration " << iteration << ": expected " << levels << " shed levels, priority -2 "
+			     << ((lowestSink.hasReceived(iteration))?"used":"shed") << ", priority -1 "
+			     << ((lowSink.hasReceived(iteration))?"used":"shed") << endl;
+			numBad++;
+		}
+		if (!lowestSink.hasReceived(iteration))
+			numShedLowest++;
+		if (!lowSink.hasReceived(iteration))
+			numShedLow++;
+	}
+
+	if (shedding)
+	{
+		cerr << "  The chain was still shedding after the overload ended" << endl;
+		numBad++;
+	}
+
+	cout << ((numThreads == 0)?"Serial:   ":"Parallel: ") << "priority -2 shed in " << numShedLowest << ", priority -1 in "
+	     << numShedLow << " iterations, " << numBad << " errors" << endl;
+	return numBad == 0;
+}
+
+int main(void)
+{
+	int status = 0;
+
+	if (!runChain(0) || !runChain(2))
+		status = -1;
+
+	if (status == 0)
+		cout << "OK" << endl;
+	else
+		cerr << "Overload protection did not behave as expected!" << endl;
+	return status;
+}
@@ -0,0 +1,356 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipaveragetimer.h"
+#include "miprawaudiomessage.h"
+#include "miptime.h"
+#include "mipworkerpool.h"
+#include <jthread/jthread.h>
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+class MyChain : public MIPComponentChain
+{
+public:
+	MyChain(const std::string &chainName) : MIPComponentChain(chainName)
+	{
+		m_exited = false;
+	}
+
+	bool start()
+	{
+		m_exited = false;
+		return MIPComponentChain::start();
+	}
+
+	bool exited() const
+	{
+		return m_exited;
+	}
+private:
+	void onThreadExit(bool, const std::string &errorComponent, const std::string &errorDescription)
+	{
+		m_exited = true;
+		if (errorComponent != "Collector")
+			std::cerr << "  Unexpected error in " << errorComponent << ": " << errorDescription << std::endl;
+	}
+
+	atomic_bool m_exited;
+};
+
+// Generates a number of audio blocks each time it receives a timer message
+class BlockSource : public MIPComponent
+{
+public:
+	BlockSource(int numBlocks, int blockSize) : MIPComponent("BlockSource"), m_blockSize(blockSize)
+	{
+		for (int i = 0 ; i < numBlocks ; i++)
+			m_messages.push_back(new MIPRawFloatAudioMessage(8000, 1, blockSize, new float[blockSize], true));
+		m_pos = 0;
+	}
+
+	~BlockSource()
+	{
+		for (auto pMsg : m_messages)
+			delete pMsg;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *)
+	{
+		for (size_t i = 0 ; i < m_messages.size() ; i++)
+		{
+			float *pFrames = const_cast<float *>(m_messages[i]->getFrames());
+			for (int j = 0 ; j < m_blockSize ; j++)
+				pFrames[j] = (float)((iteration*31 + i*7 + j)%101);
+			m_messages[i]->setSourceID(i);
+		}
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **pMsg)
+	{
+		if (m_pos < m_messages.size())
+			*pMsg = m_messages[m_pos++];
+		else
+		{
+			*pMsg = 0;
+			m_pos = 0;
+		}
+		return true;
+	}
+private:
+	int m_blockSize;
+	vector<MIPRawFloatAudioMessage *> m_messages;
+	size_t m_pos;
+};
+
+// Performs some work on each incoming block, and produces a single result per iteration
+class Worker : public MIPComponent
+{
+public:
+	Worker(int id, int rounds) : MIPComponent("Worker"), m_id(id), m_rounds(rounds), m_result(8000, 1, 1, m_value, false)
+	{
+		m_value[0] = 0;
+		m_gotMsg = false;
+		m_prevIteration = -1;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *pMsg)
+	{
+		if (iteration != m_prevIteration)
+		{
+			m_prevIteration = iteration;
+			m_value[0] = 0;
+		}
+
+		MIPRawFloatAudioMessage *pAudioMsg = static_cast<MIPRawFloatAudioMessage *>(pMsg);
+		const float *pFrames = pAudioMsg->getFrames();
+		double sum = 0;
+
+		for (int r = 0 ; r < m_rounds ; r++)
+			for (int i = 0 ; i < pAudioMsg->getNumberOfFrames() ; i++)
+				sum += std::sin(pFrames[i]*(m_id+1) + r);
+
+		m_value[0] += (float)std::floor(sum);
+		m_result.setSourceID(m_id);
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t iteration, MIPMessage **pMsg)
+	{
+		if (iteration != m_prevIteration)
+		{
+			*pMsg = 0;
+			return true;
+		}
+		if (!m_gotMsg)
+		{
+			*pMsg = &m_result;
+			m_gotMsg = true;
+		}
+		else
+		{
+			*pMsg = 0;
+			m_gotMsg = false;
+		}
+		return true;
+	}
+private:
+	int m_id, m_rounds;
+	float m_value[1];
+	MIPRawFloatAudioMessage m_result;
+	bool m_gotMsg;
+	int64_t m_prevIteration;
+};
+
+// Combines the results in an order dependent way, and stops the chain after
+// a number of iterations
+class Collector : public MIPComponent
+{
+public:
+	Collector(int stopAfterInterval) : MIPComponent("Collector"), m_stopCount(stopAfterInterval)
+	{
+		m_checksum = 0;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *pMsg)
+	{
+		MIPRawFloatAudioMessage *pAudioMsg = static_cast<MIPRawFloatAudioMessage *>(pMsg);
+
+		m_checksum = m_checksum*31 + (int64_t)pAudioMsg->getFrames()[0] + (int64_t)pAudioMsg->getSourceID();
+		if (iteration == (int64_t)m_stopCount)
+		{
+			setErrorString("Stopping after requested number of intervals was reached");
+			return false;
+		}
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **)
+	{
+		setErrorString("Pull not supported");
+		return false;
+	}
+
+	int64_t getChecksum() const
+	{
+		return m_checksum;
+	}
+private:
+	int m_stopCount;
+	int64_t m_checksum;
+};
+
+int64_t runChain(int numThreads, int numWorkers, int numIntervals, double &duration)
+{
+	MyChain chain("Parallel chain test");
+	MIPAverageTimer timer(MIPTime(0.001));
+	BlockSource source(4, 160);
+	Collector collector(numIntervals);
+	vector<Worker *> workers;
+
+	checkError(chain.setNumberOfWorkerThreads(numThreads), chain);
+	checkError(chain.setChainStart(&timer), chain);
+	checkError(chain.addConnection(&timer, &source), chain);
+	for (int i = 0 ; i < numWorkers ; i++)
+	{
+		workers.push_back(new Worker(i, 40));
+		checkError(chain.addConnection(&source, workers[i]), chain);
+		checkError(chain.addConnection(workers[i], &collector), chain);
+	}
+
+	MIPTime startTime = MIPTime::getCurrentTime();
+
+	checkError(chain.start(), chain);
+	while (!chain.exited())
+		MIPTime::wait(MIPTime(0.001));
+
+	duration = MIPTime::getCurrentTime().getValue() - startTime.getValue();
+
+	chain.stop();
+	for (auto pWorker : workers)
+		delete pWorker;
+
+	return collector.getChecksum();
+}
+
+// A parallel chain waits for its tasks in its own thread, helping to execute them.
+// When two chains share a pool, such a thread must not execute the tasks of the
+// other chain, which the tasks check using the chain running in the current thread
+
+class PoolChain;
+
+static thread_local const PoolChain *t_pPoolChain = 0;
+
+class PoolTask : public MIPWorkerPool::Task
+{
+public:
+	PoolTask()
+	{
+		m_pChain = 0;
+		m_wrongThread = false;
+		m_sum = 0;
+	}
+
+	void run()
+	{
+		if (t_pPoolChain != 0 && t_pPoolChain != m_pChain)
+			m_wrongThread = true;
+		for (int i = 0 ; i < 20000 ; i++)
+			m_sum += std::sin((double)i);
+	}
+
+	const PoolChain *m_pChain;
+	bool m_wrongThread;
+	double m_sum;
+};
+
+class PoolChain : public jthread::JThread
+{
+public:
+	PoolChain(MIPWorkerPool &pool, int numRounds) : m_pool(pool), m_numRounds(numRounds), m_tasks(8)
+	{
+		for (auto &task : m_tasks)
+			task.m_pChain = this;
+	}
+
+	void *Thread()
+	{
+		t_pPoolChain = this;
+		JThread::ThreadStarted();
+
+		for (int r = 0 ; r < m_numRounds ; r++)
+		{
+			MIPWorkerPool::TaskGroup group;
+
+			for (auto &task : m_tasks)
+				m_pool.submit(&task, group);
+			m_pool.wait(group);
+		}
+		return 0;
+	}
+
+	bool ranInWrongThread() const
+	{
+		for (auto &task : m_tasks)
+			if (task.m_wrongThread)
+				return true;
+		return false;
+	}
+private:
+	MIPWorkerPool &m_pool;
+	int m_numRounds;
+	vector<PoolTask> m_tasks;
+};
+
+bool runSharedPool(int numRounds)
+{
+	MIPWorkerPool pool;
+
+	if (!pool.init(1))
+	{
+		cerr << pool.getErrorString() << endl;
+		exit(-1);
+	}
+
+	PoolChain chain1(pool, numRounds), chain2(pool, numRounds);
+
+	if (chain1.Start() < 0 || chain2.Start() < 0)
+	{
+		cerr << "Can't start threads" << endl;
+		exit(-1);
+	}
+	while (chain1.IsRunning() || chain2.IsRunning())
+		MIPTime::wait(MIPTime(0.001));
+
+	return !chain1.ranInWrongThread() && !chain2.ranInWrongThread();
+}
+
+int main(void)
+{
+	int numWorkers = 8;
+	int numIntervals = 200;
+	double serialTime = 0;
+	int64_t serialChecksum = runChain(0, numWorkers, numIntervals, serialTime);
+
+	cout << "Serial:             checksum " << serialChecksum << ", " << serialTime << " seconds" << endl;
+
+	int status = 0;
+	for (int numThreads = 1 ; numThreads <= 4 ; numThreads++)
+	{
+		double parallelTime = 0;
+		int64_t parallelChecksum = runChain(numThreads, numWorkers, numIntervals, parallelTime);
+
+		cout << "Parallel, " << numThreads << " threads: checksum " << parallelChecksum << ", " << parallelTime << " seconds" << endl;
+		if (parallelChecksum != serialChecksum)
+		{
+			cerr << "  Checksum mismatch!" << endl;
+			status = -1;
+		}
+	}
+
+	if (!runSharedPool(100))
+	{
+		cerr << "Shared pool: tasks of one group were executed while waiting for another!" << endl;
+		status = -1;
+	}
+	else
+		cout << "Shared pool:        OK" << endl;
+	return status;
+}
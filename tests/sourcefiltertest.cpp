@@ -0,0 +1,165 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "miprtpdecoder.h"
+#include "miprtppacketdecoder.h"
+#include "miprtpmessage.h"
+#include "mipaudiomixer.h"
+#include "mipsourcefilter.h"
+#include "miprawaudiomessage.h"
+#include "miptime.h"
+#include <jrtplib3/rtppacket.h>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+// Checks that MIPRTPDecoder drops the packets of sources which are ignored by a
+// MIPSourceFilter before they're decoded, and that MIPAudioMixer only removes its
+// own entries from a filter that is shared with another mixer and the application
+
+using namespace std;
+
+void checkError(bool returnValue, const MIPComponent &component)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in component: " << component.getComponentName() << std::endl;
+	std::cerr << "Error description: " << component.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+// Creates a single message for each packet, and counts the packets it decoded
+class CountingDecoder : public MIPRTPPacketDecoder
+{
+public:
+	CountingDecoder()											{ m_numDecoded = 0; }
+
+	int getNumberOfDecodedPackets() const									{ return m_numDecoded; }
+private:
+	bool validatePacket(const jrtplib::RTPPacket *, real_t &timestampUnit, real_t)
+	{
+		timestampUnit = 1.0/8000.0;
+		return true;
+	}
+
+	void createNewMessages(const jrtplib::RTPPacket *pRTPPack, std::list<MIPMediaMessage *> &messages, std::list<uint32_t> &timestamps)
+	{
+		messages.push_back(new MIPRawFloatAudioMessage(8000, 1, 1, new float[1], true));
+		timestamps.push_back(pRTPPack->GetTimestamp());
+		m_numDecoded++;
+	}
+
+	int m_numDecoded;
+};
+
+// Feeds one packet for each source to the decoder, and returns the source IDs of
+// the messages that come out
+vector<uint64_t> decodePackets(MIPRTPDecoder &decoder, const MIPComponentChain &chain, int64_t iteration, const vector<uint64_t> &sourceIDs)
+{
+	uint8_t payload[4] = { 0, 0, 0, 0 };
+	vector<uint64_t> decodedIDs;
+
+	checkError(decoder.onIterationStart(chain, iteration), decoder);
+	for (size_t i = 0 ; i < sourceIDs.size() ; i++)
+	{
+		jrtplib::RTPPacket *pPack = new jrtplib::RTPPacket(0, payload, sizeof(payload), (uint16_t)iteration, (uint32_t)iteration*160,
+		                                                   (uint32_t)sourceIDs[i], false, 0, 0, false, 0, 0, 0, 1500);
+		MIPRTPReceiveMessage msg(pPack, 0, 0);
+
+		msg.setSourceID(sourceIDs[i]);
+		checkError(decoder.push(chain, iteration, &msg), decoder);
+	}
+
+	MIPMessage *pMsg = 0;
+
+	checkError(decoder.pull(chain, iteration, &pMsg), decoder);
+	while (pMsg)
+	{
+		decodedIDs.push_back(static_cast<MIPMediaMessage *>(pMsg)->getSourceID());
+		checkError(decoder.pull(chain, iteration, &pMsg), decoder);
+	}
+	return decodedIDs;
+}
+
+bool check(bool condition, const char *description)
+{
+	if (!condition)
+		cerr << "  Failed: " << description << endl;
+	return condition;
+}
+
+bool isFilterEmpty(const MIPSourceFilter &filter)
+{
+	for (uint64_t id = 1 ; id <= 10 ; id++)
+	{
+		if (filter.isIgnored(id))
+			return false;
+	}
+	return true;
+}
+
+int main(void)
+{
+	MIPComponentChain chain("Source filter test");
+	MIPSourceFilter filter, otherFilter;
+	MIPRTPDecoder decoder;
+	CountingDecoder packetDecoder;
+	MIPAudioMixer mixer, otherMixer;
+	vector<uint64_t> sourceIDs = { 5, 6, 7 };
+	vector<uint64_t> decodedIDs;
+	bool ok = true;
+
+	checkError(decoder.init(false), decoder);
+	checkError(decoder.setDefaultPacketDecoder(&packetDecoder), decoder);
+	decoder.setSourceFilter(&filter);
+
+	// An ignored source is dropped by the decoder before it is decoded
+	mixer.setSourceFilter(&filter);
+	mixer.addSourceToIgnore(5);
+	decodedIDs = decodePackets(decoder, chain, 1, sourceIDs);
+	ok &= check(decodedIDs == vector<uint64_t>({ 6, 7 }), "ignored source was passed on by the decoder");
+	ok &= check(packetDecoder.getNumberOfDecodedPackets() == 2, "ignored source was decoded");
+
+	// Sources that the other mixer and the application ignore stay in the filter
+	// when the first mixer clears its list
+	otherMixer.setSourceFilter(&filter);
+	otherMixer.addSourceToIgnore(5);
+	filter.addSourceToIgnore(7);
+	mixer.clearIgnoreList();
+	ok &= check(filter.isIgnored(5) && filter.isIgnored(7), "clearIgnoreList removed sources of other users");
+	decodedIDs = decodePackets(decoder, chain, 2, sourceIDs);
+	ok &= check(decodedIDs == vector<uint64_t>({ 6 }), "shared sources were not dropped");
+
+	otherMixer.setSourceFilter(0);
+	ok &= check(!filter.isIgnored(5), "setSourceFilter(0) left the mixer's sources in the filter");
+	filter.removeSourceToIgnore(7);
+	ok &= check(isFilterEmpty(filter), "filter is not empty after all users removed their sources");
+	decodedIDs = decodePackets(decoder, chain, 3, sourceIDs);
+	ok &= check(decodedIDs == sourceIDs, "sources are still dropped after the filter was emptied");
+
+	// Switching to another filter moves the mixer's ignore list
+	mixer.addSourceToIgnore(6);
+	mixer.addSourceToIgnore(6);
+	mixer.setSourceFilter(&otherFilter);
+	ok &= check(isFilterEmpty(filter), "the previous filter still contains the mixer's sources");
+	ok &= check(otherFilter.isIgnored(6), "the new filter does not contain the mixer's sources");
+	mixer.clearIgnoreList();
+	ok &= check(isFilterEmpty(otherFilter), "filter is not empty after clearIgnoreList");
+
+	// A deleted mixer no longer ignores its sources
+	{
+		MIPAudioMixer tempMixer;
+
+		tempMixer.setSourceFilter(&filter);
+		tempMixer.addSourceToIgnore(8);
+		ok &= check(filter.isIgnored(8), "the filter does not contain the mixer's sources");
+	}
+	ok &= check(isFilterEmpty(filter), "filter is not empty after the mixer was deleted");
+
+	if (ok)
+		cout << "OK" << endl;
+	else
+		cerr << "The source filter did not behave as expected!" << endl;
+	return ok ? 0 : -1;
+}
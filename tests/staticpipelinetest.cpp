@@ -0,0 +1,267 @@
+#include "mipconfig.h"
+#include "mipcomponentchain.h"
+#include "mipcomponent.h"
+#include "mipstaticpipeline.h"
+#include "mipaveragetimer.h"
+#include "mipfrequencygenerator.h"
+#include "mipsampleencoder.h"
+#include "miprawaudiomessage.h"
+#include "mipclock.h"
+#include "miptime.h"
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+
+void checkError(bool returnValue, const MIPComponentChain &chain)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in chain: " << chain.getName() << std::endl;
+	std::cerr << "Error description: " << chain.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+void checkError(bool returnValue, const MIPComponent &component)
+{
+	if (returnValue == true)
+		return;
+
+	std::cerr << "An error occured in component: " << component.getComponentName() << std::endl;
+	std::cerr << "Error description: " << component.getErrorString() << std::endl;
+
+	exit(-1);
+}
+
+class MyChain : public MIPComponentChain
+{
+public:
+	MyChain(const std::string &chainName) : MIPComponentChain(chainName)
+	{
+		m_exited = false;
+	}
+
+	bool exited() const
+	{
+		return m_exited;
+	}
+private:
+	void onThreadExit(bool, const std::string &errorComponent, const std::string &errorDescription)
+	{
+		if (errorComponent != "Checker")
+			std::cerr << "  Unexpected error in " << errorComponent << ": " << errorDescription << std::endl;
+		m_exited = true;
+	}
+
+	atomic_bool m_exited;
+};
+
+// Passes on the messages pushed into it in an iteration, in the same order, and
+// counts them. Depending on the constructor argument, the messages can be
+// retrieved at once using pullBatch.
+class Relay : public MIPComponent
+{
+public:
+	Relay(bool batch) : MIPComponent("Relay"), m_batch(batch)
+	{
+		m_prevIteration = -1;
+		m_pos = 0;
+		m_numPushed = 0;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *pMsg)
+	{
+		checkIteration(iteration);
+		m_messages.push_back(pMsg);
+		m_numPushed++;
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t iteration, MIPMessage **pMsg)
+	{
+		checkIteration(iteration);
+		if (m_pos < m_messages.size())
+			*pMsg = m_messages[m_pos++];
+		else
+		{
+			*pMsg = 0;
+			m_pos = 0;
+		}
+		return true;
+	}
+
+	bool supportsPullBatch() const
+	{
+		return m_batch;
+	}
+
+	bool pullBatch(const MIPComponentChain &, int64_t iteration, MIPMessage * const *&pMessages, size_t &numMessages)
+	{
+		checkIteration(iteration);
+		pMessages = m_messages.data();
+		numMessages = m_messages.size();
+		return true;
+	}
+
+	int getNumberOfPushedMessages() const
+	{
+		return m_numPushed;
+	}
+private:
+	void checkIteration(int64_t iteration)
+	{
+		if (iteration == m_prevIteration)
+			return;
+		m_prevIteration = iteration;
+		m_messages.clear();
+		m_pos = 0;
+	}
+
+	bool m_batch;
+	int64_t m_prevIteration;
+	vector<MIPMessage *> m_messages;
+	size_t m_pos;
+	int m_numPushed;
+};
+
+// Checks that it receives a single message with 16 bit samples in each iteration, and
+// stops the chain after a number of iterations
+class Checker : public MIPComponent
+{
+public:
+	Checker(int numIterations) : MIPComponent("Checker"), m_numIterations(numIterations)
+	{
+		m_numMessages = 0;
+		m_numBad = 0;
+	}
+
+	bool push(const MIPComponentChain &, int64_t iteration, MIPMessage *pMsg)
+	{
+		if (pMsg->getMessageType() != MIPMESSAGE_TYPE_AUDIO_RAW || pMsg->getMessageSubtype() != MIPRAWAUDIOMESSAGE_TYPE_S16)
+			m_numBad++;
+		m_numMessages++;
+		if (iteration == m_numIterations)
+		{
+			setErrorString("Requested number of iterations reached");
+			return false;
+		}
+		return true;
+	}
+
+	bool pull(const MIPComponentChain &, int64_t, MIPMessage **)
+	{
+		setErrorString("Pull not supported");
+		return false;
+	}
+
+	bool isOK() const
+	{
+		return m_numMessages == m_numIterations && m_numBad == 0;
+	}
+private:
+	int m_numIterations;
+	int m_numMessages, m_numBad;
+};
+
+typedef MIPStaticPipeline<Relay, Relay, Relay> RelayPipeline;
+
+vector<MIPMessage *> pullAll(RelayPipeline &pipeline, const MIPComponentChain &chain, int64_t iteration)
+{
+	vector<MIPMessage *> messages;
+	MIPMessage *pMsg = 0;
+
+	do
+	{
+		checkError(pipeline.pull(chain, iteration, &pMsg), pipeline);
+		if (pMsg)
+			messages.push_back(pMsg);
+	} while (pMsg);
+	return messages;
+}
+
+// Messages which are pushed into the pipeline after it has been pulled from must
+// still be passed through all stages, exactly once
+bool testLatePush()
+{
+	MIPComponentChain chain("Static pipeline test");
+	Relay stage1(false), stage2(true), stage3(false);
+	RelayPipeline pipeline("Pipeline", &stage1, &stage2, &stage3);
+	float frames[3] = { 0, 0, 0 };
+	MIPRawFloatAudioMessage msg1(8000, 1, 1, frames, false);
+	MIPRawFloatAudioMessage msg2(8000, 1, 1, frames+1, false);
+	MIPRawFloatAudioMessage msg3(8000, 1, 1, frames+2, false);
+	bool ok = true;
+
+	checkError(pipeline.onIterationStart(chain, 1), pipeline);
+	checkError(pipeline.push(chain, 1, &msg1), pipeline);
+	if (pullAll(pipeline, chain, 1) != vector<MIPMessage *>{ &msg1 })
+		ok = false;
+	checkError(pipeline.push(chain, 1, &msg2), pipeline);
+	if (pullAll(pipeline, chain, 1) != vector<MIPMessage *>{ &msg1, &msg2 })
+		ok = false;
+	checkError(pipeline.onIterationEnd(chain, 1), pipeline);
+
+	checkError(pipeline.onIterationStart(chain, 2), pipeline);
+	checkError(pipeline.push(chain, 2, &msg3), pipeline);
+	checkError(pipeline.onIterationEnd(chain, 2), pipeline);
+	if (pullAll(pipeline, chain, 2) != vector<MIPMessage *>{ &msg3 })
+		ok = false;
+
+	cout << "  Messages received by the last stage: " << stage3.getNumberOfPushedMessages() << ", expected 3" << endl;
+	if (stage3.getNumberOfPushedMessages() != 3)
+		ok = false;
+	return ok;
+}
+
+// Runs a pipeline with an actual EMIPLIB component in a chain
+bool testChain()
+{
+	MyChain chain("Static pipeline chain test");
+	MIPVirtualClock clock;
+	MIPTime interval(0.020);
+	MIPAverageTimer timer(interval);
+	MIPFrequencyGenerator generator;
+	MIPSampleEncoder encoder;
+	Relay relay(false);
+	MIPStaticPipeline<MIPSampleEncoder, Relay> pipeline("Pipeline", &encoder, &relay);
+	Checker checker(50);
+
+	checkError(generator.init(440, 440, 0.5, 0.5, 8000, interval), generator);
+	checkError(encoder.init(MIPRAWAUDIOMESSAGE_TYPE_S16), encoder);
+
+	checkError(chain.setClock(&clock), chain);
+	checkError(chain.setChainStart(&timer), chain);
+	checkError(chain.addConnection(&timer, &generator), chain);
+	checkError(chain.addConnection(&generator, &pipeline), chain);
+	checkError(chain.addConnection(&pipeline, &checker), chain);
+
+	checkError(chain.start(), chain);
+	while (!chain.exited())
+		MIPTime::wait(MIPTime(0.001));
+	chain.stop();
+
+	return checker.isOK();
+}
+
+int main(void)
+{
+	int status = 0;
+
+	if (!testLatePush())
+	{
+		cerr << "Late push: wrong messages!" << endl;
+		status = -1;
+	}
+	if (!testChain())
+	{
+		cerr << "Chain: wrong messages!" << endl;
+		status = -1;
+	}
+	if (status == 0)
+		cout << "OK" << endl;
+	return status;
+}